@@ -0,0 +1,141 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+/// Measures the effect of the different flush policies on a workload of
+/// many small commands: transfers of block distributed vectors to all
+/// devices and multi pass Scans.
+///
+
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <pvsutil/CLArgParser.h>
+#include <pvsutil/Logger.h>
+#include <pvsutil/Timer.h>
+
+#include <SkelCL/SkelCL.h>
+#include <SkelCL/Distributions.h>
+#include <SkelCL/Map.h>
+#include <SkelCL/Scan.h>
+#include <SkelCL/Vector.h>
+
+using namespace skelcl;
+
+typedef detail::Device::FlushPolicy FlushPolicy;
+
+pvsutil::Timer::time_type run(int size, int iterations)
+{
+  Map<float(float)> negate("float func(float x){ return -x; }");
+  Scan<float(float)> prefixSum("float func(float x, float y){ return x+y; }",
+                               "0");
+
+  std::vector<float> data(size);
+  std::iota(data.begin(), data.end(), 0.0f);
+
+  pvsutil::Timer timer;
+  for (int i = 0; i < iterations; ++i) {
+    Vector<float> input(data.begin(), data.end());
+    distribution::setBlock(input);
+    Vector<float> negated = negate(input);
+
+    Vector<float> single(data.begin(), data.end());
+    Vector<float> sums = prefixSum(single);
+
+    // accessing the results on the host waits for the devices
+    negated.copyDataToHost();
+    sums.copyDataToHost();
+  }
+  return timer.stop();
+}
+
+int main(int argc, char** argv)
+{
+  using namespace pvsutil::cmdline;
+  pvsutil::CLArgParser cmd(Description("Benchmark of the flush policies."));
+
+  auto deviceCount = Arg<int>(Flags(Long("device_count")),
+                              Description("Number of devices used by SkelCL."),
+                              Default(2));
+
+  auto deviceType = Arg<device_type>(Flags(Long("device_type")),
+                                     Description("Device type: ANY, CPU, "
+                                                 "GPU, ACCELERATOR"),
+                                     Default(device_type::ANY));
+
+  auto enableLogging = Arg<bool>(Flags(Short('l'), Long("logging"),
+                                       Long("verbose_logging")),
+                                 Description("Enable verbose logging."),
+                                 Default(false));
+
+  auto size = Arg<int>(Flags(Short('n'), Long("size")),
+                       Description("Size of the vectors used in "
+                                   "the computation."),
+                       Default(64 * 1024));
+
+  auto iterations = Arg<int>(Flags(Short('i'), Long("iterations")),
+                             Description("Number of iterations per policy."),
+                             Default(100));
+
+  cmd.add(&deviceCount, &deviceType, &enableLogging, &size, &iterations);
+  cmd.parse(argc, argv);
+
+  if (enableLogging) {
+    pvsutil::defaultLogger.setLoggingLevel(
+        pvsutil::Logger::Severity::DebugInfo);
+  }
+
+  skelcl::init(skelcl::nDevices(deviceCount).deviceType(deviceType));
+
+  // build the programs up front, so that only the execution is measured
+  run(size, 1);
+
+  std::vector<std::pair<std::string, FlushPolicy>> policies = {
+    { "immediate", FlushPolicy::immediate() },
+    { "threshold 8", FlushPolicy::threshold(8) },
+    { "threshold 1 MB", FlushPolicy::threshold(0, 1024 * 1024) },
+    { "on wait", FlushPolicy::onWait() }
+  };
+
+  for (auto& policy : policies) {
+    skelcl::setFlushPolicy(policy.second);
+    auto time = run(size, iterations);
+    LOG_INFO("Flush policy ", policy.first, ": ", time, " ms");
+  }
+
+  skelcl::terminate();
+  return 0;
+}
@@ -229,9 +229,9 @@ private:
   void execute(Matrix<Tout>& output, const Matrix<Tleft>& left,
                const Matrix<Tright>& right, Args&&... args);
 
-  detail::Program createAndBuildProgramSpecial() const;
+  detail::Program::ptr_type createAndBuildProgramSpecial() const;
 
-  detail::Program createAndBuildProgramGeneral() const;
+  detail::Program::ptr_type createAndBuildProgramGeneral() const;
 
   void prepareInput(const Matrix<Tleft>& left, const Matrix<Tright>& right);
 
@@ -253,7 +253,7 @@ private:
   unsigned int _C;
   unsigned int _R;
   unsigned int _S;
-  detail::Program _program;
+  detail::Program::ptr_type _program;
 };
 
 } // namespace skelcl
@@ -117,6 +117,55 @@ void setBlock( const C<T>& c)
         new skelcl::detail::BlockDistribution<C<T>>() ) );
 }
 
+/// 
+/// \brief  Factory function to create an adaptive BlockDistribution with the
+///         types of the given container. The skeletons adapt the sizes of
+///         the blocks to the measured execution times of their kernels on
+///         the devices, if this is enabled with useAdaptiveBlocks() (see
+///         detail::LoadBalancer). Otherwise the data is split evenly.
+///
+/// \tparam C Incomplete type of the container for which the distribution is
+///           created. The complete type is C<T>. C can be Vector or Matrix.
+/// \tparam T Type of the elements of the container for which the distribution
+///           is created.
+///
+/// \param c  Container for which the distribution is created. This argument is
+///           used to deduct the types needed to create the distribution which
+///           gets returned.
+///
+/// \return A pointer to a newly created adaptive BlockDistribution with the
+///         types of the given container.
+/// 
+template <template <typename> class C, typename T>
+std::unique_ptr<skelcl::detail::Distribution<C<T>>>
+    AdaptiveBlock( const C<T>& c )
+{
+  (void)c;
+  return std::unique_ptr<skelcl::detail::Distribution<C<T>>>(
+            new skelcl::detail::BlockDistribution<C<T>>(
+              detail::globalDeviceList,
+              detail::Significances(detail::globalDeviceList.size()),
+              true ) );
+}
+
+/// 
+/// \brief  This function sets the distribution of the given container to an
+///         adaptive BlockDistribution.
+///
+/// \tparam C Incomplete type of the container for which the distribution is
+///           set. The complete type is C<T>. C can be Vector or Matrix.
+/// \tparam T Type of the elements of the container for which the distribution
+///           is set.
+///
+/// \param c  Container for which the distribution is set to an adaptive
+///           BlockDistribution using the setDistribution function.
+/// 
+template <template <typename> class C, typename T>
+void setAdaptiveBlock( const C<T>& c)
+{
+  c.setDistribution( AdaptiveBlock(c) );
+}
+
 
 /// \brief  Factory function to create an OverlapDistribution with the types of
 ///         the given container.
@@ -218,6 +267,72 @@ void setCopy( const C<T>& c,
           detail::globalDeviceList, combineFunc ) ) );
 }
 
+/// 
+/// \brief  Factory function to create a CopyDistribution with the types of the
+///         given container, whose copies are combined on the devices.
+///
+/// \tparam C Incomplete type of the container for which the distribution is
+///           created. The complete type is C<T>. C can be Vector or Matrix.
+/// \tparam T Type of the elements of the container for which the distribution
+///           is created.
+///
+/// \param c  Container for which the distribution is created. This argument is
+///           used to deduct the types needed to create the distribution which
+///           gets returned.
+///
+/// \param combineSource OpenCL source code of a binary function explaining how
+///                      two elements of the container should be combined if
+///                      two devices modify the data of a copy distributed
+///                      container simultaneously. The copies are combined
+///                      pairwise on the devices and only the result is
+///                      downloaded.
+///
+/// \param funcName Name of the combine function in combineSource.
+///
+/// \return A pointer to a newly created CopyDistribution with the types of the
+///         given container.
+/// 
+template <template <typename> class C, typename T>
+std::unique_ptr<skelcl::detail::Distribution<C<T>>>
+    Copy( const C<T>& c,
+          const Source& combineSource,
+          const std::string& funcName = std::string("func") )
+{
+  (void)c;
+  return std::unique_ptr<skelcl::detail::Distribution<C<T>>>(
+        new skelcl::detail::CopyDistribution<C<T>>(
+                          detail::globalDeviceList, combineSource, funcName ) );
+}
+
+/// 
+/// \brief  This function sets the distribution of the given container to the
+///         CopyDistribution, whose copies are combined on the devices.
+///
+/// \tparam C Incomplete type of the container for which the distribution is
+///           set. The complete type is C<T>. C can be Vector or Matrix.
+/// \tparam T Type of the elements of the container for which the distribution
+///           is set.
+///
+/// \param c  Container for which the distribution is set to CopyDistribution
+///           using the setDistribution function.
+///
+/// \param combineSource OpenCL source code of a binary function explaining how
+///                      two elements of the container should be combined if
+///                      two devices modify the data of a copy distributed
+///                      container simultaneously. The copies are combined
+///                      pairwise on the devices and only the result is
+///                      downloaded.
+///
+/// \param funcName Name of the combine function in combineSource.
+/// 
+template <template <typename> class C, typename T>
+void setCopy( const C<T>& c,
+              const Source& combineSource,
+              const std::string& funcName = std::string("func") )
+{
+  c.setDistribution( Copy(c, combineSource, funcName) );
+}
+
 /// 
 /// \brief  Factory function to create a SingleDistribution with the types of
 ///         the given container and for the default device.
@@ -0,0 +1,242 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file HostView.h
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#ifndef HOST_VIEW_H_
+#define HOST_VIEW_H_
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+#include <pvsutil/Assert.h>
+
+namespace skelcl {
+
+template <typename> class Matrix;
+template <typename> class Vector;
+
+///
+/// \brief Specifies how the elements of a HostView are accessed
+///
+enum class HostAccess {
+  READ_ONLY,  ///< The elements are only read on the host
+  READ_WRITE  ///< The elements are read and modified on the host
+};
+
+///
+/// \brief A HostView gives the host direct access to a range of elements of a
+///        Vector or Matrix.
+///
+/// If the most recent elements are stored on a device the range is mapped into
+/// the host address space, so that only the accessed elements are transferred.
+/// Where the runtime supports it (e.g. on CPU devices) no data is copied at
+/// all. When the view is destroyed (or release() is called) the range is
+/// unmapped and the container is informed about the modifications made on the
+/// host.
+///
+/// While a view is alive the container must not be used by a skeleton or be
+/// modified otherwise.
+///
+/// Views are created by Vector::hostView and Matrix::hostView.
+///
+template <typename T>
+class HostView {
+public:
+  typedef T           value_type;
+  typedef T*          pointer;
+  typedef T&          reference;
+  typedef T*          iterator;
+  typedef const T*    const_iterator;
+  typedef size_t      size_type;
+
+  ///
+  /// \brief Move constructor. rhs does not refer to any elements afterwards.
+  ///
+  HostView(HostView<T>&& rhs);
+
+  ///
+  /// \brief Move assignment. The range previously viewed is released.
+  ///
+  HostView<T>& operator=(HostView<T>&& rhs);
+
+  ///
+  /// \brief Releases the viewed range
+  ///
+  ~HostView();
+
+  ///
+  /// \brief Returns an iterator to the first element of the view
+  ///
+  iterator begin() const;
+
+  ///
+  /// \brief Returns an iterator past the last element of the view
+  ///
+  iterator end() const;
+
+  ///
+  /// \brief Returns the number of elements in the view
+  ///
+  size_type size() const;
+
+  ///
+  /// \brief Returns true if the view does not contain any elements
+  ///
+  bool empty() const;
+
+  ///
+  /// \brief Returns the element at position n of the view
+  ///
+  reference operator[](size_type n) const;
+
+  ///
+  /// \brief Returns a pointer to the first element of the view
+  ///
+  pointer data() const;
+
+  ///
+  /// \brief Releases the viewed range before the view is destroyed.
+  ///
+  /// Afterwards the view does not contain any elements.
+  ///
+  void release();
+
+private:
+  HostView(pointer data, size_type size, std::function<void()> release);
+
+  HostView(const HostView<T>&) = delete;
+
+  HostView<T>& operator=(const HostView<T>&) = delete;
+
+  friend class Matrix<T>;
+  friend class Vector<T>;
+
+  pointer               _data;
+  size_type             _size;
+  std::function<void()> _release;
+};
+
+template <typename T>
+HostView<T>::HostView(pointer data, size_type size,
+                      std::function<void()> release)
+  : _data(data), _size(size), _release(std::move(release))
+{
+}
+
+template <typename T>
+HostView<T>::HostView(HostView<T>&& rhs)
+  : _data(rhs._data), _size(rhs._size), _release(std::move(rhs._release))
+{
+  rhs._data     = nullptr;
+  rhs._size     = 0;
+  rhs._release  = nullptr;
+}
+
+template <typename T>
+HostView<T>& HostView<T>::operator=(HostView<T>&& rhs)
+{
+  if (this == &rhs) return *this;
+  release();
+  _data         = rhs._data;
+  _size         = rhs._size;
+  _release      = std::move(rhs._release);
+  rhs._data     = nullptr;
+  rhs._size     = 0;
+  rhs._release  = nullptr;
+  return *this;
+}
+
+template <typename T>
+HostView<T>::~HostView()
+{
+  release();
+}
+
+template <typename T>
+typename HostView<T>::iterator HostView<T>::begin() const
+{
+  return _data;
+}
+
+template <typename T>
+typename HostView<T>::iterator HostView<T>::end() const
+{
+  return _data + _size;
+}
+
+template <typename T>
+typename HostView<T>::size_type HostView<T>::size() const
+{
+  return _size;
+}
+
+template <typename T>
+bool HostView<T>::empty() const
+{
+  return _size == 0;
+}
+
+template <typename T>
+typename HostView<T>::reference HostView<T>::operator[](size_type n) const
+{
+  ASSERT(n < _size);
+  return _data[n];
+}
+
+template <typename T>
+typename HostView<T>::pointer HostView<T>::data() const
+{
+  return _data;
+}
+
+template <typename T>
+void HostView<T>::release()
+{
+  if (_release) {
+    auto release = std::move(_release);
+    _release = nullptr;
+    release();
+  }
+  _data = nullptr;
+  _size = 0;
+}
+
+} // namespace skelcl
+
+#endif // HOST_VIEW_H_
@@ -206,8 +206,9 @@ private:
                const C<Tin>& input,
                Args&&... args) const;
 
-  detail::Program createAndBuildProgram(const std::string& source,
-                                        const std::string& funcName) const;
+  detail::Program::ptr_type
+    createAndBuildProgram(const std::string& source,
+                          const std::string& funcName) const;
 };
 
 /// 
@@ -281,8 +282,9 @@ private:
   void execute(const C<Tin>& input,
                Args&&... args) const;
 
-  detail::Program createAndBuildProgram(const std::string& source,
-                                        const std::string& funcName) const;
+  detail::Program::ptr_type
+    createAndBuildProgram(const std::string& source,
+                          const std::string& funcName) const;
 };
 
 /// 
@@ -388,8 +390,9 @@ private:
                const Vector<Index>& input,
                Args&&... args) const;
   
-  detail::Program createAndBuildProgram(const std::string& source,
-                                        const std::string& funcName) const;
+  detail::Program::ptr_type
+    createAndBuildProgram(const std::string& source,
+                          const std::string& funcName) const;
 };
 
 /// 
@@ -458,8 +461,9 @@ private:
   void execute(const Vector<Index>& input,
                Args&&... args) const;
 
-  detail::Program createAndBuildProgram(const std::string& source,
-                                        const std::string& funcName) const;
+  detail::Program::ptr_type
+    createAndBuildProgram(const std::string& source,
+                          const std::string& funcName) const;
 };
 
 /// 
@@ -565,8 +569,9 @@ private:
                const Matrix<IndexPoint>& input,
                Args&&... args) const;
   
-  detail::Program createAndBuildProgram(const std::string& source,
-                                        const std::string& funcName) const;
+  detail::Program::ptr_type
+    createAndBuildProgram(const std::string& source,
+                          const std::string& funcName) const;
 };
 
 /// 
@@ -635,8 +640,9 @@ private:
   void execute(const Matrix<IndexPoint>& input,
                Args&&... args) const;
   
-  detail::Program createAndBuildProgram(const std::string& source,
-                                        const std::string& funcName) const;
+  detail::Program::ptr_type
+    createAndBuildProgram(const std::string& source,
+                          const std::string& funcName) const;
 };
 
 } // namespace skelcl
@@ -173,7 +173,7 @@ private:
   template <typename... Args>
   void execute(Matrix<Tout>& output, const Matrix<Tin>& in, Args&&... args);
 
-  detail::Program createAndBuildProgram() const;
+  detail::Program::ptr_type createAndBuildProgram() const;
 
   void prepareInput(const Matrix<Tin>& in);
 
@@ -184,7 +184,7 @@ private:
   unsigned int _overlap_range;
   detail::Padding _padding;
   Tin _neutral_element;
-  detail::Program _program;
+  detail::Program::ptr_type _program;
 };
 
 } //namespace skelcl
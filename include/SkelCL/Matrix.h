@@ -51,11 +51,13 @@
 #undef  __CL_ENABLE_EXCEPTIONS
 
 #include "Distributions.h"
+#include "HostView.h"
 
 #include "detail/Device.h"
 #include "detail/DeviceBuffer.h"
 #include "detail/Distribution.h"
 #include "detail/Padding.h"
+#include "detail/PinnedAllocator.h"
 #include "detail/skelclDll.h"
 
 namespace skelcl {
@@ -206,7 +208,16 @@ public:
 template <typename T>
 class Matrix {
 public:
-  typedef std::vector<T> host_buffer_type;
+  ///
+  /// \brief The type used to store the elements on the host. The elements
+  ///        are placed in pinned memory if the globalPinnedMemoryPool is
+  ///        enabled.
+  ///
+  /// This is not std::vector<T>, as it uses a different allocator. Code
+  /// binding the result of hostBuffer() to a reference or passing it on has
+  /// to use this type (or templates) instead of std::vector<T>.
+  ///
+  typedef std::vector<T, detail::PinnedAllocator<T>> host_buffer_type;
   typedef typename host_buffer_type::value_type value_type;
   typedef typename host_buffer_type::pointer pointer;
   typedef typename host_buffer_type::const_pointer const_pointer;
@@ -397,12 +408,29 @@ public:
 
   void copyDataToHost() const;
 
+  ///
+  /// \brief Gives the host direct access to rowCount rows starting at firstRow
+  ///        (see Vector::hostView)
+  ///
+  HostView<T> hostView(HostAccess access, size_type::size_type firstRow,
+                       size_type::size_type rowCount) const;
+
+  ///
+  /// \brief Gives the host direct access to all elements of the matrix
+  ///
+  HostView<T> hostView(HostAccess access = HostAccess::READ_ONLY) const;
+
   void dataOnDeviceModified() const;
 
   void dataOnHostModified() const;
 
   const detail::DeviceBuffer& deviceBuffer(const detail::Device& device)const;
 
+  ///
+  /// \brief Returns the storage of the elements on the host. If zero copy
+  ///        buffers are used (see skelcl::useZeroCopy()), it is only up to
+  ///        date after copyDataToHost().
+  ///
   host_buffer_type& hostBuffer() const;
 
   static std::string deviceFunctions();
@@ -421,6 +449,12 @@ private:
   std::string getInfo() const;
   std::string getDebugInfo() const;
 
+  bool zeroCopyBuffersValid() const;
+
+  void releaseZeroCopyBuffers() const;
+
+  bool redistributeOnDevices(
+          const detail::Distribution<Matrix<T>>& newDistribution) const;
 
   static RegisterMatrixDeviceFunctions<T> registerMatrixDeviceFunctions;
 
@@ -41,11 +41,14 @@
 #define REDUCE_H_
 
 #include <istream>
+#include <map>
 #include <memory>
 #include <string>
 
 #include "Source.h"
 
+#include "detail/Device.h"
+#include "detail/DeviceBuffer.h"
 #include "detail/Program.h"
 #include "detail/Skeleton.h"
 
@@ -188,19 +191,29 @@ private:
   void prepareOutput(Vector<T>& output, const Vector<T>& input,
                      const size_t size);
 
+  static detail::Program::Constants
+    constantsFor(const detail::Device& device, size_t data_size,
+                 size_t global_size);
+
   template <typename... Args>
   void execute_first_step(const detail::Device& device,
                           const detail::DeviceBuffer& input,
                           detail::DeviceBuffer& output, size_t data_size,
-                          size_t global_size, Args&&... args);
+                          size_t global_size,
+                          const detail::Program::Constants& constants,
+                          Args&&... args);
 
   template <typename... Args>
   void execute_second_step(const detail::Device& device,
                            const detail::DeviceBuffer& input,
                            detail::DeviceBuffer& output, size_t data_size,
+                           const detail::Program::Constants& constants,
                            Args&&... args);
 
-  skelcl::detail::Program createPrepareAndBuildProgram();
+  detail::DeviceBuffer& scratchBuffer(const detail::Device::ptr_type& devicePtr,
+                                      size_t size);
+
+  skelcl::detail::Program::ptr_type createPrepareAndBuildProgram();
 
   /// Literal describing the identity of type T in respect to the operation
   /// performed by the reduction and described in function named _funcName
@@ -213,7 +226,10 @@ private:
   std::string _userSource;
 
   /// Program
-  skelcl::detail::Program _program;
+  skelcl::detail::Program::ptr_type _program;
+
+  /// Buffers for the intermediate results per device, reused by later calls
+  std::map<detail::Device::id_type, detail::DeviceBuffer> _scratchBuffers;
 };
 
 } // namespace skelcl
@@ -42,7 +42,10 @@
 
 #include <istream>
 #include <string>
+#include <vector>
 
+#include "detail/Device.h"
+#include "detail/DeviceBuffer.h"
 #include "detail/Skeleton.h"
 #include "detail/Program.h"
 
@@ -157,16 +160,18 @@ private:
   size_t calculateNumberOfPasses(size_t workGroupSize,
                                  size_t elements) const;
 
-  std::vector<detail::DeviceBuffer>
+  const std::vector<detail::DeviceBuffer>&
     createImmediateBuffers(size_t passes,
                            size_t wgSize,
                            size_t elements,
-                           const detail::Device::ptr_type& devicePtr);
+                           const detail::Device::ptr_type& devicePtr,
+                           std::vector<size_t>* sizes);
 
   void performScanPasses(size_t passes,
                          size_t wgSize,
                          const detail::Device::ptr_type& devicePtr,
                          const std::vector<detail::DeviceBuffer>& tmpBuffers,
+                         const std::vector<size_t>& sizes,
                          const detail::DeviceBuffer& inputBuffer,
                          const detail::DeviceBuffer& outputBuffer);
 
@@ -175,6 +180,7 @@ private:
                                  const detail::Device::ptr_type& devicePtr,
                                  const std::vector<detail::DeviceBuffer>&
                                     tmpBuffers,
+                                 const std::vector<size_t>& sizes,
                                  const detail::DeviceBuffer& outputBuffer);
 
   void prepareInput(const Vector<T>& input);
@@ -182,11 +188,15 @@ private:
   void prepareOutput(Vector<T>& output,
                      const Vector<T>& input);
   
-  detail::Program createAndBuildProgram(const std::string& source,
-                                        const std::string& id,
-                                        const std::string& funcName) const;
+  detail::Program::ptr_type
+    createAndBuildProgram(const std::string& source,
+                          const std::string& id,
+                          const std::string& funcName) const;
 
-  const detail::Program _program;
+  const detail::Program::ptr_type _program;
+
+  /// Intermediate buffers of the last calls, reused while large enough
+  std::vector<detail::DeviceBuffer> _tmpBuffers;
 };
 
 } // namespace skelcl
@@ -196,6 +196,82 @@ SKELCL_DLL void init(detail::DeviceProperties properties = allDevices());
 ///
 SKELCL_DLL void init(detail::PlatformID pID, detail::DeviceID dID);
 
+///
+/// \brief Starts building the programs of all skeletons created so far for all
+///        devices in the background and returns immediately.
+///
+/// By default a skeleton builds its OpenCL program lazily for a device when
+/// it is executed on this device for the first time. Calling this function
+/// after creating the skeletons overlaps the compilation with other work,
+/// e.g. loading the input data. Use waitForBuilds() to wait for the builds.
+///
+SKELCL_DLL void startBuilds();
+
+///
+/// \brief Builds the programs of all skeletons created so far for all devices
+///        and blocks until the builds have finished.
+///
+/// By default a skeleton builds its OpenCL program lazily in the background
+/// for a device when it is executed on this device for the first time, so
+/// that programs are only built for the devices actually used. This function
+/// builds the programs for all devices up front instead, where the programs
+/// for different devices are built concurrently.
+///
+SKELCL_DLL void waitForBuilds();
+
+///
+/// \brief Sets the policy when enqueued commands are submitted to the devices
+///        for all devices currently used and all devices used later on.
+///
+/// By default every command is submitted right away. Batching the
+/// submissions reduces the overhead of many small commands, e.g. of multi
+/// pass skeletons or of transfers to multiple devices.
+///
+SKELCL_DLL void setFlushPolicy(const detail::Device::FlushPolicy& policy);
+
+///
+/// \brief Submits all commands enqueued so far to the devices. This can be
+///        used to mark explicit boundaries of a pipeline, if commands are
+///        not submitted right away.
+///
+SKELCL_DLL void flush();
+
+///
+/// \brief Stores the host data of large containers created afterwards in
+///        pinned (page-locked) memory, which speeds up transfers to and from
+///        the devices.
+///
+/// Pinned memory is only used after init() has been called. It can also be
+/// enabled by setting the environment variable SKELCL_PINNED to YES.
+///
+SKELCL_DLL void usePinnedMemory(bool enable = true);
+
+///
+/// \brief Lets the buffers on CPU devices use the host memory of the
+///        containers as their storage, instead of copying the data.
+///
+/// This has to be called prior to init(). It can also be enabled by setting
+/// the environment variable SKELCL_ZERO_COPY to YES.
+///
+/// While zero copy is enabled, the host buffer of a container is shared with
+/// the CPU devices. It may only be accessed through the container (e.g. its
+/// iterators, operator[] or hostView()), which synchronizes it with the
+/// devices first. Writing to the memory returned by hostBuffer() after the
+/// data has been copied to the devices, without calling copyDataToHost()
+/// before, is undefined.
+///
+SKELCL_DLL void useZeroCopy(bool enable = true);
+
+///
+/// \brief Lets the skeletons adapt the sizes of the blocks of adaptive block
+///        distributions to the measured execution times of their kernels.
+///
+/// This has to be called prior to init(), as the kernels are only measured
+/// if the command queues are created with profiling enabled. It can also be
+/// enabled by setting the environment variable SKELCL_ADAPTIVE_BLOCK to YES.
+///
+SKELCL_DLL void useAdaptiveBlocks(bool enable = true);
+
 ///
 /// \brief Frees all resources allocated internally by SkelCL.
 ///
@@ -204,6 +280,14 @@ SKELCL_DLL void init(detail::PlatformID pID, detail::DeviceID dID);
 /// after a first initialization, this function has to be called prior to
 /// calling one of the init() functions again.
 ///
+/// If the environment variable SKELCL_BUILD_TIMINGS is set to YES, a summary
+/// of the time spent creating and building the programs of all skeletons is
+/// logged.
+///
+/// If the environment variable SKELCL_PROFILE is set, the kernels and
+/// transfers executed on all devices are written as a Chrome trace to the
+/// file named by the variable (or skelcl_trace.json if it is set to YES).
+///
 SKELCL_DLL void terminate();
 
 } // namespace skelcl
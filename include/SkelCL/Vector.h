@@ -49,10 +49,13 @@
 #include <CL/cl.hpp>
 #undef  __CL_ENABLE_EXCEPTIONS
 
+#include "HostView.h"
+
 #include "detail/CopyDistribution.h"
 #include "detail/Device.h"
 #include "detail/DeviceBuffer.h"
 #include "detail/Distribution.h"
+#include "detail/PinnedAllocator.h"
 
 namespace skelcl {
 
@@ -114,9 +117,15 @@ public:
 template <typename T>
 class Vector {
 public:
-  /// \brief The type used to store the elements on the host
+  /// \brief The type used to store the elements on the host. The elements
+  ///        are placed in pinned memory if the globalPinnedMemoryPool is
+  ///        enabled.
+  ///
+  /// This is not std::vector<T>, as it uses a different allocator. Code
+  /// binding the result of hostBuffer() to a reference or passing it on has
+  /// to use this type (or templates) instead of std::vector<T>.
   ///
-  typedef std::vector<T> host_buffer_type;
+  typedef std::vector<T, detail::PinnedAllocator<T>> host_buffer_type;
   /// \brief The type of the elements
   ///
   typedef typename host_buffer_type::value_type value_type;
@@ -655,6 +664,33 @@ public:
   /// \b Complexity Linear in the size of the vector.
   void copyDataToHost() const;
 
+  /// \brief Gives the host direct access to a range of elements of the vector
+  ///
+  /// If the most recent elements are stored on a single device the range is
+  /// mapped from the device, otherwise the whole vector is copied to the host
+  /// first (see copyDataToHost()). Reading only a few elements of a large
+  /// vector computed on a device therefore avoids transferring the entire
+  /// vector. When the returned view is destroyed modifications made with
+  /// HostAccess::READ_WRITE are marked (see dataOnHostModified() and
+  /// dataOnDeviceModified()).
+  ///
+  /// The vector must not be used otherwise while the view is alive.
+  ///
+  /// \b Complexity Linear in count.
+  /// \param access Specifies if the elements are modified using the view
+  /// \param first  Position of the first element of the range
+  /// \param count  Number of elements in the range
+  /// \return A view of the range which is released on its destruction
+  HostView<T> hostView(HostAccess access, size_type first,
+                       size_type count) const;
+
+  /// \brief Gives the host direct access to all elements of the vector
+  ///
+  /// \b Complexity Linear in the size of the vector.
+  /// \param access Specifies if the elements are modified using the view
+  /// \return A view of the vector which is released on its destruction
+  HostView<T> hostView(HostAccess access = HostAccess::READ_ONLY) const;
+
   /// \brief Marks the data on the device as been modified
   ///
   /// \b Complexity Constant
@@ -708,6 +744,9 @@ public:
   /// \brief Returns a reference to the underlying object storing the elements
   ///        on the host
   ///
+  /// If zero copy buffers are used (see skelcl::useZeroCopy()), the host
+  /// buffer is only up to date after copyDataToHost().
+  ///
   /// \b Complexity Constant
   /// \return A reference to the underlying object storing the elements on the
   ///         host
@@ -725,6 +764,13 @@ private:
 
   std::string getDebugInfo() const;
 
+  bool zeroCopyBuffersValid() const;
+
+  void releaseZeroCopyBuffers() const;
+
+  bool redistributeOnDevices(
+          const detail::Distribution<Vector<T>>& newDistribution) const;
+
   static RegisterVectorDeviceFunctions<T> registerVectorDeviceFunctions;
 
           size_type                                   _size;
@@ -235,12 +235,13 @@ private:
                      const C<Tleft>& left,
                      const C<Tright>& right);
   
-  detail::Program createAndBuildProgram(const std::string& source,
-                                        const std::string& funcName) const;
+  detail::Program::ptr_type
+    createAndBuildProgram(const std::string& source,
+                          const std::string& funcName) const;
 
   const std::string     _source;
   const std::string     _funcName;
-  const detail::Program _program;
+  const detail::Program::ptr_type _program;
 };
 
 ///
@@ -340,10 +341,11 @@ private:
   void prepareInput(const C<Tleft>& left,
                     const C<Tright>& right);
 
-  detail::Program createAndBuildProgram(const std::string& source,
-                                        const std::string& funcName) const;
+  detail::Program::ptr_type
+    createAndBuildProgram(const std::string& source,
+                          const std::string& funcName) const;
 
-  const detail::Program _program;
+  const detail::Program::ptr_type _program;
 };
 
 // TODO: when template aliases are available:
@@ -69,6 +69,7 @@
 #include "Device.h"
 #include "KernelUtil.h"
 #include "Program.h"
+#include "ProgramRegistry.h"
 #include "Skeleton.h"
 #include "Util.h"
 
@@ -175,7 +176,10 @@ void AllPairs<Tout(Tleft, Tright)>::execute(Matrix<Tout>& output,
                   " global: ", global[0],",",global[1]);
 
         try {
-            cl::Kernel kernel(_program.kernel(*devicePtr, "SCL_ALLPAIRS"));
+            auto kernel = _program->kernel(*devicePtr, "SCL_ALLPAIRS",
+                                { {"SCL_ALLPAIRS_DIMENSION", dimension},
+                                  {"SCL_ALLPAIRS_HEIGHT", elements[0]},
+                                  {"SCL_ALLPAIRS_WIDTH", elements[1]} });
 
             kernel.setArg(0, leftBuffer.clBuffer());
             kernel.setArg(1, rightBuffer.clBuffer());
@@ -195,12 +199,9 @@ void AllPairs<Tout(Tleft, Tright)>::execute(Matrix<Tout>& output,
                                                            outputBuffer.clBuffer(),
                                                            std::forward<Args>(args)...);
 
-            // after finishing the kernel invoke this function ...
-            auto invokeAfter =  [=] () { (void)keepAlive; };
-
             devicePtr->enqueue(kernel, cl::NDRange(global[0], global[1]), cl::NDRange(local[0], local[1]),
                                cl::NullRange, // offset
-                               invokeAfter);
+                               keepAlive);
 
         } catch (cl::Error& err) {
             ABORT_WITH_ERROR(err);
@@ -210,77 +211,91 @@ void AllPairs<Tout(Tleft, Tright)>::execute(Matrix<Tout>& output,
 }
 
 template<typename Tleft, typename Tright, typename Tout>
-detail::Program AllPairs<Tout(Tleft, Tright)>::createAndBuildProgramSpecial() const
+detail::Program::ptr_type AllPairs<Tout(Tleft, Tright)>::createAndBuildProgramSpecial() const
 {
     ASSERT_MESSAGE( !_srcReduce.empty(),
                     "Tried to create program with empty user reduce source." );
     ASSERT_MESSAGE( !_srcZip.empty(),
                     "Tried to create program with empty user zip source." );
 
-    // _srcReduce: replace func by TMP_REDUCE
-    stooling::SourceCode rSource(_srcReduce);
-    rSource.renameFunction(_funcReduce, "TMP_REDUCE");
-
-    // _srcZip: replace func by TMP_ZIP
-    stooling::SourceCode zSource(_srcZip);
-    zSource.renameFunction(_funcReduce, "TMP_ZIP");
-
-    // create program
-    std::string s(Matrix<Tout>::deviceFunctions());
-
-    // identity
-    s.append("#define SCL_IDENTITY ").append(_idReduce);
-
-    s.append("\n");
-
-    // reduce user source
-    s.append(rSource.code());
-
-    s.append("\n");
-
-    // zip user source
-    s.append(zSource.code());
-
-    s.append("\n");
-
-    // allpairs parameters
-    s.append("#define C ").append(std::to_string(_C)).append("\n");
-    s.append("#define R ").append(std::to_string(_R)).append("\n");
-    s.append("#define S ").append(std::to_string(_S)).append("\n");
-    s.append("#define D 32");
-
-    // allpairs skeleton source
-    s.append(
-      #include "AllPairsKernel.cl"
-    );
-
-    auto program = detail::Program(s, detail::util::hash("//AllPairs\n"
-                                                         + Matrix<Tout>::deviceFunctions()
-                                                         + _idReduce
-                                                         + rSource.code()
-                                                         + zSource.code()));
-    // modify program
-    if (!program.loadBinary()) {
-        // problem: reduce parameter a und zip parameter a
-        program.transferParameters("TMP_REDUCE", 2, "SCL_ALLPAIRS"); 
-        program.transferArguments("TMP_REDUCE", 2, "USR_REDUCE");
-        // TODO: Order? first args from reduce than zip??
-        program.transferParameters("TMP_ZIP", 2, "SCL_ALLPAIRS");
-        program.transferArguments("TMP_ZIP", 2, "USR_ZIP");
-
-        program.renameFunction("TMP_REDUCE", "USR_REDUCE");
-        program.renameFunction("TMP_ZIP", "USR_ZIP");
-
-        program.adjustTypes<Tleft, Tright, Tout>();
-    }
+    auto hash = detail::util::hash("//AllPairs\n"
+                                   + Matrix<Tout>::deviceFunctions()
+                                   + _idReduce
+                                   + _srcReduce + _funcReduce
+                                   + _srcZip + _funcZip
+                                   + std::to_string(_C) + std::to_string(_R)
+                                   + std::to_string(_S)
+                                   + detail::util::typeNames<Tleft, Tright, Tout>());
+
+    // renaming the user functions requires the clang front end, therefore, the
+    // source is only assembled if neither a binary nor the rewritten source
+    // is cached
+    auto createSource = [&] {
+        // _srcReduce: replace func by TMP_REDUCE
+        stooling::SourceCode rSource(_srcReduce);
+        rSource.renameFunction(_funcReduce, "TMP_REDUCE");
+
+        // _srcZip: replace func by TMP_ZIP
+        stooling::SourceCode zSource(_srcZip);
+        zSource.renameFunction(_funcZip, "TMP_ZIP");
+
+        // create program
+        std::string s(Matrix<Tout>::deviceFunctions());
+
+        // identity
+        s.append("#define SCL_IDENTITY ").append(_idReduce);
+
+        s.append("\n");
+
+        // reduce user source
+        s.append(rSource.code());
+
+        s.append("\n");
+
+        // zip user source
+        s.append(zSource.code());
+
+        s.append("\n");
+
+        // allpairs parameters
+        s.append("#define C ").append(std::to_string(_C)).append("\n");
+        s.append("#define R ").append(std::to_string(_R)).append("\n");
+        s.append("#define S ").append(std::to_string(_S)).append("\n");
+        s.append("#define D 32");
+
+        // allpairs skeleton source
+        s.append(
+          #include "AllPairsKernel.cl"
+        );
+        return s;
+    };
+
+    return detail::globalProgramRegistry.lookupOrCreate(hash, [&] {
+        auto program = detail::Program(std::string(), hash);
+        // modify program
+        if (!program.loadBinary() && !program.loadSource()) {
+            program = detail::Program(createSource(), hash);
+            // problem: reduce parameter a und zip parameter a
+            program.transferParameters("TMP_REDUCE", 2, "SCL_ALLPAIRS"); 
+            program.transferArguments("TMP_REDUCE", 2, "USR_REDUCE");
+            // TODO: Order? first args from reduce than zip??
+            program.transferParameters("TMP_ZIP", 2, "SCL_ALLPAIRS");
+            program.transferArguments("TMP_ZIP", 2, "USR_ZIP");
+
+            program.renameFunction("TMP_REDUCE", "USR_REDUCE");
+            program.renameFunction("TMP_ZIP", "USR_ZIP");
+
+            program.adjustTypes<Tleft, Tright, Tout>();
+        }
 
-    program.build();
+        program.build();
 
-    return program;
+        return program;
+    });
 }
 
 template<typename Tleft, typename Tright, typename Tout>
-detail::Program AllPairs<Tout(Tleft, Tright)>::createAndBuildProgramGeneral() const
+detail::Program::ptr_type AllPairs<Tout(Tleft, Tright)>::createAndBuildProgramGeneral() const
 {
     ASSERT_MESSAGE( !_srcUser.empty(),
                     "Tried to create program with empty user source." );
@@ -324,23 +339,27 @@ SCL_TYPE_1 getElementFromColumn(rmatrix_t* matrix, const unsigned int element_id
       #include "AllPairsKernel2.cl"
     );
 
-    auto program = detail::Program(s, detail::util::hash("//AllPairs\n"
-                                                         + Matrix<Tout>::deviceFunctions()
-                                                         + _srcUser
-                                                         + _funcUser));
-    // modify program
-    if (!program.loadBinary()) {
-        program.transferParameters(_funcUser, 3, "SCL_ALLPAIRS");
-        program.transferArguments(_funcUser, 3, "USR_FUNC");
-
-        program.renameFunction(_funcUser, "USR_FUNC");
-
-        program.adjustTypes<Tleft, Tright, Tout>();
-    }
+    auto hash = detail::util::hash("//AllPairs\n"
+                                   + Matrix<Tout>::deviceFunctions()
+                                   + _srcUser
+                                   + _funcUser
+                                   + detail::util::typeNames<Tleft, Tright, Tout>());
+    return detail::globalProgramRegistry.lookupOrCreate(hash, [&] {
+        auto program = detail::Program(s, hash);
+        // modify program
+        if (!program.loadBinary() && !program.loadSource()) {
+            program.transferParameters(_funcUser, 3, "SCL_ALLPAIRS");
+            program.transferArguments(_funcUser, 3, "USR_FUNC");
+
+            program.renameFunction(_funcUser, "USR_FUNC");
+
+            program.adjustTypes<Tleft, Tright, Tout>();
+        }
 
-    program.build();
+        program.build();
 
-    return program;
+        return program;
+    });
 }
 
 template<typename Tleft, typename Tright, typename Tout>
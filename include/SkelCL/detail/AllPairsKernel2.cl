@@ -42,9 +42,25 @@ R"(
 __kernel void SCL_ALLPAIRS(const __global SCL_TYPE_0* M,
                            const __global SCL_TYPE_1* N,
                                  __global SCL_TYPE_2* P,
-                           const unsigned int dimension,
-                           const unsigned int height,
-                           const unsigned int width) {
+                           const unsigned int dimension_arg,
+                           const unsigned int height_arg,
+                           const unsigned int width_arg) {
+    // sizes might be compile time constants in a specialized variant
+#ifdef SCL_ALLPAIRS_DIMENSION
+    const unsigned int dimension = SCL_ALLPAIRS_DIMENSION;
+#else
+    const unsigned int dimension = dimension_arg;
+#endif
+#ifdef SCL_ALLPAIRS_HEIGHT
+    const unsigned int height = SCL_ALLPAIRS_HEIGHT;
+#else
+    const unsigned int height = height_arg;
+#endif
+#ifdef SCL_ALLPAIRS_WIDTH
+    const unsigned int width = SCL_ALLPAIRS_WIDTH;
+#else
+    const unsigned int width = width_arg;
+#endif
 
     const unsigned int col = get_global_id(0);
     const unsigned int row = get_global_id(1);
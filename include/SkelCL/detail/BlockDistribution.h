@@ -60,7 +60,8 @@ class BlockDistribution<C<T>> : public Distribution<C<T>> {
 public:
   BlockDistribution( const DeviceList& deviceList = globalDeviceList );
   BlockDistribution( const DeviceList& deviceList,
-                     const Significances& significances );
+                     const Significances& significances,
+                     bool adaptive = false );
 
   template <typename U>
   BlockDistribution( const BlockDistribution<C<U>>& rhs);
@@ -76,14 +77,25 @@ public:
   size_t sizeForDevice(const C<T>& container,
                        const std::shared_ptr<detail::Device>& devicePtr) const;
 
+  bool hostOffsetForDevice(const C<T>& container,
+                           const std::shared_ptr<detail::Device>& devicePtr,
+                           size_t* offset) const;
+
   bool dataExchangeOnDistributionChange(Distribution<C<T>>& newDistribution);
 
   const Significances& getSignificances() const;
 
+  ///
+  /// \brief Returns if the significances are adapted by the skeletons to the
+  ///        measured execution times of their kernels (see LoadBalancer)
+  ///
+  bool isAdaptive() const;
+
 private:
   bool doCompare(const Distribution<C<T>>& rhs) const;
 
   Significances _significances;
+  bool          _adaptive;
 };
 
 namespace block_distribution_helper {
@@ -48,21 +48,25 @@ namespace detail {
 
 template <template <typename> class C, typename T>
 BlockDistribution<C<T>>::BlockDistribution(const DeviceList& deviceList)
-  : Distribution<C<T>>(deviceList), _significances(deviceList.size())
+  : Distribution<C<T>>(deviceList), _significances(deviceList.size()),
+    _adaptive(false)
 {
 }
 
 template <template <typename> class C, typename T>
 BlockDistribution<C<T>>::BlockDistribution(const DeviceList& deviceList,
-                                           const Significances& significances)
-  : Distribution<C<T>>(deviceList), _significances(significances)
+                                           const Significances& significances,
+                                           bool adaptive)
+  : Distribution<C<T>>(deviceList), _significances(significances),
+    _adaptive(adaptive)
 {
 }
 
 template <template <typename> class C, typename T>
 template <typename U>
 BlockDistribution<C<T>>::BlockDistribution(const BlockDistribution<C<U>>& rhs)
-  : Distribution<C<T>>(rhs), _significances(rhs.getSignificances())
+  : Distribution<C<T>>(rhs), _significances(rhs.getSignificances()),
+    _adaptive(rhs.isAdaptive())
 {
 }
 
@@ -127,6 +131,21 @@ size_t
                                                      this->_significances);
 }
 
+template <template <typename> class C, typename T>
+bool BlockDistribution<C<T>>::hostOffsetForDevice(const C<T>& container,
+                                                  const std::shared_ptr<
+                                                     detail::Device>& devicePtr,
+                                                  size_t* offset) const
+{
+  // the parts are stored in the order of the devices (see startUpload)
+  *offset = 0;
+  for (auto& d : this->_devices) {
+    if (d == devicePtr) return true;
+    *offset += sizeForDevice(container, d);
+  }
+  return false;
+}
+
 template <template <typename> class C, typename T>
 bool BlockDistribution<C<T>>::dataExchangeOnDistributionChange(
                                    Distribution<C<T>>& newDistribution)
@@ -152,6 +171,12 @@ const Significances& BlockDistribution<C<T>>::getSignificances() const
   return this->_significances;
 }
 
+template <template <typename> class C, typename T>
+bool BlockDistribution<C<T>>::isAdaptive() const
+{
+  return _adaptive;
+}
+
 template <template <typename> class C, typename T>
 bool BlockDistribution<C<T>>::doCompare(const Distribution<C<T>>& rhs) const
 {
@@ -0,0 +1,152 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file BufferPool.h
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#ifndef BUFFER_POOL_H_
+#define BUFFER_POOL_H_
+
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#define __CL_ENABLE_EXCEPTIONS
+#include <CL/cl.hpp>
+#undef  __CL_ENABLE_EXCEPTIONS
+
+#include "skelclDll.h"
+
+namespace skelcl {
+
+namespace detail {
+
+///
+/// \class BufferPool
+///
+/// \brief Caches released OpenCL buffers of a device for later allocations.
+///
+/// Allocation sizes are rounded up to size classes, which are 1, 1.25, 1.5
+/// or 1.75 times a power of two. Therefore, at most a quarter of an
+/// allocation is wasted and buffers of similar sizes can be reused for each
+/// other. Buffers are only reused for allocations of the same size class and
+/// the same memory flags. If the size class exceeds maxAllocation(), the
+/// exact size is allocated instead.
+///
+/// A released buffer is cached as long as the cached buffers do not exceed
+/// maxBytes(). Commands still using a released buffer do not have to be
+/// finished, as the Device orders the commands accessing the buffer after
+/// its reuse behind them.
+///
+class SKELCL_DLL BufferPool {
+public:
+  ///
+  /// \brief Creates a pool caching at most maxBytes bytes
+  ///
+  BufferPool(size_t maxBytes);
+
+  BufferPool(const BufferPool&) = delete;
+
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  ///
+  /// \brief Returns the size in bytes of the buffers allocated for the given
+  ///        number of bytes
+  ///
+  static size_t sizeClass(size_t bytes);
+
+  ///
+  /// \brief Returns the size in bytes of the buffer allocated for the given
+  ///        number of bytes, which is its size class unless that exceeds
+  ///        maxAllocation()
+  ///
+  size_t allocationSize(size_t bytes) const;
+
+  ///
+  /// \brief Returns a cached buffer for the given size and flags or creates
+  ///        a new one in the given context
+  ///
+  cl::Buffer allocate(const cl::Context& context, size_t bytes,
+                      cl_mem_flags flags);
+
+  ///
+  /// \brief Hands back a buffer obtained from allocate() for the given size
+  ///        and flags
+  ///
+  /// \return true if the buffer is cached, false if it is released
+  ///
+  bool release(const cl::Buffer& buffer, size_t bytes, cl_mem_flags flags);
+
+  ///
+  /// \brief Removes all cached buffers from the pool
+  ///
+  /// \return The buffers removed
+  ///
+  std::vector<cl::Buffer> clear();
+
+  void setMaxBytes(size_t bytes);
+
+  size_t maxBytes() const;
+
+  ///
+  /// \brief Sets the maximal size of a single buffer, e.g. the
+  ///        CL_DEVICE_MAX_MEM_ALLOC_SIZE of the device
+  ///
+  void setMaxAllocation(size_t bytes);
+
+  size_t maxAllocation() const;
+
+  ///
+  /// \brief Returns the number of bytes held by cached buffers
+  ///
+  size_t cachedBytes() const;
+
+private:
+  typedef std::pair<cl_mem_flags, size_t> key_type;
+
+  mutable std::mutex                            _mutex;
+  size_t                                        _maxBytes;
+  size_t                                        _maxAllocation;
+  size_t                                        _cachedBytes;
+  std::map<key_type, std::vector<cl::Buffer>>   _free;
+};
+
+} // namespace detail
+
+} // namespace skelcl
+
+#endif // BUFFER_POOL_H_
@@ -0,0 +1,157 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file CompletionQueue.h
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#ifndef COMPLETION_QUEUE_H_
+#define COMPLETION_QUEUE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define __CL_ENABLE_EXCEPTIONS
+#include <CL/cl.hpp>
+#undef  __CL_ENABLE_EXCEPTIONS
+
+#include "skelclDll.h"
+
+namespace skelcl {
+
+namespace detail {
+
+///
+/// \class CompletionQueue
+///
+/// \brief Keeps the buffers accessed by enqueued kernels alive until the
+///        kernels have finished and invokes callbacks afterwards.
+///
+/// Every Device owns one completion queue. Instead of registering a heap
+/// allocated callback for every kernel with the OpenCL runtime, a record
+/// storing the kernel's event and buffers is appended to the queue. A single
+/// thread per queue waits for the oldest submitted record and then retires
+/// all completed records at once. Retired records are kept and reused for
+/// later kernels, so that no memory is allocated in the steady state.
+///
+/// The thread only waits for records which have been submitted to the device
+/// (see submitted()), as waiting for an event would submit its commands
+/// implicitly and, therefore, bypass the device's FlushPolicy.
+///
+class SKELCL_DLL CompletionQueue {
+public:
+  CompletionQueue();
+
+  CompletionQueue(const CompletionQueue&) = delete;
+
+  CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+  ///
+  /// \brief Waits for all records and stops the thread
+  ///
+  ~CompletionQueue();
+
+  ///
+  /// \brief Appends a record for the command signaling the given event
+  ///
+  /// \param event    The event of the command
+  ///        buffers  The buffers to be kept alive until the command finished
+  ///        count    The number of buffers
+  ///        callback Function invoked after the command finished, can be
+  ///                 empty
+  ///
+  void add(const cl::Event& event,
+           const cl::Buffer* buffers,
+           size_t count,
+           const std::function<void()>& callback);
+
+  ///
+  /// \brief Marks all records added so far as submitted to the device, which
+  ///        allows the thread to wait for them
+  ///
+  void submitted();
+
+  ///
+  /// \brief Retires all records. Must only be called after all commands have
+  ///        finished.
+  ///
+  void retireAll();
+
+  ///
+  /// \brief Returns the number of records not retired yet
+  ///
+  size_t size() const;
+
+  ///
+  /// \brief Returns the number of records allocated, including the ones
+  ///        kept for reuse
+  ///
+  size_t capacity() const;
+
+private:
+  struct Record {
+    Record();
+
+    cl::Event               event;
+    std::vector<cl::Buffer> buffers;
+    std::function<void()>   callback;
+  };
+
+  Record* allocate();
+
+  void retire(std::vector<Record*>* records);
+
+  void run();
+
+  mutable std::mutex                    _mutex;
+  std::condition_variable               _condition;
+  std::deque<Record*>                   _records;   // in order of addition
+  size_t                                _submitted; // leading submitted records
+  std::vector<Record*>                  _free;
+  std::vector<std::unique_ptr<Record>>  _storage;
+  bool                                  _stop;
+  std::thread                           _thread;
+};
+
+} // namespace detail
+
+} // namespace skelcl
+
+#endif // COMPLETION_QUEUE_H_
@@ -40,7 +40,12 @@
 #ifndef COPY_DISTRIBUTION_H_
 #define COPY_DISTRIBUTION_H_
 
+#include <string>
+
+#include "../Source.h"
+
 #include "Distribution.h"
+#include "Program.h"
 
 namespace skelcl {
 
@@ -57,6 +62,23 @@ public:
   CopyDistribution(const DeviceList& deviceList = detail::globalDeviceList,
                    std::function<T(const T&, const T&)> combineFunc = nullptr);
 
+  ///
+  /// \brief Creates a copy distribution whose copies are combined on the
+  ///        devices when the data is downloaded
+  ///
+  /// The copies are combined pairwise in a tree, where the copy of one
+  /// device is transferred to another device and combined with its copy
+  /// there. Only the final result is downloaded from the first device.
+  ///
+  /// \param deviceList    The devices the container is copied to
+  ///        combineSource OpenCL source code of a function combining two
+  ///                      elements
+  ///        funcName      Name of the combine function in combineSource
+  ///
+  CopyDistribution(const DeviceList& deviceList,
+                   const Source& combineSource,
+                   const std::string& funcName = std::string("func"));
+
   template <typename U>
   CopyDistribution( const CopyDistribution<C<U>>& rhs);
 
@@ -73,15 +95,39 @@ public:
   size_t sizeForDevice(const C<T>& container,
                        const std::shared_ptr<detail::Device>& devicePtr) const;
 
+  bool hostOffsetForDevice(const C<T>& container,
+                           const std::shared_ptr<detail::Device>& devicePtr,
+                           size_t* offset) const;
+
+  bool rangeForDevice(const C<T>& container,
+                      const std::shared_ptr<detail::Device>& devicePtr,
+                      bool withHalo,
+                      size_t* first,
+                      size_t* count,
+                      size_t* offset) const;
+
   bool dataExchangeOnDistributionChange(Distribution<C<T>>& newDistribution);
 
   std::function<T(const T&, const T&)> combineFunc() const;
 
+  ///
+  /// \brief Returns true if the copies are combined on the devices
+  ///
+  bool combinesOnDevices() const;
+
 protected:
   bool doCompare(const Distribution<C<T>>& rhs) const;
 
 private:
+  // combines the copies on the devices into scratch buffers and reads the
+  // result into the host buffer
+  void combineOnDevices(C<T>& container, Event* events) const;
+
+  static Program::ptr_type createCombineProgram(const std::string& source,
+                                                const std::string& funcName);
+
   std::function<T(const T&, const T&)> _combineFunc;
+  Program::ptr_type                    _combineProgram;
 };
 
 namespace copy_distribution_helper {
@@ -40,11 +40,26 @@
 #ifndef COPY_DISTRIBUTION_DEF_H_
 #define COPY_DISTRIBUTION_DEF_H_
 
+#include <algorithm>
+#include <array>
 #include <functional>
+#include <string>
+#include <vector>
+
+#define __CL_ENABLE_EXCEPTIONS
+#include <CL/cl.hpp>
+#undef  __CL_ENABLE_EXCEPTIONS
 
 #include <pvsutil/Assert.h>
+#include <pvsutil/Logger.h>
+
+#include "../Source.h"
 
+#include "DeviceBuffer.h"
 #include "DeviceList.h"
+#include "Program.h"
+#include "ProgramRegistry.h"
+#include "Util.h"
 
 namespace skelcl {
 
@@ -54,14 +69,24 @@ template <template <typename> class C, typename T>
 CopyDistribution<C<T>>::CopyDistribution(const DeviceList& deviceList,
                                          std::function<T(const T&, const T&)>
                                              combineFunc)
-  : Distribution<C<T>>(deviceList), _combineFunc(combineFunc)
+  : Distribution<C<T>>(deviceList), _combineFunc(combineFunc),
+    _combineProgram()
+{
+}
+
+template <template <typename> class C, typename T>
+CopyDistribution<C<T>>::CopyDistribution(const DeviceList& deviceList,
+                                         const Source& combineSource,
+                                         const std::string& funcName)
+  : Distribution<C<T>>(deviceList), _combineFunc(nullptr),
+    _combineProgram(createCombineProgram(combineSource, funcName))
 {
 }
 
 template <template <typename> class C, typename T>
 template <typename U>
 CopyDistribution<C<T>>::CopyDistribution( const CopyDistribution<C<U>>& rhs)
-  : Distribution<C<T>>(rhs), _combineFunc(nullptr)
+  : Distribution<C<T>>(rhs), _combineFunc(nullptr), _combineProgram()
 {
   // TODO: allow this? How handle this?
 }
@@ -99,7 +124,10 @@ void CopyDistribution<C<T>>::startDownload(C<T>& container,
 {
   ASSERT(events != nullptr);
 
-  if (_combineFunc == nullptr) {
+  if (_combineProgram != nullptr) {
+    combineOnDevices(container, events);
+
+  } else if (_combineFunc == nullptr) {
     // take data from the first device
     auto& firstDevice = *(this->_devices.front());
 
@@ -153,6 +181,33 @@ size_t
   return copy_distribution_helper::sizeForDevice<T>(container.size());
 }
 
+template <template <typename> class C, typename T>
+bool CopyDistribution<C<T>>::hostOffsetForDevice(const C<T>& /*container*/,
+                                                 const std::shared_ptr<
+                                                    detail::Device>& /*d*/,
+                                                 size_t* offset) const
+{
+  // multiple copies can not share the host buffer
+  *offset = 0;
+  return this->_devices.size() == 1;
+}
+
+template <template <typename> class C, typename T>
+bool CopyDistribution<C<T>>::rangeForDevice(const C<T>& container,
+                                            const std::shared_ptr<
+                                               detail::Device>& devicePtr,
+                                            bool /*withHalo*/,
+                                            size_t* first,
+                                            size_t* count,
+                                            size_t* offset) const
+{
+  // every device stores all elements, but they differ if they are combined
+  *first  = 0;
+  *count  = sizeForDevice(container, devicePtr);
+  *offset = 0;
+  return this->_combineFunc == nullptr && this->_combineProgram == nullptr;
+}
+
 template <template <typename> class C, typename T>
 bool CopyDistribution<C<T>>::dataExchangeOnDistributionChange(
                                    Distribution<C<T>>& /*newDistribution*/)
@@ -166,6 +221,12 @@ std::function<T(const T&, const T&)> CopyDistribution<C<T>>::combineFunc() const
   return this->_combineFunc;
 }
 
+template <template <typename> class C, typename T>
+bool CopyDistribution<C<T>>::combinesOnDevices() const
+{
+  return this->_combineProgram != nullptr;
+}
+
 template <template <typename> class C, typename T>
 bool CopyDistribution<C<T>>::doCompare(const Distribution<C<T>>& rhs) const
 {
@@ -177,6 +238,149 @@ bool CopyDistribution<C<T>>::doCompare(const Distribution<C<T>>& rhs) const
   return ret;
 }
 
+template <template <typename> class C, typename T>
+void CopyDistribution<C<T>>::combineOnDevices(C<T>& container,
+                                              Event* events) const
+{
+  const auto& devices = this->_devices;
+  if (devices.size() < 2) {
+    auto& device = *devices.front();
+    events->insert(device.enqueueRead(container.deviceBuffer(device),
+                                      container.hostBuffer().begin()));
+    return;
+  }
+
+  const size_t size     = container.deviceBuffer(*devices.front()).size();
+  const size_t local    = 256;
+  // copies are staged through these host vectors if the devices do not share
+  // a context, every copy is transferred at most once
+  std::vector<std::vector<T>> staging(devices.size() - 1);
+  // the partial results are accumulated in these buffers, so that the copies
+  // of the container on the devices keep their values
+  std::vector<DeviceBuffer>   received(devices.size() - 1);
+  // the buffer holding the partial result of every device
+  std::vector<const DeviceBuffer*> current;
+  for (auto& devicePtr : devices) {
+    current.push_back(&container.deviceBuffer(*devicePtr));
+  }
+  Event writes;
+  size_t pair = 0;
+
+  // in the round with the given distance the devices with an index that is a
+  // multiple of twice the distance combine their partial result with the one
+  // of the device distance indices behind
+  for (size_t distance = 1; distance < devices.size(); distance *= 2) {
+    const size_t first = pair;
+    Event reads;
+    for (size_t i = 0; i + distance < devices.size(); i += 2 * distance) {
+      auto& target = devices[i];
+      auto& source = devices[i + distance];
+      auto& buffer = *current[i + distance];
+
+      received[pair] = DeviceBuffer(target, size, sizeof(T));
+      if (source->sharesContextWith(*target)) {
+        source->enqueueCopy(buffer, received[pair], 0, 0,
+                            buffer.sizeInBytes());
+      } else {
+        staging[pair].resize(size);
+        reads.insert(source->enqueueRead(buffer, staging[pair].begin()));
+      }
+      ++pair;
+    }
+    reads.wait();
+
+    pair = first;
+    for (size_t i = 0; i + distance < devices.size(); i += 2 * distance) {
+      auto& target = devices[i];
+      auto& buffer = *current[i];
+
+      if (!staging[pair].empty()) {
+        writes.insert(target->enqueueWrite(received[pair],
+                                           staging[pair].begin()));
+      }
+
+      cl_uint elements  = static_cast<cl_uint>(size);
+      cl_uint wgSize    = static_cast<cl_uint>(
+                            std::min(local, target->maxWorkGroupSize()) );
+      cl_uint global    = static_cast<cl_uint>(
+                            util::ceilToMultipleOf(elements, wgSize) );
+      try {
+        auto kernel = _combineProgram->kernel(*target, "SCL_COMBINE");
+
+        kernel.setArg(0, buffer.clBuffer());
+        kernel.setArg(1, received[pair].clBuffer());
+        kernel.setArg(2, elements);
+
+        target->enqueue(kernel, cl::NDRange(global), cl::NDRange(wgSize),
+                        cl::NullRange, // offset
+                        std::array<cl::Buffer, 2>{{
+                          buffer.clBuffer(), received[pair].clBuffer() }});
+      } catch (cl::Error& err) {
+        ABORT_WITH_ERROR(err);
+      }
+      current[i] = &received[pair];
+      ++pair;
+    }
+  }
+
+  // the first device holds the combined data, the scratch buffers can be
+  // released while the read is pending (see Device::releaseBuffer)
+  auto& firstDevice = *devices.front();
+  events->insert(firstDevice.enqueueRead(*current.front(),
+                                         container.hostBuffer().begin()));
+  // the staged copies have to stay alive until they are written
+  writes.wait();
+  LOG_DEBUG_INFO("Combined ", devices.size(), " copies on the devices");
+}
+
+template <template <typename> class C, typename T>
+Program::ptr_type
+  CopyDistribution<C<T>>::createCombineProgram(const std::string& source,
+                                               const std::string& funcName)
+{
+  ASSERT_MESSAGE(!source.empty(),
+                 "Tried to create program with empty user source.");
+
+  // first: device specific functions
+  std::string s(CommonDefinitions::getSource());
+  // second: user defined source
+  s.append(source);
+  // last: append the kernel combining two copies
+  s.append(R"(
+
+typedef float SCL_TYPE_0;
+
+__kernel void SCL_COMBINE(
+    const __global SCL_TYPE_0*  SCL_LEFT,
+          __global SCL_TYPE_0*  SCL_RIGHT,
+    const unsigned int          SCL_ELEMENTS)
+{
+  if (get_global_id(0) < SCL_ELEMENTS) {
+    SCL_RIGHT[get_global_id(0)] = SCL_FUNC(SCL_LEFT[get_global_id(0)],
+                                           SCL_RIGHT[get_global_id(0)]);
+  }
+}
+)");
+  auto hash = util::hash("//CopyCombine\n" + s + funcName
+                         + util::typeNames<T>());
+  return globalProgramRegistry.lookupOrCreate(hash, [&] {
+    auto program = Program(s, hash);
+
+    // modify program
+    if (!program.loadBinary() && !program.loadSource()) {
+      // rename user function
+      program.renameFunction(funcName, "SCL_FUNC");
+      // rename typedefs
+      program.adjustTypes<T>();
+    }
+
+    // build program
+    program.build();
+
+    return program;
+  });
+}
+
 namespace copy_distribution_helper {
 
 template <typename T>
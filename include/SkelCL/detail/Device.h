@@ -41,15 +41,21 @@
 #define DEVICE_H_
 
 #include <algorithm>
+#include <array>
 #include <iostream>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #define __CL_ENABLE_EXCEPTIONS
 #include <CL/cl.hpp>
 #undef  __CL_ENABLE_EXCEPTIONS
 
+#include "BufferPool.h"
+#include "CompletionQueue.h"
 #include "skelclDll.h"
 
 namespace skelcl {
@@ -66,11 +72,69 @@ class DeviceBuffer;
 /// This class encapsulates functionality like starting data transfers, kernel
 /// executions, querying information about the device, etc.
 ///
+/// Every device uses two command queues: one for kernels and copies between
+/// buffers and one for transfers between the host and the device. Therefore,
+/// transfers can overlap with kernel executions. The dependencies between
+/// the commands are expressed with events tracked per buffer: the last
+/// command writing the buffer and the commands reading it since. A command
+/// reading a buffer waits for its last writer, a command writing a buffer
+/// waits for its last writer and all its readers.
+///
+/// As these dependencies are complete, the command queues can execute their
+/// commands out of order, if supported by the device. Then, commands on
+/// different buffers, e.g. independent skeleton calls, can execute
+/// concurrently.
+///
+/// By default every command is submitted to the device right after it has
+/// been enqueued. A FlushPolicy allows to batch the submission of commands.
+///
+/// On CPU devices buffers can use the host memory as their storage (zero
+/// copy, see DeviceBuffer). Writes and reads between such a buffer and its
+/// host memory unmap and map the buffer instead of copying the data. A
+/// mapped buffer is unmapped before any other command accesses it.
+///
+/// The buffers and callbacks of enqueued kernels are handed to the device's
+/// CompletionQueue, which releases them once the kernels have finished.
+///
 class SKELCL_DLL Device {
 public:
   typedef size_t id_type;
   typedef std::shared_ptr<Device> ptr_type;
 
+  ///
+  /// \brief Describes when the commands enqueued on a device are submitted to
+  ///        the device, i.e. when the command queues are flushed.
+  ///
+  /// Independent of the policy, the commands are submitted when flush() is
+  /// called, when waiting for the device or for one of the commands, and
+  /// when a command depends on a pending command in the other command queue.
+  ///
+  struct SKELCL_DLL FlushPolicy {
+    ///
+    /// \brief Submit every command right after it has been enqueued. This is
+    ///        the default.
+    ///
+    static FlushPolicy immediate();
+
+    ///
+    /// \brief Submit the commands only when this is required, i.e. when
+    ///        waiting or at explicit calls to flush()
+    ///
+    static FlushPolicy onWait();
+
+    ///
+    /// \brief Submit the commands of a command queue once the given number of
+    ///        commands or of bytes transferred is pending. A value of 0
+    ///        disables the corresponding limit.
+    ///
+    static FlushPolicy threshold(size_t commands, size_t bytes = 0);
+
+    /// maximum number of pending commands per command queue (0: unlimited)
+    size_t maxCommands;
+    /// maximum number of bytes transferred by pending commands (0: unlimited)
+    size_t maxBytes;
+  };
+
   enum Type : size_t {
     ALL         = CL_DEVICE_TYPE_ALL,
     ANY         = CL_DEVICE_TYPE_ALL, // just an alias
@@ -88,10 +152,14 @@ public:
   ///        platform The OpenCL platform for the device
   ///        id       A globally unique identifier in the range of
   ///                 [0, number of devices)
+  ///        context  The OpenCL context shared with other devices of the
+  ///                 same platform. If no context is given, a separate
+  ///                 context is created for the device.
   ///
   Device(const cl::Device& device,
          const cl::Platform& platform,
-         const id_type id);
+         const id_type id,
+         const cl::Context& context = cl::Context());
 
   ///
   /// \brief Default copy constructor
@@ -111,11 +179,16 @@ public:
   ///
   /// \brief Enqueues the execution of an OpenCL kernel object on the device
   ///
+  /// As the buffers accessed by the kernel are unknown, the kernel waits for
+  /// all commands enqueued before and all following commands wait for the
+  /// kernel.
+  ///
   /// \param kernel The OpenCL kernel to be enqueued
   ///        global The total number of OpenCL Work Items to be used in the
   ///               kernel execution
   ///        local  The number of OpenCL Work Items to form an OpenCL Work Group
   ///        offset An Offset to the global IDs of the OpenCL Work Items
+  ///        callback Function invoked after the kernel has finished
   ///
   /// \return An OpenCL Event object which can be used to wait for the
   ///         operation to complete
@@ -126,6 +199,36 @@ public:
                     const cl::NDRange& offset = cl::NullRange,
                     const std::function<void()> callback = nullptr) const;
 
+  ///
+  /// \brief Enqueues the execution of an OpenCL kernel object accessing the
+  ///        given buffers on the device
+  ///
+  /// The kernel only waits for the commands accessing the given buffers, so
+  /// that commands accessing other buffers can overlap with its execution.
+  /// As the kernel arguments do not tell which buffers are only read, the
+  /// kernel is treated as writing all of them.
+  ///
+  /// \param kernel  The OpenCL kernel to be enqueued
+  ///        global  The total number of OpenCL Work Items to be used in the
+  ///                kernel execution
+  ///        local   The number of OpenCL Work Items to form an OpenCL Work
+  ///                Group
+  ///        offset  An Offset to the global IDs of the OpenCL Work Items
+  ///        buffers All buffers accessed by the kernel. They are kept alive
+  ///                until the kernel has finished.
+  ///        callback Function invoked after the kernel has finished
+  ///
+  /// \return An OpenCL Event object which can be used to wait for the
+  ///         operation to complete
+  ///
+  template <size_t N>
+  cl::Event enqueue(const cl::Kernel& kernel,
+                    const cl::NDRange& global,
+                    const cl::NDRange& local,
+                    const cl::NDRange& offset,
+                    const std::array<cl::Buffer, N>& buffers,
+                    const std::function<void()> callback = nullptr) const;
+
   ///
   /// \brief Enqueues a memory operation to copy data to the devices memory
   ///
@@ -244,11 +347,222 @@ public:
                         size_t fromOffset = 0,
                         size_t toOffset = 0) const;
 
+  ///
+  /// \brief Enqueues a memory operation to copy a range of one buffer into
+  ///        the other. The from buffer has to reside on this device, the to
+  ///        buffer on this device or on another device sharing the context
+  ///        with it (see sharesContextWith).
+  ///
+  /// A copy to another device is ordered after the commands of that device
+  /// accessing the to buffer, and the later commands of that device
+  /// accessing the to buffer wait for the copy.
+  ///
+  /// \param from       The Buffer from which the data is copied
+  ///        to         The Buffer where the data is copied into
+  ///        fromOffset Offset used inside the from buffer in Bytes
+  ///        toOffset   Offset used inside the to buffer in Bytes
+  ///        size       Number of Bytes to be copied
+  ///
+  /// \return An OpenCL Event object which can be used to wait for the
+  ///         operation to complete
+  ///
+  cl::Event enqueueCopy(const DeviceBuffer& from,
+                        const DeviceBuffer& to,
+                        size_t fromOffset,
+                        size_t toOffset,
+                        size_t size) const;
+
+  ///
+  /// \brief Enqueues a map command mapping a range of the given buffer into
+  ///        the host address space
+  ///
+  /// The mapped range must be unmapped using enqueueUnmap before any other
+  /// command accesses the buffer.
+  ///
+  /// \param buffer The buffer to be mapped
+  ///        write  If true the mapped range can be modified on the host
+  ///        offset Offset of the mapped range in elements
+  ///        size   Number of elements to be mapped
+  ///        event  Event signaling when the mapped pointer can be accessed
+  ///
+  /// \return The host pointer to the mapped range
+  ///
+  void* enqueueMap(const DeviceBuffer& buffer,
+                   bool write,
+                   size_t offset,
+                   size_t size,
+                   cl::Event* event) const;
+
+  ///
+  /// \brief Enqueues an unmap command for a range mapped by enqueueMap
+  ///
+  /// \param buffer  The buffer previously mapped
+  ///        pointer The host pointer returned by enqueueMap
+  ///        write   The value passed to enqueueMap
+  ///
+  /// \return An OpenCL Event object which can be used to wait for the
+  ///         operation to complete
+  ///
+  cl::Event enqueueUnmap(const DeviceBuffer& buffer,
+                         void* pointer,
+                         bool write) const;
+
   ///
   /// \brief Wait for all operations enqueued to finish
   ///
   void wait() const;
 
+  ///
+  /// \brief Submits all commands enqueued so far to the device
+  ///
+  void flush() const;
+
+  ///
+  /// \brief Sets the policy when enqueued commands are submitted to this
+  ///        device
+  ///
+  void setFlushPolicy(const FlushPolicy& policy);
+
+  ///
+  /// \brief Returns the policy when enqueued commands are submitted to this
+  ///        device
+  ///
+  FlushPolicy flushPolicy() const;
+
+  ///
+  /// \brief Sets the flush policy for devices created afterwards
+  ///
+  /// The initial default is read from the environment variable SKELCL_FLUSH,
+  /// which is either IMMEDIATE, WAIT, or a command count threshold optionally
+  /// followed by a byte threshold, e.g. 16 or 16,1048576.
+  ///
+  static void setDefaultFlushPolicy(const FlushPolicy& policy);
+
+  ///
+  /// \brief Returns the flush policy for devices created afterwards
+  ///
+  static FlushPolicy defaultFlushPolicy();
+
+  ///
+  /// \brief Returns if the command queues of this device execute their
+  ///        commands out of order
+  ///
+  bool outOfOrderExecution() const;
+
+  ///
+  /// \brief Sets if devices created afterwards should execute their commands
+  ///        out of order. This is only honored if the device supports it.
+  ///
+  /// The initial default is read from the environment variable
+  /// SKELCL_OUT_OF_ORDER, which is either YES or NO (the default).
+  ///
+  static void setDefaultOutOfOrderExecution(bool enable);
+
+  ///
+  /// \brief Returns if devices created afterwards should execute their
+  ///        commands out of order
+  ///
+  static bool defaultOutOfOrderExecution();
+
+  ///
+  /// \brief Returns if buffers on this device can use the host memory as
+  ///        their storage, which is the case for CPU devices
+  ///
+  bool zeroCopy() const;
+
+  ///
+  /// \brief Sets if CPU devices created afterwards use zero copy buffers
+  ///
+  /// The initial default is read from the environment variable
+  /// SKELCL_ZERO_COPY, which is either YES or NO (the default). See
+  /// skelcl::useZeroCopy() for the restrictions on accessing the host buffers
+  /// of the containers.
+  ///
+  static void setDefaultZeroCopy(bool enable);
+
+  ///
+  /// \brief Returns if CPU devices created afterwards use zero copy buffers
+  ///
+  static bool defaultZeroCopy();
+
+  ///
+  /// \brief Returns a buffer of at least the given size, reusing a buffer
+  ///        released before if possible (see BufferPool)
+  ///
+  cl::Buffer allocateBuffer(size_t bytes, cl_mem_flags flags) const;
+
+  ///
+  /// \brief Hands back a buffer obtained from allocateBuffer() with the same
+  ///        size and flags, as it is not used for any further operation
+  ///
+  /// The buffer is cached for later allocations, its tracked events are kept
+  /// so that commands accessing it after its reuse wait for the commands
+  /// still using it.
+  ///
+  void releaseBuffer(const cl::Buffer& buffer, size_t bytes,
+                     cl_mem_flags flags) const;
+
+  ///
+  /// \brief Releases all buffers cached for later allocations
+  ///
+  void clearBufferPool() const;
+
+  ///
+  /// \brief Returns the number of bytes held by buffers cached for later
+  ///        allocations
+  ///
+  size_t pooledBytes() const;
+
+  ///
+  /// \brief Sets if devices created afterwards cache released buffers. At
+  ///        most a quarter of the global memory is cached.
+  ///
+  /// The initial default is read from the environment variable
+  /// SKELCL_BUFFER_POOL, which is either YES (the default) or NO.
+  ///
+  static void setDefaultBufferPooling(bool enable);
+
+  ///
+  /// \brief Returns if devices created afterwards cache released buffers
+  ///
+  static bool defaultBufferPooling();
+
+  ///
+  /// \brief Returns if the device uses the same OpenCL context as the given
+  ///        device, so that data can be copied directly between both
+  ///
+  bool sharesContextWith(const Device& other) const;
+
+  ///
+  /// \brief Sets if devices selected afterwards share one context per
+  ///        platform, instead of using a separate context each
+  ///
+  /// The initial default is read from the environment variable
+  /// SKELCL_SHARED_CONTEXT, which is either YES or NO (the default).
+  ///
+  static void setDefaultSharedContext(bool enable);
+
+  ///
+  /// \brief Returns if devices selected afterwards share one context per
+  ///        platform
+  ///
+  static bool defaultSharedContext();
+
+  ///
+  /// \brief Discards the events tracked for the given buffer, as it is not
+  ///        used for any further operation
+  ///
+  void forget(const cl::Buffer& buffer) const;
+
+  ///
+  /// \brief Waits for all commands tracked for the given buffer to finish
+  ///
+  /// This has to be called before the host memory used as storage of a zero
+  /// copy buffer is freed or reallocated, as the commands still using the
+  /// buffer only keep the cl::Buffer object alive, not its storage.
+  ///
+  void finish(const cl::Buffer& buffer) const;
+
   ///
   /// \brief Returns the globally uniqueue identifier
   ///
@@ -272,6 +586,13 @@ public:
   ///
   std::string vendorName() const;
 
+  ///
+  /// \brief Returns the version of the OpenCL driver of the device as a string
+  ///
+  /// \return The version of the OpenCL driver of the device as a string
+  ///
+  std::string driverVersion() const;
+
   ///
   /// \brief Returns the maximal clock frequency of the device
   ///
@@ -308,6 +629,13 @@ public:
   ///
   unsigned long globalMemSize() const;
 
+  ///
+  /// \brief Returns the maximal size of a single buffer on the device
+  ///
+  /// \return The maximal size in bytes of a single buffer on the device
+  ///
+  unsigned long maxMemAllocSize() const;
+
   ///
   /// \brief Returns the maximal local memory size for the device
   ///
@@ -315,6 +643,12 @@ public:
   ///
   unsigned long localMemSize() const;
 
+  ///
+  /// \brief Returns the alignment in bytes required for host memory used as
+  ///        storage of a buffer
+  ///
+  size_t memBaseAddrAlign() const;
+
   ///
   /// \brief Get access to the OpenCL Context for the device
   ///
@@ -337,10 +671,111 @@ private:
   ///
   Device();// = delete;
 
+  cl::Event enqueueKernel(const cl::Kernel& kernel,
+                          const cl::NDRange& global,
+                          const cl::NDRange& local,
+                          const cl::NDRange& offset,
+                          const cl::Buffer* buffers,
+                          size_t bufferCount,
+                          bool buffersKnown,
+                          const std::function<void()>& callback) const;
+
+  // the commands enqueued in a queue, which are not yet submitted
+  struct Pending {
+    Pending();
+
+    size_t commands;
+    size_t bytes;
+  };
+
+  void addDependencies(const cl::Buffer& buffer, bool write,
+                       std::vector<cl::Event>* events) const;
+
+  void recordAccess(const cl::Buffer& buffer, bool write,
+                    const cl::Event& event) const;
+
+  void flushForDependencies(const std::vector<cl::Event>& dependencies,
+                            const cl::CommandQueue& queue) const;
+
+  // adds the (submitted) commands accessing the buffer of this device to
+  // events, before the buffer is accessed by a command of another device;
+  // the caller holds the _queueMutex of this device until the access is
+  // recorded with recordForeignAccess
+  void addForeignDependencies(const cl::Buffer& buffer, bool write,
+                              std::vector<cl::Event>* events) const;
+
+  // records an access to the buffer of this device by a command of another
+  // device; the caller holds the _queueMutex of this device
+  void recordForeignAccess(const cl::Buffer& buffer, bool write,
+                           const cl::Event& event) const;
+
+  bool isZeroCopyTransfer(const DeviceBuffer& buffer, const void* hostPointer,
+                          size_t deviceOffset) const;
+
+  cl::Event map(const DeviceBuffer& buffer) const;
+
+  cl::Event unmap(const DeviceBuffer& buffer) const;
+
+  void unmap(const cl::Buffer& buffer, const cl::CommandQueue& queue,
+             Pending* pending) const;
+
+  // releases a sub-device created by device fission; the bundled cl.hpp
+  // does not reference count devices, so this is done explicitly
+  struct SubDevice {
+    SubDevice();
+
+    ~SubDevice();
+
+    SubDevice(const SubDevice&) = delete;
+
+    SubDevice& operator=(const SubDevice&) = delete;
+
+    cl_device_id device; // nullptr if the device is not a sub-device
+  };
+
+  // the last command writing a buffer, the commands reading it since, and
+  // the buffer and its host pointer while it is mapped
+  struct BufferEvents {
+    BufferEvents();
+
+    BufferEvents(const BufferEvents&) = default;
+
+    BufferEvents& operator=(const BufferEvents&) = default;
+
+    cl::Event              write;
+    std::vector<cl::Event> reads;
+    cl::Buffer             mappedBuffer;
+    void*                  mapped;
+  };
+
+  void submitted(const cl::CommandQueue& queue, Pending* pending,
+                 size_t bytes) const;
+
+  void flushQueue(const cl::CommandQueue& queue, Pending* pending) const;
+
+  // declared first to release the sub-device after the queues and context
+  SubDevice         _subDevice;
   cl::Device        _device;
   cl::Context       _context;
-  cl::CommandQueue  _commandQueue;
+  cl::CommandQueue  _commandQueue;  // kernels and copies
+  cl::CommandQueue  _transferQueue; // reads and writes
   id_type           _id;
+  bool              _outOfOrder;
+  bool              _profiling;
+  bool              _zeroCopy;
+  bool              _bufferPooling;
+  // guards the tracked events and the submission state of both queues
+  mutable std::mutex                        _queueMutex;
+  mutable std::map<cl_mem, BufferEvents>    _bufferEvents;
+  // the last kernel for which the accessed buffers are unknown
+  mutable cl::Event                         _lastUnknownCompute;
+  FlushPolicy                               _flushPolicy;
+  mutable Pending                           _pendingCompute;
+  mutable Pending                           _pendingTransfer;
+  mutable BufferPool                        _bufferPool;
+  // keeps the buffers of running kernels alive, declared last to wait for
+  // the kernels before the queues are released
+  mutable CompletionQueue                   _completions;
 };
 
 SKELCL_DLL
@@ -349,6 +784,18 @@ std::istream& operator>>(std::istream& stream, Device::Type& type);
 SKELCL_DLL
 std::ostream& operator<<(std::ostream& stream, const Device::Type& type);
 
+template <size_t N>
+cl::Event Device::enqueue(const cl::Kernel& kernel,
+                          const cl::NDRange& global,
+                          const cl::NDRange& local,
+                          const cl::NDRange& offset,
+                          const std::array<cl::Buffer, N>& buffers,
+                          const std::function<void()> callback) const
+{
+  return enqueueKernel(kernel, global, local, offset, buffers.data(), N, true,
+                       callback);
+}
+
 template <typename RandomAccessIterator>
 cl::Event Device::enqueueWrite(const DeviceBuffer& buffer,
                                RandomAccessIterator iterator,
@@ -65,6 +65,22 @@ public:
                const size_t elemSize,
                cl_mem_flags flags = CL_MEM_READ_WRITE);
 
+  ///
+  /// \brief Creates a buffer using the given host memory as its storage
+  ///        (CL_MEM_USE_HOST_PTR), if the device supports zero copy and the
+  ///        memory is properly aligned. Otherwise, or if hostPointer is
+  ///        nullptr, a regular buffer is created.
+  ///
+  /// Transfers between a zero copy buffer and its host memory are performed
+  /// by mapping and unmapping the buffer instead of copying (see Device).
+  /// The host memory has to stay valid as long as the buffer is used.
+  ///
+  DeviceBuffer(const std::shared_ptr<Device>& devicePtr,
+               const size_t size,
+               const size_t elemSize,
+               void* hostPointer,
+               cl_mem_flags flags = CL_MEM_READ_WRITE);
+
   DeviceBuffer(const DeviceBuffer& rhs);
 
   DeviceBuffer(DeviceBuffer&& rhs);
@@ -85,15 +101,27 @@ public:
 
   const cl::Buffer& clBuffer() const;
 
+  ///
+  /// \brief Returns the host memory used as storage of a zero copy buffer
+  ///        or nullptr for a regular buffer
+  ///
+  void* hostPointer() const;
+
   bool isValid() const;
 
 private:
+  ///
+  /// \brief Hands the OpenCL buffer back to the device
+  ///
+  void release();
+
   std::string getInfo() const;
 
   std::shared_ptr<Device>         _device;
   size_type                       _size;
   size_type                       _elemSize;
   cl_mem_flags                    _flags; // TODO: Needed?
+  void*                           _hostPointer;
   cl::Buffer                      _buffer;
 };
 
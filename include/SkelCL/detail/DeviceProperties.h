@@ -41,6 +41,7 @@
 #define DEVICE_PROPERTIES_H_
 
 #include <string>
+#include <vector>
 
 #define __CL_ENABLE_EXCEPTIONS
 #include <CL/cl.hpp>
@@ -66,6 +67,39 @@ public:
   bool matchAndTake(const cl::Device& device);
 
   DeviceProperties& deviceType(Device::Type value);
+
+  ///
+  /// \brief Partitions every selected CPU device into sub-devices with the
+  ///        given number of compute units each
+  ///
+  /// Every sub-device is used as a separate Device with its own command
+  /// queues, so that e.g. a BlockDistribution spreads the work across the
+  /// sub-devices. Partitioning requires the cl_ext_device_fission extension,
+  /// devices not supporting it are used as a whole.
+  ///
+  DeviceProperties& partitionEqually(unsigned int computeUnits);
+
+  ///
+  /// \brief Partitions every selected CPU device into one sub-device per
+  ///        given number of compute units (see partitionEqually)
+  ///
+  DeviceProperties& partitionByCounts(
+                        const std::vector<unsigned int>& computeUnits);
+
+  ///
+  /// \brief Partitions every selected CPU device into one sub-device per
+  ///        NUMA node (see partitionEqually), so that the memory used by a
+  ///        sub-device stays local to its node
+  ///
+  DeviceProperties& partitionByNumaDomain();
+
+  ///
+  /// \brief Returns the devices to be used for the given selected device:
+  ///        its sub-devices if it is partitioned, otherwise the device itself
+  ///
+  /// The sub-devices are released by the Device objects created for them.
+  ///
+  std::vector<cl::Device> partition(const cl::Device& device) const;
 #if 0
   void id(Device::id_type value);
   void name(std::string value);
@@ -90,6 +124,8 @@ private:
   Device::Type    _deviceType;
   bool            _takeAll;
   size_t          _count;
+  // properties passed to clCreateSubDevicesEXT, empty => no partitioning
+  std::vector<cl_device_partition_property_ext> _partition;
 #if 0
   Device::id_type _id;
   std::string     _name;
@@ -41,6 +41,7 @@
 #define DISTRIBUTION_H_
 
 #include <functional>
+#include <map>
 #include <memory>
 #include <string>
 
@@ -204,6 +205,85 @@ public:
                                const std::shared_ptr<detail::Device>&
                                   devicePtr) const;
 
+  ///
+  /// \brief Returns if the elements stored on the given device form a
+  ///        contiguous part of the host buffer, which then can be used as the
+  ///        storage of the device buffer (see DeviceBuffer)
+  ///
+  /// \param container The container to be distributed
+  ///        devicePtr The device
+  ///        offset    Set to the position of the first element stored on
+  ///                  the device inside the host buffer
+  ///
+  /// \return true if the host buffer can be used by the device buffer
+  ///
+  virtual bool hostOffsetForDevice(const C<T>& container,
+                                   const std::shared_ptr<detail::Device>&
+                                      devicePtr,
+                                   size_t* offset) const;
+
+  ///
+  /// \brief Returns which contiguous range of the elements of the container
+  ///        is stored on the given device, so that it can be copied directly
+  ///        between device buffers when the distribution changes
+  ///
+  /// \param container The container to be distributed
+  ///        devicePtr The device
+  ///        withHalo  If true, the range includes the elements copied from
+  ///                  the parts of other devices (e.g. the overlap of an
+  ///                  OLDistribution), which skeletons do not keep up to date
+  ///        first     Set to the position of the first element of the range
+  ///        count     Set to the number of elements in the range
+  ///        offset    Set to the position of the range inside the device
+  ///                  buffer. The positions of the buffer outside of the
+  ///                  range are padding (see startPadding).
+  ///
+  /// \return false if the device does not store such a range, or if its
+  ///         elements have to be combined with the elements of other devices
+  ///         first
+  ///
+  virtual bool rangeForDevice(const C<T>& container,
+                              const std::shared_ptr<detail::Device>&
+                                 devicePtr,
+                              bool withHalo,
+                              size_t* first,
+                              size_t* count,
+                              size_t* offset) const;
+
+  ///
+  /// \brief Starts filling the padding of the device buffers (see
+  ///        rangeForDevice) from the elements already stored on the devices
+  ///
+  /// \param container The container whose device buffers are padded
+  ///        events    Events to wait for the padding to be filled
+  ///
+  virtual void startPadding(C<T>& container, Event* events) const;
+
+  ///
+  /// \brief Copies the elements stored on the devices according to this
+  ///        distribution into new device buffers created according to
+  ///        newDistribution
+  ///
+  /// Parts staying on the same device or moving to a device sharing the
+  /// context are copied between the device buffers, only the other parts are
+  /// moved through the host buffer of the container (or written from it, if
+  /// it is up to date). The padding of the new buffers has to be filled
+  /// afterwards (see startPadding).
+  ///
+  /// \param container       The container whose device buffers are
+  ///                        redistributed
+  ///        newDistribution The distribution of the new device buffers
+  ///        hostUpToDate    If the host buffer of the container is up to date
+  ///        buffers         Set to the new device buffers
+  ///
+  /// \return false if the elements can not be redistributed this way, then
+  ///         nothing has been copied
+  ///
+  bool redistribute(C<T>& container,
+                    const Distribution& newDistribution,
+                    bool hostUpToDate,
+                    std::map<Device::id_type, DeviceBuffer>* buffers) const;
+
   virtual bool dataExchangeOnDistributionChange(Distribution& newDistribution);
 
 protected:
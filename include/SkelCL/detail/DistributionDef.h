@@ -40,12 +40,17 @@
 #ifndef DISTRIBUTION_DEF_H_
 #define DISTRIBUTION_DEF_H_
 
+#include <algorithm>
+#include <map>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include <pvsutil/Assert.h>
+#include <pvsutil/Logger.h>
 
 #include "Device.h"
+#include "DeviceBuffer.h"
 #include "DeviceList.h"
 #include "Event.h"
 
@@ -145,6 +150,159 @@ size_t
   return 0;
 }
 
+template <template <typename> class C, typename T>
+bool Distribution<C<T>>::hostOffsetForDevice(const C<T>& /*container*/,
+                                             const std::shared_ptr<
+                                                detail::Device>& /*d*/,
+                                             size_t* /*offset*/) const
+{
+  return false;
+}
+
+template <template <typename> class C, typename T>
+bool Distribution<C<T>>::rangeForDevice(const C<T>& container,
+                                        const std::shared_ptr<
+                                           detail::Device>& devicePtr,
+                                        bool /*withHalo*/,
+                                        size_t* first,
+                                        size_t* count,
+                                        size_t* offset) const
+{
+  // the elements sharing the host buffer form a contiguous range
+  *count  = sizeForDevice(container, devicePtr);
+  *offset = 0;
+  return this->hostOffsetForDevice(container, devicePtr, first);
+}
+
+template <template <typename> class C, typename T>
+void Distribution<C<T>>::startPadding(C<T>& /*container*/,
+                                      Event* /*events*/) const
+{
+}
+
+template <template <typename> class C, typename T>
+bool Distribution<C<T>>::redistribute(C<T>& container,
+                                      const Distribution<C<T>>& newDistribution,
+                                      bool hostUpToDate,
+                                      std::map<Device::id_type,
+                                               DeviceBuffer>* buffers) const
+{
+  ASSERT(buffers != nullptr);
+  auto& oldDevices = devices();
+  auto& newDevices = newDistribution.devices();
+
+  // zero copy buffers are redistributed through the host buffer anyway
+  auto zeroCopy = [](const std::shared_ptr<detail::Device>& devicePtr) {
+                    return devicePtr->zeroCopy();
+                  };
+  if (   std::any_of(oldDevices.begin(), oldDevices.end(), zeroCopy)
+      || std::any_of(newDevices.begin(), newDevices.end(), zeroCopy)) {
+    return false;
+  }
+
+  // only the own elements of the old devices are up to date
+  std::vector<size_t> oldFirst(oldDevices.size());
+  std::vector<size_t> oldLast(oldDevices.size());
+  std::vector<size_t> oldOffset(oldDevices.size());
+  for (size_t i = 0; i < oldDevices.size(); ++i) {
+    size_t count = 0;
+    if (!rangeForDevice(container, oldDevices[i], false,
+                        &oldFirst[i], &count, &oldOffset[i])) {
+      return false;
+    }
+    oldLast[i] = oldFirst[i] + count;
+  }
+
+  // a part of the range of a new device and the old device storing it
+  struct Part {
+    size_t oldIndex;
+    std::shared_ptr<detail::Device> devicePtr;
+    size_t first;
+    size_t size;
+    size_t toOffset;
+  };
+  std::vector<Part> parts;
+
+  for (auto& devicePtr : newDevices) {
+    size_t first  = 0;
+    size_t count  = 0;
+    size_t offset = 0;
+    if (!newDistribution.rangeForDevice(container, devicePtr, true,
+                                        &first, &count, &offset)) {
+      return false;
+    }
+
+    for (size_t pos = first; pos < first + count; ) {
+      // the device itself is preferred, otherwise the device storing the
+      // longest part
+      size_t from = oldDevices.size();
+      for (size_t i = 0; i < oldDevices.size(); ++i) {
+        if (pos < oldFirst[i] || pos >= oldLast[i]) continue;
+        if (oldDevices[i] == devicePtr) { from = i; break; }
+        if (from == oldDevices.size() || oldLast[i] > oldLast[from]) {
+          from = i;
+        }
+      }
+      if (from == oldDevices.size()) return false;
+
+      size_t end = std::min(first + count, oldLast[from]);
+      parts.push_back( Part{ from, devicePtr, pos, end - pos,
+                             offset + (pos - first) } );
+      pos = end;
+    }
+  }
+
+  buffers->clear();
+  for (auto& devicePtr : newDevices) {
+    buffers->insert(std::make_pair(
+                      devicePtr->id(),
+                      DeviceBuffer(devicePtr,
+                                   newDistribution.sizeForDevice(container,
+                                                                 devicePtr),
+                                   sizeof(T)) ));
+  }
+
+  // copy the parts between the device buffers, parts moving between
+  // different contexts are read into the host buffer first
+  Event reads;
+  std::vector<const Part*> staged;
+  for (auto& part : parts) {
+    auto& fromDevicePtr = oldDevices[part.oldIndex];
+    auto& from = container.deviceBuffer(*fromDevicePtr);
+    size_t fromOffset = oldOffset[part.oldIndex]
+                      + (part.first - oldFirst[part.oldIndex]);
+    if (fromDevicePtr->sharesContextWith(*part.devicePtr)) {
+      fromDevicePtr->enqueueCopy(from, (*buffers)[part.devicePtr->id()],
+                                 fromOffset * sizeof(T),
+                                 part.toOffset * sizeof(T),
+                                 part.size * sizeof(T));
+    } else {
+      if (!hostUpToDate) {
+        reads.insert(fromDevicePtr->enqueueRead(from,
+                                                container.hostBuffer().begin(),
+                                                part.size, fromOffset,
+                                                part.first));
+      }
+      staged.push_back(&part);
+    }
+  }
+  reads.wait();
+
+  Event writes;
+  for (auto part : staged) {
+    writes.insert(part->devicePtr->enqueueWrite(
+                    (*buffers)[part->devicePtr->id()],
+                    container.hostBuffer().begin(),
+                    part->size, part->toOffset, part->first));
+  }
+  // the host buffer might be modified afterwards
+  writes.wait();
+
+  LOG_DEBUG_INFO("Redistributed ", parts.size(), " part(s) between devices, ",
+                 staged.size(), " of them through the host");
+  return true;
+}
+
 template <template <typename> class C, typename T>
 bool Distribution<C<T>>::dataExchangeOnDistributionChange(
                                    Distribution<C<T>>& /*newDistribution*/)
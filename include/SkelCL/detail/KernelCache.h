@@ -0,0 +1,141 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file KernelCache.h
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#ifndef KERNEL_CACHE_H_
+#define KERNEL_CACHE_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define __CL_ENABLE_EXCEPTIONS
+#include <CL/cl.hpp>
+#undef  __CL_ENABLE_EXCEPTIONS
+
+#include "Device.h"
+#include "skelclDll.h"
+
+namespace skelcl {
+
+namespace detail {
+
+class CachedKernel;
+
+///
+/// \class KernelCache
+///
+/// \brief Caches the kernel objects created from a program, so that
+///        repeated launches of a skeleton do not create a new kernel object
+///        every time.
+///
+/// A kernel is checked out for exclusive use, as its arguments are part of
+/// its state. The returned CachedKernel puts the kernel back into the cache
+/// when it is destroyed. A kernel can be reused right after it has been
+/// enqueued, because OpenCL captures the arguments at that point.
+///
+class SKELCL_DLL KernelCache
+  : public std::enable_shared_from_this<KernelCache> {
+public:
+  KernelCache();
+
+  KernelCache(const KernelCache&) = delete;
+
+  KernelCache& operator=(const KernelCache&) = delete;
+
+  ~KernelCache();
+
+  ///
+  /// \brief Returns an unused kernel with the given name for the given
+  ///        device. A new kernel is created from program if required.
+  ///
+  CachedKernel checkout(const cl::Program& program,
+                        Device::id_type device,
+                        const std::string& name);
+
+  ///
+  /// \brief Puts the given kernel back into the cache
+  ///
+  void checkin(Device::id_type device,
+               const std::string& name,
+               const cl::Kernel& kernel);
+
+private:
+  typedef std::pair<Device::id_type, std::string> key_type;
+
+  std::mutex                                    _mutex;
+  std::map<key_type, std::vector<cl::Kernel>>   _kernels;
+};
+
+///
+/// \class CachedKernel
+///
+/// \brief A kernel checked out from a KernelCache. The kernel is returned to
+///        the cache when this object is destroyed.
+///
+class SKELCL_DLL CachedKernel : public cl::Kernel {
+public:
+  CachedKernel(const cl::Kernel& kernel,
+               const std::shared_ptr<KernelCache>& cache,
+               Device::id_type device,
+               const std::string& name);
+
+  CachedKernel(const CachedKernel&) = delete;
+
+  CachedKernel(CachedKernel&& rhs);
+
+  CachedKernel& operator=(const CachedKernel&) = delete;
+
+  CachedKernel& operator=(CachedKernel&& rhs);
+
+  ~CachedKernel();
+
+private:
+  std::shared_ptr<KernelCache>  _cache;
+  Device::id_type               _device;
+  std::string                   _name;
+};
+
+} // namespace detail
+
+} // namespace skelcl
+
+#endif // KERNEL_CACHE_H_
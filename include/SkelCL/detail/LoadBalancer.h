@@ -0,0 +1,208 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+///
+/// \file LoadBalancer.h
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#ifndef LOAD_BALANCER_H_
+#define LOAD_BALANCER_H_
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define __CL_ENABLE_EXCEPTIONS
+#include <CL/cl.hpp>
+#undef  __CL_ENABLE_EXCEPTIONS
+
+#include "Device.h"
+#include "Significances.h"
+
+#include "skelclDll.h"
+
+namespace skelcl {
+
+namespace detail {
+
+class DeviceList;
+
+///
+/// \class LoadBalancer
+///
+/// \brief Learns the significances of adaptive block distributions from the
+///        measured execution times of the kernels.
+///
+/// For every kernel a skeleton launches on a part of a container with an
+/// adaptive block distribution, the number of elements processed and the
+/// event of the kernel are recorded. Once the kernel has finished, the
+/// throughput of the device (elements per nanosecond) is updated as an
+/// exponential moving average. The significances returned for the next
+/// invocation of the skeleton are proportional to the throughputs of the
+/// devices. They are only changed if one of them differs by more than five
+/// percent from the current one, so that the data is not moved between the
+/// devices for small fluctuations of the measurements.
+///
+/// The significances are learned per skeleton (identified by the hash of
+/// its program) and set of devices. skelcl::terminate() stores them in the
+/// program cache, so that subsequent runs start with the learned split.
+///
+/// The load balancer is disabled by default, as the measurements require
+/// the command queues of all devices to be created with profiling enabled.
+/// It is enabled by setting the environment variable SKELCL_ADAPTIVE_BLOCK
+/// to YES or by calling setEnabled() (or skelcl::useAdaptiveBlocks()) prior
+/// to skelcl::init(). Adaptive block distributions split the data evenly, if
+/// it is disabled.
+///
+class SKELCL_DLL LoadBalancer {
+public:
+  LoadBalancer();
+
+  LoadBalancer(const LoadBalancer&) = delete;
+
+  LoadBalancer& operator=(const LoadBalancer&) = delete;
+
+  ~LoadBalancer();
+
+  ///
+  /// \brief Returns if the load balancer is enabled
+  ///
+  bool isEnabled() const;
+
+  ///
+  /// \brief Enables or disables the load balancer
+  ///
+  /// This has to be called prior to skelcl::init(), as the command queues
+  /// are only created with profiling enabled if the load balancer is enabled.
+  ///
+  void setEnabled(bool enabled);
+
+  ///
+  /// \brief Returns the significances to use for the next invocation of a
+  ///        skeleton on the given devices
+  ///
+  /// \param key     Identifies the skeleton, e.g. the hash of its program
+  ///        devices The devices the skeleton runs on
+  ///
+  /// \return The learned significances or even significances, if nothing
+  ///         has been learned so far
+  ///
+  Significances significances(const std::string& key,
+                              const DeviceList& devices);
+
+  ///
+  /// \brief Records a kernel launched by a skeleton on one of the devices
+  ///
+  /// \param key      Identifies the skeleton, e.g. the hash of its program
+  ///        devices  The devices the skeleton runs on
+  ///        device   The device the kernel has been launched on
+  ///        elements The number of elements the kernel processes
+  ///        event    The event of the kernel
+  ///
+  void record(const std::string& key,
+              const DeviceList& devices,
+              const Device& device,
+              size_t elements,
+              const cl::Event& event);
+
+  ///
+  /// \brief Records the measured execution time of a kernel launched by a
+  ///        skeleton on one of the devices
+  ///
+  /// This is what record() does once the recorded kernel has finished.
+  ///
+  /// \param key         Identifies the skeleton, e.g. the hash of its program
+  ///        devices     The devices the skeleton runs on
+  ///        device      The device the kernel has been executed on
+  ///        elements    The number of elements the kernel processed
+  ///        nanoseconds The execution time of the kernel
+  ///
+  void recordThroughput(const std::string& key,
+                        const DeviceList& devices,
+                        const Device& device,
+                        size_t elements,
+                        cl_ulong nanoseconds);
+
+  ///
+  /// \brief Stores the learned significances in the program cache and
+  ///        discards the kernels recorded so far
+  ///
+  void save();
+
+  ///
+  /// \brief Discards all learned significances and recorded kernels
+  ///
+  void clear();
+
+private:
+  struct Entry {
+    Entry();
+
+    std::vector<Device::id_type>            devices;
+    std::vector<double>                     throughputs;
+    std::vector<Significances::value_type>  weights;
+    bool                                    modified;
+  };
+
+  struct Record {
+    std::string       key;
+    Device::id_type   device;
+    size_t            elements;
+    cl::Event         event;
+  };
+
+  Entry& entry(const std::string& key, const DeviceList& devices);
+
+  void update();
+
+  void addThroughput(const std::string& cacheKey, Device::id_type device,
+                     size_t elements, cl_ulong nanoseconds);
+
+  static std::string cacheKey(const std::string& key,
+                              const DeviceList& devices);
+
+  mutable std::mutex            _mutex;
+  bool                          _enabled;
+  std::map<std::string, Entry>  _entries;
+  std::vector<Record>           _records;
+};
+
+SKELCL_DLL extern LoadBalancer globalLoadBalancer;
+
+} // namespace detail
+
+} // namespace skelcl
+
+#endif // LOAD_BALANCER_H_
@@ -67,6 +67,7 @@
 #include "Device.h"
 #include "KernelUtil.h"
 #include "Program.h"
+#include "ProgramRegistry.h"
 #include "Skeleton.h"
 #include "Util.h"
 
@@ -99,6 +100,9 @@ C<Tout>& Map<Tout(Tin)>::operator()(Out<C<Tout>> output,
                                     const C<Tin>& input,
                                     Args&&... args) const
 {
+  // adapt the sizes of the blocks to the measured kernel times
+  this->balance(input, *this->_program);
+
   this->prepareInput(input);
 
   prepareAdditionalInput(std::forward<Args>(args)...);
@@ -134,7 +138,7 @@ void Map<Tout(Tin)>::execute(C<Tout>& output,
                           detail::util::ceilToMultipleOf(elements, local) );
 
     try {
-      cl::Kernel kernel(this->_program.kernel(*devicePtr, "SCL_MAP"));
+      auto kernel = this->_program->kernel(*devicePtr, "SCL_MAP");
 
       kernel.setArg(0, inputBuffer.clBuffer());
       kernel.setArg(1, outputBuffer.clBuffer());
@@ -149,15 +153,12 @@ void Map<Tout(Tin)>::execute(C<Tout>& output,
                                                      std::forward<Args>(args)...
                                                     );
 
-      // after finishing the kernel invoke this function ...
-      auto invokeAfter =  [=] () {
-                                    (void)keepAlive;
-                                 };
+      auto event = devicePtr->enqueue(kernel,
+                                      cl::NDRange(global), cl::NDRange(local),
+                                      cl::NullRange, // offset
+                                      keepAlive);
 
-      devicePtr->enqueue(kernel,
-                         cl::NDRange(global), cl::NDRange(local),
-                         cl::NullRange, // offset
-                         invokeAfter);
+      this->recordKernel(input, *this->_program, *devicePtr, elements, event);
     } catch (cl::Error& err) {
       ABORT_WITH_ERROR(err);
     }
@@ -166,7 +167,7 @@ void Map<Tout(Tin)>::execute(C<Tout>& output,
 }
 
 template <typename Tin, typename Tout>
-detail::Program
+detail::Program::ptr_type
     Map<Tout(Tin)>::createAndBuildProgram(const std::string& source,
                                           const std::string& funcName) const
 {
@@ -194,23 +195,27 @@ __kernel void SCL_MAP(
   }
 }
 )");
-  auto program = detail::Program(s, detail::util::hash(s));
-
-  // modify program
-  if (!program.loadBinary()) {
-    // append parameters from user function to kernel
-    program.transferParameters(funcName, 1, "SCL_MAP");
-    program.transferArguments(funcName, 1, "SCL_FUNC");
-    // rename user function
-    program.renameFunction(funcName, "SCL_FUNC");
-    // rename typedefs
-    program.adjustTypes<Tin, Tout>();
-  }
+  auto hash = detail::util::hash("//Map\n" + s + funcName
+                                 + detail::util::typeNames<Tin, Tout>());
+  return detail::globalProgramRegistry.lookupOrCreate(hash, [&] {
+    auto program = detail::Program(s, hash);
+
+    // modify program
+    if (!program.loadBinary() && !program.loadSource()) {
+      // append parameters from user function to kernel
+      program.transferParameters(funcName, 1, "SCL_MAP");
+      program.transferArguments(funcName, 1, "SCL_FUNC");
+      // rename user function
+      program.renameFunction(funcName, "SCL_FUNC");
+      // rename typedefs
+      program.adjustTypes<Tin, Tout>();
+    }
 
-  // build program
-  program.build();
+    // build program
+    program.build();
 
-  return program;
+    return program;
+  });
 }
 
 
@@ -256,7 +261,7 @@ void Map<void(Tin)>::execute(const C<Tin>& input,
                           detail::util::ceilToMultipleOf(elements, local) );
 
     try {
-      cl::Kernel kernel(this->_program.kernel(*devicePtr, "SCL_MAP"));
+      auto kernel = this->_program->kernel(*devicePtr, "SCL_MAP");
 
       kernel.setArg(0, inputBuffer.clBuffer());
       kernel.setArg(1, elements);
@@ -269,15 +274,10 @@ void Map<void(Tin)>::execute(const C<Tin>& input,
                                                      std::forward<Args>(args)...
                                                     );
 
-      // after finishing the kernel invoke this function and release keepAlive
-      auto invokeAfter =  [=] () {
-                                    (void)keepAlive;
-                                 };
-
       devicePtr->enqueue(kernel,
                          cl::NDRange(global), cl::NDRange(local),
                          cl::NullRange, // offset
-                         invokeAfter);
+                         keepAlive);
     } catch (cl::Error& err) {
       ABORT_WITH_ERROR(err);
     }
@@ -286,7 +286,7 @@ void Map<void(Tin)>::execute(const C<Tin>& input,
 }
 
 template <typename Tin>
-detail::Program
+detail::Program::ptr_type
     Map<void(Tin)>::createAndBuildProgram(const std::string& source,
                                           const std::string& funcName) const
 {
@@ -312,23 +312,27 @@ __kernel void SCL_MAP(
   }
 }
 )");
-  auto program = detail::Program(s, detail::util::hash(s));
-
-  // modify program
-  if (!program.loadBinary()) {
-    // append parameters from user function to kernel
-    program.transferParameters(funcName, 1, "SCL_MAP");
-    program.transferArguments(funcName, 1, "SCL_FUNC");
-    // rename user function
-    program.renameFunction(funcName, "SCL_FUNC");
-  // rename typedefs
-    program.adjustTypes<Tin>();
-  }
+  auto hash = detail::util::hash("//Map\n" + s + funcName
+                                 + detail::util::typeNames<Tin>());
+  return detail::globalProgramRegistry.lookupOrCreate(hash, [&] {
+    auto program = detail::Program(s, hash);
+
+    // modify program
+    if (!program.loadBinary() && !program.loadSource()) {
+      // append parameters from user function to kernel
+      program.transferParameters(funcName, 1, "SCL_MAP");
+      program.transferArguments(funcName, 1, "SCL_FUNC");
+      // rename user function
+      program.renameFunction(funcName, "SCL_FUNC");
+    // rename typedefs
+      program.adjustTypes<Tin>();
+    }
 
-  // build program
-  program.build();
+    // build program
+    program.build();
 
-  return program;
+    return program;
+  });
 }
 
 // ## Map<Index, Tout> ################################################
@@ -391,7 +395,7 @@ void Map<Tout(Index)>::execute(Vector<Tout>& output, const Vector<Index>& input,
         static_cast<cl_uint>(detail::util::ceilToMultipleOf(sizes[i], local));
 
     try {
-      cl::Kernel kernel(this->_program.kernel(*devicePtr, "SCL_MAP"));
+      auto kernel = this->_program->kernel(*devicePtr, "SCL_MAP");
 
       kernel.setArg(0, outputBuffer.clBuffer());
       kernel.setArg(1, static_cast<cl_uint>(output.size()));
@@ -401,13 +405,10 @@ void Map<Tout(Index)>::execute(Vector<Tout>& output, const Vector<Index>& input,
                                         std::forward<Args>(args)...);
 
       auto keepAlive = detail::kernelUtil::keepAlive(
-          *devicePtr, std::forward<Args>(args)...);
-
-      // after finishing the kernel invoke this function ...
-      auto invokeAfter = [=]() { (void)keepAlive; };
+          *devicePtr, outputBuffer.clBuffer(), std::forward<Args>(args)...);
 
       devicePtr->enqueue(kernel, cl::NDRange(global), cl::NDRange(local),
-                         cl::NullRange, invokeAfter);
+                         cl::NullRange, keepAlive);
     } catch (cl::Error& err) {
       ABORT_WITH_ERROR(err);
     }
@@ -418,7 +419,7 @@ void Map<Tout(Index)>::execute(Vector<Tout>& output, const Vector<Index>& input,
 }
 
 template <typename Tout>
-detail::Program
+detail::Program::ptr_type
     Map<Tout(Index)>::createAndBuildProgram(const std::string& source,
                                             const std::string& funcName) const
 {
@@ -449,23 +450,27 @@ __kernel void SCL_MAP(
   }
 }
 )");
-  auto program = detail::Program(s, detail::util::hash(s));
-
-  // modify program
-  if (!program.loadBinary()) {
-    // append parameters from user function to kernel
-    program.transferParameters(funcName, 1, "SCL_MAP");
-    program.transferArguments(funcName, 1, "SCL_FUNC");
-    // rename user function
-    program.renameFunction(funcName, "SCL_FUNC");
-    // rename typedefs
-    program.adjustTypes<Tout>();
-  }
+  auto hash = detail::util::hash("//Map\n" + s + funcName
+                                 + detail::util::typeNames<Tout>());
+  return detail::globalProgramRegistry.lookupOrCreate(hash, [&] {
+    auto program = detail::Program(s, hash);
+
+    // modify program
+    if (!program.loadBinary() && !program.loadSource()) {
+      // append parameters from user function to kernel
+      program.transferParameters(funcName, 1, "SCL_MAP");
+      program.transferArguments(funcName, 1, "SCL_FUNC");
+      // rename user function
+      program.renameFunction(funcName, "SCL_FUNC");
+      // rename typedefs
+      program.adjustTypes<Tout>();
+    }
 
-  // build program
-  program.build();
+    // build program
+    program.build();
 
-  return program;
+    return program;
+  });
 }
 
 // ## Map<Index, void> ################################################
@@ -503,7 +508,7 @@ void Map<void(Index)>::execute(const Vector<Index>& input,
         static_cast<cl_uint>(detail::util::ceilToMultipleOf(sizes[i], local));
 
     try {
-      cl::Kernel kernel(this->_program.kernel(*devicePtr, "SCL_MAP"));
+      auto kernel = this->_program->kernel(*devicePtr, "SCL_MAP");
 
       kernel.setArg(0, sizes[i]);
       kernel.setArg(1, offset);
@@ -514,11 +519,8 @@ void Map<void(Index)>::execute(const Vector<Index>& input,
       auto keepAlive = detail::kernelUtil::keepAlive(
           *devicePtr, std::forward<Args>(args)...);
 
-      // after finishing the kernel invoke this function ...
-      auto invokeAfter = [=]() { (void)keepAlive; };
-
       devicePtr->enqueue(kernel, cl::NDRange(global), cl::NDRange(local),
-                         cl::NullRange, invokeAfter);
+                         cl::NullRange, keepAlive);
     } catch (cl::Error& err) {
       ABORT_WITH_ERROR(err);
     }
@@ -597,7 +599,7 @@ void Map<Tout(IndexPoint)>::execute(Matrix<Tout>& output,
         static_cast<cl_uint>(detail::util::ceilToMultipleOf(rowCount, local));
 
     try {
-      cl::Kernel kernel(this->_program.kernel(*devicePtr, "SCL_MAP"));
+      auto kernel = this->_program->kernel(*devicePtr, "SCL_MAP");
       
       kernel.setArg(0, outputBuffer.clBuffer());
       kernel.setArg(1, static_cast<cl_uint>(output.size().elemCount()));
@@ -612,11 +614,9 @@ void Map<Tout(IndexPoint)>::execute(Matrix<Tout>& output,
                                                      std::forward<Args>(args)...
                                                     );
       
-      // after finishing the kernel invoke this function ...
-      auto invokeAfter = [=]() { (void)keepAlive; };
-
       devicePtr->enqueue(kernel, cl::NDRange(rowGlobal, colGlobal),
-                         cl::NDRange(local, local), cl::NullRange, invokeAfter);
+                         cl::NDRange(local, local), cl::NullRange,
+                         keepAlive);
     } catch (cl::Error& err) {
       ABORT_WITH_ERROR(err);
     }
@@ -627,7 +627,7 @@ void Map<Tout(IndexPoint)>::execute(Matrix<Tout>& output,
 }
 
 template <typename Tout>
-detail::Program Map<Tout(IndexPoint)>::createAndBuildProgram(
+detail::Program::ptr_type Map<Tout(IndexPoint)>::createAndBuildProgram(
     const std::string& source, const std::string& funcName) const
 {
   ASSERT_MESSAGE(!source.empty(),
@@ -664,23 +664,27 @@ __kernel void SCL_MAP(__global SCL_TYPE_0*  SCL_OUT,
   }
 }
 )");
-  auto program = detail::Program(s, detail::util::hash(s));
-  
-  // modify program
-  if (!program.loadBinary()) {
-    // append parameters from user function to kernel
-    program.transferParameters(funcName, 1, "SCL_MAP");
-    program.transferArguments(funcName, 1, "SCL_FUNC");
-    // rename user function
-    program.renameFunction(funcName, "SCL_FUNC");
-    // rename typedefs
-    program.adjustTypes<Tout>();
-  }
-  
-  // build program
-  program.build();
-  
-  return program;
+  auto hash = detail::util::hash("//Map\n" + s + funcName
+                                 + detail::util::typeNames<Tout>());
+  return detail::globalProgramRegistry.lookupOrCreate(hash, [&] {
+    auto program = detail::Program(s, hash);
+
+    // modify program
+    if (!program.loadBinary() && !program.loadSource()) {
+      // append parameters from user function to kernel
+      program.transferParameters(funcName, 1, "SCL_MAP");
+      program.transferArguments(funcName, 1, "SCL_FUNC");
+      // rename user function
+      program.renameFunction(funcName, "SCL_FUNC");
+      // rename typedefs
+      program.adjustTypes<Tout>();
+    }
+
+    // build program
+    program.build();
+
+    return program;
+  });
 }
 
 // ## Map<IndexPoint, void> ################################################
@@ -725,7 +729,7 @@ void Map<void(IndexPoint)>::execute(const Matrix<IndexPoint>& input,
         static_cast<cl_uint>(detail::util::ceilToMultipleOf(rowCount, local));
 
     try {
-      cl::Kernel kernel(this->_program.kernel(*devicePtr, "SCL_MAP"));
+      auto kernel = this->_program->kernel(*devicePtr, "SCL_MAP");
 
       kernel.setArg(0, colCount);
       kernel.setArg(1, rowCount);
@@ -737,11 +741,9 @@ void Map<void(IndexPoint)>::execute(const Matrix<IndexPoint>& input,
       auto keepAlive = detail::kernelUtil::keepAlive(
           *devicePtr, std::forward<Args>(args)...);
 
-      // after finishing the kernel invoke this function ...
-      auto invokeAfter = [=]() { (void)keepAlive; };
-
       devicePtr->enqueue(kernel, cl::NDRange(rowGlobal, colGlobal),
-                         cl::NDRange(local, local), cl::NullRange, invokeAfter);
+                         cl::NDRange(local, local), cl::NullRange,
+                         keepAlive);
     } catch (cl::Error& err) {
       ABORT_WITH_ERROR(err);
     }
@@ -55,7 +55,7 @@ class MapHelper<Tout(Tin)> {
 public:
   MapHelper() = delete;
 
-  MapHelper(detail::Program&& program);
+  MapHelper(detail::Program::ptr_type program);
 
   MapHelper(const MapHelper&) = default;
 
@@ -71,7 +71,7 @@ protected:
   void prepareOutput(C<Tout>& output,
                      const C<Tin>& input) const;
 
-  const detail::Program _program;
+  const detail::Program::ptr_type _program;
 };
 
 } // namespace detail
@@ -52,8 +52,8 @@ namespace skelcl {
 namespace detail {
 
 template <typename Tin, typename Tout>
-MapHelper<Tout(Tin)>::MapHelper(detail::Program&& program)
-  : _program(std::move(program))
+MapHelper<Tout(Tin)>::MapHelper(detail::Program::ptr_type program)
+  : _program(program)
 {
 }
 
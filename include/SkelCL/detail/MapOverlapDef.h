@@ -63,6 +63,7 @@
 #include "Device.h"
 #include "KernelUtil.h"
 #include "Program.h"
+#include "ProgramRegistry.h"
 #include "Skeleton.h"
 #include "Util.h"
 
@@ -121,17 +122,19 @@ void MapOverlap<Tout(Tin)>::execute(Matrix<Tout>& output, const Matrix<Tin>& in,
          output.columnCount() == in.columnCount());
 
   for (auto& devicePtr : in.distribution().devices()) {
-    cl::Kernel kernel(_program.kernel(*devicePtr, "SCL_MAPOVERLAP"));
-
-    cl_uint workgroupSize = static_cast<cl_uint>(
-        detail::kernelUtil::determineWorkgroupSizeForKernel(kernel,
-                                                            *devicePtr));
-
     auto& outputBuffer = output.deviceBuffer(*devicePtr);
     auto& inputBuffer = in.deviceBuffer(*devicePtr);
 
     cl_uint elements = static_cast<cl_uint>(
         inputBuffer.size() - 2 * _overlap_range * in.columnCount());
+
+    auto kernel = _program->kernel(*devicePtr, "SCL_MAPOVERLAP",
+                      { {"SCL_MAPOVERLAP_ELEMENTS", elements},
+                        {"SCL_MAPOVERLAP_COLS", output.columnCount()} });
+
+    cl_uint workgroupSize = static_cast<cl_uint>(
+        detail::kernelUtil::determineWorkgroupSizeForKernel(kernel,
+                                                            *devicePtr));
     cl_uint local[2] = {static_cast<cl_uint>(sqrt(workgroupSize)), local[0]};
     cl_uint global[2] = {static_cast<cl_uint>(detail::util::ceilToMultipleOf(
                              in.columnCount(), local[0])),
@@ -162,12 +165,10 @@ void MapOverlap<Tout(Tin)>::execute(Matrix<Tout>& output, const Matrix<Tin>& in,
           *devicePtr, inputBuffer.clBuffer(), outputBuffer.clBuffer(),
           std::forward<Args>(args)...);
 
-      // after finishing the kernel invoke this function ...
-      auto invokeAfter = [=]() { (void)keepAlive; };
       auto event = devicePtr->enqueue(kernel, cl::NDRange(global[0], global[1]),
                                       cl::NDRange(local[0], local[1]),
                                       cl::NullRange, // offset
-                                      invokeAfter);
+                                      keepAlive);
     }
     catch (cl::Error& err)
     {
@@ -178,7 +179,7 @@ void MapOverlap<Tout(Tin)>::execute(Matrix<Tout>& output, const Matrix<Tin>& in,
 }
 
 template <typename Tin, typename Tout>
-detail::Program MapOverlap<Tout(Tin)>::createAndBuildProgram() const
+detail::Program::ptr_type MapOverlap<Tout(Tin)>::createAndBuildProgram() const
 {
   ASSERT_MESSAGE(!_userSource.empty(),
                  "Tried to create program with empty user source.");
@@ -231,20 +232,24 @@ SCL_TYPE_1 getData(input_matrix_t matrix, int x, int y)
 #include "MapOverlapKernel.cl"
       );
 
-  auto program = detail::Program(s, detail::util::hash("//MapOverlap\n" + s));
+  auto hash = detail::util::hash("//MapOverlap\n" + s + _funcName
+                                 + detail::util::typeNames<Tin, Tout>());
+  return detail::globalProgramRegistry.lookupOrCreate(hash, [&] {
+    auto program = detail::Program(s, hash);
 
-  // modify program
-	if (!program.loadBinary()) {
-		program.transferParameters(_funcName, 1, "SCL_MAPOVERLAP");
-		program.transferArguments(_funcName, 1, "USR_FUNC");
+    // modify program
+    if (!program.loadBinary() && !program.loadSource()) {
+      program.transferParameters(_funcName, 1, "SCL_MAPOVERLAP");
+      program.transferArguments(_funcName, 1, "USR_FUNC");
 
-		program.renameFunction(_funcName, "USR_FUNC");
+      program.renameFunction(_funcName, "USR_FUNC");
 
-		program.adjustTypes<Tin, Tout>();
-	}
-	program.build();
+      program.adjustTypes<Tin, Tout>();
+    }
+    program.build();
 
-	return program;
+    return program;
+  });
 }
 
 template <typename Tin, typename Tout>
@@ -59,9 +59,21 @@ int globalIndex(int rowOffset, int colOffset, int SCL_COLS)
 __kernel void SCL_MAPOVERLAP(__global SCL_TYPE_0* SCL_IN,
                              __global SCL_TYPE_1* SCL_OUT,
                              __local SCL_TYPE_1* SCL_SHARED,
-                             const unsigned int SCL_ELEMENTS,
-                             const unsigned int SCL_COLS)
+                             const unsigned int SCL_ELEMENTS_ARG,
+                             const unsigned int SCL_COLS_ARG)
 {
+  // sizes might be compile time constants in a specialized variant
+#ifdef SCL_MAPOVERLAP_ELEMENTS
+  const unsigned int SCL_ELEMENTS = SCL_MAPOVERLAP_ELEMENTS;
+#else
+  const unsigned int SCL_ELEMENTS = SCL_ELEMENTS_ARG;
+#endif
+#ifdef SCL_MAPOVERLAP_COLS
+  const unsigned int SCL_COLS = SCL_MAPOVERLAP_COLS;
+#else
+  const unsigned int SCL_COLS = SCL_COLS_ARG;
+#endif
+
   const unsigned int col = get_global_id(0);
   const unsigned int l_col = get_local_id(0);
   const unsigned int row = get_global_id(1);
@@ -43,6 +43,7 @@
 
 #include <algorithm>
 #include <complex>
+#include <functional>
 #include <ios>
 #include <iterator>
 #include <memory>
@@ -112,7 +113,7 @@ Matrix<T>::Matrix(const std::vector<T>& vector,
     _distribution(detail::cloneAndConvert<Matrix<T>>(distribution)),
     _hostBufferUpToDate(true),
     _deviceBuffersUpToDate(false),
-    _hostBuffer(vector),
+    _hostBuffer(vector.begin(), vector.end()),
     _deviceBuffers()
 {
   (void)registerMatrixDeviceFunctions;
@@ -135,7 +136,7 @@ Matrix<T>::Matrix(const std::vector<T>& vector,
     _distribution(detail::cloneAndConvert<Matrix<T>>(distribution)),
     _hostBufferUpToDate(true),
     _deviceBuffersUpToDate(false),
-    _hostBuffer(vector),
+    _hostBuffer(vector.begin(), vector.end()),
     _deviceBuffers()
 {
   (void)registerMatrixDeviceFunctions;
@@ -238,8 +239,9 @@ Matrix<T>& Matrix<T>::operator=(Matrix<T>&& rhs)
   _distribution           = std::move(rhs._distribution);
   _hostBufferUpToDate     = std::move(rhs._hostBufferUpToDate);
   _deviceBuffersUpToDate  = std::move(rhs._deviceBuffersUpToDate);
-  _hostBuffer             = std::move(rhs._hostBuffer);
+  // release zero copy buffers before their host storage is replaced
   _deviceBuffers          = std::move(rhs._deviceBuffers);
+  _hostBuffer             = std::move(rhs._hostBuffer);
 
   rhs._size = {0,0};
   rhs._hostBufferUpToDate = false;
@@ -370,6 +372,7 @@ template <typename T>
 void Matrix<T>::resize(const size_type& size, T c)
 {
   if (_hostBufferUpToDate) {
+    releaseZeroCopyBuffers();
     _hostBuffer.resize(size.elemCount(), c);
     // device buffers are now invalid
     _deviceBuffers.clear();
@@ -379,6 +382,7 @@ void Matrix<T>::resize(const size_type& size, T c)
     if (_deviceBuffersUpToDate) {
       // copy data down to the host
       copyDataToHost();
+      releaseZeroCopyBuffers();
       // resize host buffer using the provided default value
       _hostBuffer.resize(size.elemCount(), c);
       // device buffers are now invalid
@@ -411,6 +415,7 @@ template <typename T>
 void Matrix<T>::reserve(size_type::size_type bytes)
 {
   // TODO: handling similar to resize ?
+  releaseZeroCopyBuffers();
   return _hostBuffer.reserve(bytes);
 }
 
@@ -501,6 +506,7 @@ template <typename InputIterator>
 void Matrix<T>::assign(InputIterator first, InputIterator last)
 {
   copyDataToHost();
+  releaseZeroCopyBuffers();
 
   _hostBuffer.assign(first, last);
 
@@ -528,6 +534,7 @@ template <typename T>
 void Matrix<T>::assign(size_type size, const T& v )
 {
   copyDataToHost();
+  releaseZeroCopyBuffers();
 
   _hostBuffer.assign(size.rowCount() * size.columnCount(), v);
   _size = size;
@@ -690,7 +697,8 @@ void
   ASSERT(newDistribution->isValid());
 
   if (   _distribution->isValid()
-      && _distribution->dataExchangeOnDistributionChange(*newDistribution)) {
+      && _distribution->dataExchangeOnDistributionChange(*newDistribution)
+      && !redistributeOnDevices(*newDistribution)) {
     copyDataToHost();
     _deviceBuffersUpToDate = false;
     _deviceBuffers.clear(); // delete old device buffers,
@@ -704,12 +712,55 @@ void
                  ") assigned new distribution, now with ", getDebugInfo());
 }
 
+template <typename T>
+void Matrix<T>::releaseZeroCopyBuffers() const
+{
+  // commands using the host buffer as storage of zero copy buffers have to
+  // finish before the host buffer is reallocated (see Device::finish)
+  if (std::none_of(_deviceBuffers.begin(), _deviceBuffers.end(),
+                   [](const std::pair<const detail::Device::id_type,
+                                      detail::DeviceBuffer>& entry) {
+                     return entry.second.hostPointer() != nullptr;
+                   })) {
+    return;
+  }
+  copyDataToHost();
+  _deviceBuffers.clear();
+  _deviceBuffersUpToDate = false;
+}
+
+template <typename T>
+bool Matrix<T>::redistributeOnDevices(
+        const detail::Distribution<Matrix<T>>& newDistribution) const
+{
+  if (!_deviceBuffersUpToDate || _deviceBuffers.empty()) return false;
+
+  // parts might be moved through the host buffer
+  _hostBuffer.resize(_size.elemCount());
+
+  auto& self = const_cast<Matrix<T>&>(*this);
+  std::map<detail::Device::id_type, detail::DeviceBuffer> buffers;
+  if (!_distribution->redistribute(self, newDistribution,
+                                   _hostBufferUpToDate, &buffers)) {
+    return false;
+  }
+  // the old buffers can be released while the copies are pending (see
+  // Device::releaseBuffer)
+  _deviceBuffers = std::move(buffers);
+
+  detail::Event events;
+  newDistribution.startPadding(self, &events);
+
+  LOG_DEBUG_INFO("Redistributed data on devices (", getInfo(), ")");
+  return true;
+}
 
 template <typename T>
 void Matrix<T>::createDeviceBuffers() const
 {
-  // create device buffers only if none have been created so far
-  if (_deviceBuffers.empty()) {
+  // create device buffers only if none have been created so far or if the
+  // host buffer used by zero copy buffers has been reallocated
+  if (_deviceBuffers.empty() || !zeroCopyBuffersValid()) {
     forceCreateDeviceBuffers();
   }
 }
@@ -722,10 +773,27 @@ void Matrix<T>::forceCreateDeviceBuffers() const
 
   _deviceBuffers.clear();
 
+  // zero copy buffers use the host buffer as their storage
+  auto& devices = _distribution->devices();
+  if (   std::any_of(devices.begin(), devices.end(),
+                     [](std::shared_ptr<detail::Device> devicePtr) {
+                       return devicePtr->zeroCopy();
+                     })
+      && _hostBuffer.size() < _size.elemCount()) {
+    _hostBuffer.resize(_size.elemCount());
+  }
+
   std::transform( _distribution->devices().begin(),
                   _distribution->devices().end(),
                   std::inserter(_deviceBuffers, _deviceBuffers.begin()),
         [this](std::shared_ptr<detail::Device> devicePtr) {
+                  size_t offset = 0;
+                  T* hostPointer = nullptr;
+                  if (   devicePtr->zeroCopy()
+                      && this->_distribution->hostOffsetForDevice(
+                              *this, devicePtr, &offset) ) {
+                    hostPointer = this->_hostBuffer.data() + offset;
+                  }
                   return std::make_pair(
                             devicePtr->id(),
                             detail::DeviceBuffer(
@@ -733,12 +801,29 @@ void Matrix<T>::forceCreateDeviceBuffers() const
                               this->_distribution->sizeForDevice(
                                       const_cast<Matrix<T>&>(*this),
                                       devicePtr ),
-                              sizeof(T)
+                              sizeof(T),
+                              hostPointer
                               /*,mem flags*/ )
                          );
         } );
 }
 
+template <typename T>
+bool Matrix<T>::zeroCopyBuffersValid() const
+{
+  const T* first = _hostBuffer.data();
+  const T* last  = first + _hostBuffer.size();
+  for (auto& entry : _deviceBuffers) {
+    auto pointer = static_cast<const T*>(entry.second.hostPointer());
+    if (pointer == nullptr) continue;
+    if (   std::less<const T*>()(pointer, first)
+        || !std::less<const T*>()(pointer, last)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 template <typename T>
 detail::Event Matrix<T>::startUpload() const
 {
@@ -801,6 +886,62 @@ void Matrix<T>::copyDataToHost() const
   }
 }
 
+template <typename T>
+HostView<T> Matrix<T>::hostView(HostAccess access,
+                                size_type::size_type firstRow,
+                                size_type::size_type rowCount) const
+{
+  ASSERT(firstRow + rowCount <= _size.rowCount());
+  bool write  = (access == HostAccess::READ_WRITE);
+  auto first  = firstRow * _size.columnCount();
+  auto count  = rowCount * _size.columnCount();
+
+  if (count == 0) return HostView<T>(nullptr, 0, nullptr);
+
+  if (   !_hostBufferUpToDate && _deviceBuffersUpToDate
+      && _distribution != nullptr && !_deviceBuffers.empty()) {
+    // map the rows from the single device storing them
+    for (auto& devicePtr : _distribution->devices()) {
+      size_t offset = 0;
+      if (!_distribution->hostOffsetForDevice(*this, devicePtr, &offset)) {
+        break;
+      }
+      auto& buffer = _deviceBuffers[devicePtr->id()];
+      if (first < offset || first + count > offset + buffer.size()) continue;
+
+      cl::Event event;
+      auto data = static_cast<T*>(devicePtr->enqueueMap(buffer, write,
+                                                        first - offset, count,
+                                                        &event));
+      detail::Event events;
+      events.insert(event);
+      events.wait();
+
+      LOG_DEBUG_INFO("Mapped ", rowCount, " rows from device ",
+                     devicePtr->id(), " (", getInfo(), ")");
+
+      auto bufferPtr = &buffer;
+      return HostView<T>(data, count, [this, devicePtr, bufferPtr, data,
+                                       write]() {
+        devicePtr->enqueueUnmap(*bufferPtr, data, write);
+        if (write) dataOnDeviceModified();
+      });
+    }
+  }
+
+  // the rows are not stored on a single device => use the host buffer
+  copyDataToHost();
+  return HostView<T>(_hostBuffer.data() + first, count, [this, write]() {
+    if (write) dataOnHostModified();
+  });
+}
+
+template <typename T>
+HostView<T> Matrix<T>::hostView(HostAccess access) const
+{
+  return hostView(access, 0, _size.rowCount());
+}
+
 template <typename T>
 void Matrix<T>::dataOnDeviceModified() const
 {
@@ -77,6 +77,12 @@ public:
 	size_t sizeForDevice(const C<T>& container,
 			const std::shared_ptr<detail::Device>& devicePtr) const;
 
+	bool rangeForDevice(const C<T>& container,
+			const std::shared_ptr<detail::Device>& devicePtr, bool withHalo,
+			size_t* first, size_t* count, size_t* offset) const;
+
+	void startPadding(C<T>& container, Event* events) const;
+
 	bool dataExchangeOnDistributionChange(Distribution<C<T>>& newDistribution);
 
 	const unsigned int& getOverlapRadius() const;
@@ -161,6 +167,30 @@ template <typename T>
 void startDownload(Matrix<T>& vector, Event* events, unsigned int overlapRadius,
                    const detail::DeviceList& devices);
 
+template <typename T>
+bool rangeForDevice(const Vector<T>& vector,
+                    const std::shared_ptr<Device>& devicePtr,
+                    const DeviceList& devices, unsigned int overlapRadius,
+                    bool withHalo, size_t* first, size_t* count,
+                    size_t* offset);
+
+template <typename T>
+bool rangeForDevice(const Matrix<T>& matrix,
+                    const std::shared_ptr<Device>& devicePtr,
+                    const DeviceList& devices, unsigned int overlapRadius,
+                    bool withHalo, size_t* first, size_t* count,
+                    size_t* offset);
+
+template <typename T>
+void startPadding(Vector<T>& vector, Event* events, unsigned int overlapRadius,
+                  detail::Padding padding, const T& neutralElement,
+                  const detail::DeviceList& devices);
+
+template <typename T>
+void startPadding(Matrix<T>& matrix, Event* events, unsigned int overlapRadius,
+                  detail::Padding padding, const T& neutralElement,
+                  const detail::DeviceList& devices);
+
 } // namespace ol_distribution_helper
 
 } // namespace detail
@@ -41,6 +41,9 @@
 #ifndef OL_DISTRIBUTION_DEF_H_
 #define OL_DISTRIBUTION_DEF_H_
 
+#include <algorithm>
+#include <vector>
+
 #include <pvsutil/Logger.h>
 
 namespace skelcl {
@@ -103,6 +106,26 @@ size_t OLDistribution<C<T>>::sizeForDevice(
       devicePtr, container.size(), this->_devices, this->_overlap_radius);
 }
 
+template <template <typename> class C, typename T>
+bool OLDistribution<C<T>>::rangeForDevice(
+    const C<T>& container,
+    const std::shared_ptr<detail::Device>& devicePtr,
+    bool withHalo, size_t* first, size_t* count, size_t* offset) const
+{
+  return ol_distribution_helper::rangeForDevice(
+      container, devicePtr, this->_devices, this->_overlap_radius, withHalo,
+      first, count, offset);
+}
+
+template <template <typename> class C, typename T>
+void OLDistribution<C<T>>::startPadding(C<T>& container, Event* events) const
+{
+  ASSERT(events != nullptr);
+  ol_distribution_helper::startPadding(container, events,
+                                       this->_overlap_radius, this->_padding,
+                                       this->_neutral_element, this->_devices);
+}
+
 template <template <typename> class C, typename T>
 bool OLDistribution<C<T>>::dataExchangeOnDistributionChange(
     Distribution<C<T>>& newDistribution)
@@ -392,6 +415,106 @@ void startDownload(Matrix<T>& matrix, Event* events, unsigned int overlapRadius,
   matrix.dataOnHostModified();
 }
 
+template <typename T>
+bool rangeForDevice(const Vector<T>& /*vector*/,
+                    const std::shared_ptr<Device>& /*devicePtr*/,
+                    const DeviceList& /*devices*/,
+                    unsigned int /*overlapRadius*/,
+                    bool /*withHalo*/, size_t* /*first*/, size_t* /*count*/,
+                    size_t* /*offset*/)
+{
+  // vectors are redistributed through the host
+  return false;
+}
+
+template <typename T>
+bool rangeForDevice(const Matrix<T>& matrix,
+                    const std::shared_ptr<Device>& devicePtr,
+                    const DeviceList& devices, unsigned int overlapRadius,
+                    bool withHalo, size_t* first, size_t* count,
+                    size_t* offset)
+{
+  auto iter = std::find(devices.begin(), devices.end(), devicePtr);
+  if (iter == devices.end()) return false;
+  size_t index = static_cast<size_t>(iter - devices.begin());
+
+  // the rows of the device's part (see startUpload) ...
+  size_t rowCount  = matrix.rowCount();
+  size_t blockSize = rowCount / devices.size();
+  size_t firstRow  = index * blockSize;
+  size_t lastRow   = (index == devices.size() - 1) ? rowCount
+                                                   : firstRow + blockSize;
+  // ... stored after the overlap ...
+  size_t offsetRow = overlapRadius;
+  if (withHalo) {
+    // ... which holds rows of the neighbouring parts, or the padding
+    size_t front = std::min<size_t>(firstRow, overlapRadius);
+    offsetRow -= front;
+    firstRow  -= front;
+    lastRow    = std::min<size_t>(rowCount, lastRow + overlapRadius);
+  }
+
+  auto columnCount = matrix.columnCount();
+  *first  = firstRow * columnCount;
+  *count  = (lastRow - firstRow) * columnCount;
+  *offset = offsetRow * columnCount;
+  return true;
+}
+
+template <typename T>
+void startPadding(Vector<T>& /*vector*/, Event* /*events*/,
+                  unsigned int /*overlapRadius*/,
+                  detail::Padding /*padding*/, const T& /*neutralElement*/,
+                  const detail::DeviceList& /*devices*/)
+{
+  // vectors are redistributed through the host (see rangeForDevice)
+}
+
+template <typename T>
+void startPadding(Matrix<T>& matrix, Event* events, unsigned int overlapRadius,
+                  detail::Padding padding, const T& neutralElement,
+                  const detail::DeviceList& devices)
+{
+  ASSERT(events != nullptr);
+
+  auto columnCount = matrix.columnCount();
+  auto rowSize     = columnCount * sizeof(T);
+
+  auto& firstDevicePtr = devices.front();
+  auto& lastDevicePtr  = devices.back();
+  auto& topBuffer      = matrix.deviceBuffer(*firstDevicePtr);
+  auto& bottomBuffer   = matrix.deviceBuffer(*lastDevicePtr);
+  // first row of the bottom padding inside the buffer of the last device
+  size_t bottomRow     = bottomBuffer.size() / columnCount - overlapRadius;
+
+  if (padding == detail::Padding::NEUTRAL) {
+    std::vector<T> paddingRows(overlapRadius * columnCount, neutralElement);
+    events->insert(firstDevicePtr->enqueueWrite(topBuffer,
+                                                paddingRows.begin(),
+                                                paddingRows.size(), 0));
+    events->insert(lastDevicePtr->enqueueWrite(bottomBuffer,
+                                               paddingRows.begin(),
+                                               paddingRows.size(),
+                                               bottomRow * columnCount));
+    // wait for the data transfers to finish before releasing the memory of
+    // paddingRows
+    events->wait();
+  }
+
+  if (padding == detail::Padding::NEAREST) {
+    // copy the first and the last row of the matrix into the padding
+    for (size_t i = 0; i < overlapRadius; ++i) {
+      events->insert(firstDevicePtr->enqueueCopy(topBuffer, topBuffer,
+                                                 overlapRadius * rowSize,
+                                                 i * rowSize, rowSize));
+      events->insert(lastDevicePtr->enqueueCopy(bottomBuffer, bottomBuffer,
+                                                (bottomRow - 1) * rowSize,
+                                                (bottomRow + i) * rowSize,
+                                                rowSize));
+    }
+  }
+}
+
 } // namespace ol_distribution_helper
 
 } // namespace detail
@@ -0,0 +1,135 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file PinnedAllocator.h
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#ifndef PINNED_ALLOCATOR_H_
+#define PINNED_ALLOCATOR_H_
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <utility>
+
+#include "PinnedMemoryPool.h"
+
+namespace skelcl {
+
+namespace detail {
+
+///
+/// \class PinnedAllocator
+///
+/// \brief Standard conforming allocator obtaining its memory from the
+///        globalPinnedMemoryPool.
+///
+/// The host buffers of Vector and Matrix use this allocator, so that they
+/// are placed in pinned memory when the pool is enabled. Otherwise, it
+/// behaves like std::allocator.
+///
+template <typename T>
+class PinnedAllocator {
+public:
+  typedef T               value_type;
+  typedef T*              pointer;
+  typedef const T*        const_pointer;
+  typedef T&              reference;
+  typedef const T&        const_reference;
+  typedef std::size_t     size_type;
+  typedef std::ptrdiff_t  difference_type;
+
+  template <typename U>
+  struct rebind {
+    typedef PinnedAllocator<U> other;
+  };
+
+  PinnedAllocator() {}
+
+  template <typename U>
+  PinnedAllocator(const PinnedAllocator<U>&) {}
+
+  pointer address(reference x) const { return &x; }
+
+  const_pointer address(const_reference x) const { return &x; }
+
+  pointer allocate(size_type n, const void* /*hint*/ = nullptr)
+  {
+    if (n > max_size()) throw std::bad_alloc();
+    return static_cast<pointer>(
+        globalPinnedMemoryPool.allocate(n * sizeof(T)));
+  }
+
+  void deallocate(pointer p, size_type n)
+  {
+    globalPinnedMemoryPool.deallocate(p, n * sizeof(T));
+  }
+
+  size_type max_size() const
+  {
+    return std::numeric_limits<size_type>::max() / sizeof(T);
+  }
+
+  template <typename U, typename... Args>
+  void construct(U* p, Args&&... args)
+  {
+    ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...);
+  }
+
+  template <typename U>
+  void destroy(U* p)
+  {
+    p->~U();
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const PinnedAllocator<T>&, const PinnedAllocator<U>&)
+{
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const PinnedAllocator<T>&, const PinnedAllocator<U>&)
+{
+  return false;
+}
+
+} // namespace detail
+
+} // namespace skelcl
+
+#endif // PINNED_ALLOCATOR_H_
@@ -0,0 +1,172 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file PinnedMemoryPool.h
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#ifndef PINNED_MEMORY_POOL_H_
+#define PINNED_MEMORY_POOL_H_
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+#define __CL_ENABLE_EXCEPTIONS
+#include <CL/cl.hpp>
+#undef  __CL_ENABLE_EXCEPTIONS
+
+#include "skelclDll.h"
+
+namespace skelcl {
+
+namespace detail {
+
+///
+/// \class PinnedMemoryPool
+///
+/// \brief Provides host memory which is pinned (page-locked), so that the
+///        devices can access it directly by DMA.
+///
+/// Transfers from pageable host memory have to go through a staging copy
+/// inside the OpenCL driver. The memory handed out by this pool is backed by
+/// OpenCL buffers allocated with CL_MEM_ALLOC_HOST_PTR and mapped into the
+/// host address space, which avoids this copy.
+///
+/// Pinning memory is expensive, therefore, the pool keeps released chunks
+/// (up to maxCachedBytes()) and reuses them for later allocations of similar
+/// size. Allocations smaller than minAllocation() and allocations while the
+/// pool is disabled or no device is initialized are served from the regular
+/// heap. Heap allocations of at least a page are aligned to the page size,
+/// so that OpenCL buffers can be created over them without copying (see
+/// DeviceBuffer).
+///
+/// The pool is disabled by default. It is enabled by setting the environment
+/// variable SKELCL_PINNED to YES or by calling setEnabled().
+///
+class SKELCL_DLL PinnedMemoryPool {
+public:
+  PinnedMemoryPool();
+
+  PinnedMemoryPool(const PinnedMemoryPool&) = delete;
+
+  PinnedMemoryPool& operator=(const PinnedMemoryPool&) = delete;
+
+  ~PinnedMemoryPool();
+
+  ///
+  /// \brief Enables or disables pinned allocations. Memory allocated before
+  ///        is not affected.
+  ///
+  void setEnabled(bool enabled);
+
+  bool isEnabled() const;
+
+  ///
+  /// \brief Sets the size in bytes below which the regular heap is used
+  ///
+  void setMinAllocation(size_t bytes);
+
+  size_t minAllocation() const;
+
+  ///
+  /// \brief Sets the maximum number of bytes held by released chunks
+  ///
+  void setMaxCachedBytes(size_t bytes);
+
+  size_t maxCachedBytes() const;
+
+  ///
+  /// \brief Allocates the given number of bytes
+  ///
+  void* allocate(size_t bytes);
+
+  ///
+  /// \brief Releases memory obtained from allocate() for the given number of
+  ///        bytes
+  ///
+  void deallocate(void* pointer, size_t bytes);
+
+  ///
+  /// \brief Returns if the given pointer has been allocated as pinned memory
+  ///
+  bool isPinned(const void* pointer) const;
+
+  ///
+  /// \brief Returns the number of bytes held by released chunks
+  ///
+  size_t cachedBytes() const;
+
+  ///
+  /// \brief Frees all released chunks and detaches the pool from the current
+  ///        devices. Memory still in use stays valid.
+  ///
+  void clear();
+
+private:
+  struct Chunk {
+    Chunk();
+
+    Chunk(const Chunk&) = default;
+
+    Chunk& operator=(const Chunk&) = default;
+
+    cl::Buffer        buffer;
+    cl::CommandQueue  queue;   // used to map and unmap the buffer
+    void*             pointer;
+    size_t            size;
+  };
+
+  void release(const Chunk& chunk) const;
+
+  mutable std::mutex              _mutex;
+  // read without locking, so that heap allocations never wait for the mutex
+  std::atomic<bool>               _enabled;
+  std::atomic<size_t>             _minAllocation;
+  std::atomic<size_t>             _pinnedChunks; // number of chunks in use
+  size_t                          _maxCachedBytes;
+  size_t                          _cachedBytes;
+  cl::CommandQueue                _queue;
+  std::map<void*, Chunk>          _used;
+  std::multimap<size_t, Chunk>    _free;
+};
+
+SKELCL_DLL extern PinnedMemoryPool globalPinnedMemoryPool;
+
+} // namespace detail
+
+} // namespace skelcl
+
+#endif // PINNED_MEMORY_POOL_H_
@@ -0,0 +1,180 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file Profiler.h
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define __CL_ENABLE_EXCEPTIONS
+#include <CL/cl.hpp>
+#undef  __CL_ENABLE_EXCEPTIONS
+
+#include "skelclDll.h"
+
+namespace skelcl {
+
+namespace detail {
+
+///
+/// \class Profiler
+///
+/// \brief Records the commands issued to the devices and writes a timeline
+///        of them in the Chrome trace event format.
+///
+/// The profiler is disabled by default. It is enabled by setting the
+/// environment variable SKELCL_PROFILE to the name of the trace file (or to
+/// YES to use skelcl_trace.json) or by calling enable() prior to
+/// skelcl::init(), as the command queues of the devices have to be created
+/// with profiling enabled.
+///
+/// For every kernel execution, write, read and copy the times the command
+/// was queued, submitted, started and ended are recorded together with the
+/// device, the skeleton and kernel name and the number of bytes or the
+/// NDRange. skelcl::terminate() writes the trace file, which can be viewed
+/// with chrome://tracing. Every device is shown as a process with one
+/// thread per command queue.
+///
+class SKELCL_DLL Profiler {
+public:
+  enum Command { KERNEL, WRITE, READ, COPY };
+
+  Profiler();
+
+  Profiler(const Profiler&) = delete;
+
+  Profiler& operator=(const Profiler&) = delete;
+
+  ~Profiler();
+
+  ///
+  /// \brief Enables profiling. The trace is written to the given file.
+  ///
+  void enable(const std::string& fileName = "skelcl_trace.json");
+
+  ///
+  /// \brief Disables profiling and discards all recorded commands
+  ///
+  void disable();
+
+  ///
+  /// \brief Returns if profiling is enabled
+  ///
+  bool isEnabled() const;
+
+  ///
+  /// \brief Returns the name of the file the trace is written to
+  ///
+  std::string fileName() const;
+
+  ///
+  /// \brief Registers the name of the device with the given id, which is
+  ///        shown in the trace
+  ///
+  void addDevice(size_t deviceId, const std::string& name);
+
+  ///
+  /// \brief Records a command enqueued on a device
+  ///
+  /// \param command  The kind of the command
+  ///        deviceId The id of the device the command is enqueued on
+  ///        event    The event associated with the command. The command
+  ///                 queue has to be created with profiling enabled.
+  ///        name     The kernel name (only used for kernels)
+  ///        bytes    The number of bytes transferred (0 for kernels)
+  ///        range    The global and local NDRange (only used for kernels)
+  ///
+  void record(Command command, size_t deviceId, const cl::Event& event,
+              const std::string& name, size_t bytes,
+              const std::string& range);
+
+  ///
+  /// \brief Returns the number of recorded commands
+  ///
+  size_t size() const;
+
+  ///
+  /// \brief Writes all recorded commands in the Chrome trace event format
+  ///        to the given stream. Waits for the commands to finish.
+  ///
+  void writeTrace(std::ostream& stream) const;
+
+  ///
+  /// \brief Writes all recorded commands to the trace file and discards
+  ///        them afterwards. Nothing is written if profiling is disabled.
+  ///
+  void writeTrace();
+
+  ///
+  /// \brief Discards all recorded commands
+  ///
+  void clear();
+
+private:
+  typedef std::chrono::steady_clock clock_type;
+
+  struct Record {
+    Command                 command;
+    size_t                  deviceId;
+    cl::Event               event;
+    std::string             name;
+    size_t                  bytes;
+    std::string             range;
+    clock_type::time_point  enqueued;
+  };
+
+  mutable std::mutex              _mutex;
+  bool                            _enabled;
+  std::string                     _fileName;
+  std::map<size_t, std::string>   _devices;
+  std::vector<Record>             _records;
+};
+
+SKELCL_DLL extern Profiler globalProfiler;
+
+} // namespace detail
+
+} // namespace skelcl
+
+#endif // PROFILER_H_
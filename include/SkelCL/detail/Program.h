@@ -40,17 +40,23 @@
 #ifndef PROGRAM_H_
 #define PROGRAM_H_
 
+#include <future>
 #include <string>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #define __CL_ENABLE_EXCEPTIONS
 #include <CL/cl.hpp>
 #undef  __CL_ENABLE_EXCEPTIONS
 
+#include <pvsutil/Timer.h>
+
 #include <stooling/SourceCode.h>
 
 #include "Device.h"
+#include "KernelCache.h"
 #include "Util.h"
 #include "skelclDll.h"
 
@@ -60,6 +66,40 @@ namespace detail {
 
 class SKELCL_DLL Program {
 public:
+  typedef std::shared_ptr<Program> ptr_type;
+
+  ///
+  /// \brief Values a kernel is specialized for, i.e. names of macros and the
+  ///        values they are defined to when compiling a variant
+  ///
+  typedef std::map<std::string, size_t> Constants;
+
+  ///
+  /// \brief Times (in milliseconds) spent in the phases of creating and
+  ///        building a program, together with the outcome of the cache
+  ///        lookups
+  ///
+  struct SKELCL_DLL BuildTimings {
+    typedef pvsutil::Timer::time_type time_type;
+
+    BuildTimings();
+
+    /// source code transformations with stooling
+    time_type rewrite;
+    /// creating the OpenCL programs from source or from binaries
+    time_type create;
+    /// building the program, summed up for all devices
+    time_type build;
+    /// storing the built binaries in the program cache
+    time_type saveBinary;
+    /// number of devices the program has been built for
+    size_t    builtDevices;
+    /// true if the binaries have been loaded from the program cache
+    bool      binaryCacheHit;
+    /// true if the transformed source has been loaded from the program cache
+    bool      sourceCacheHit;
+  };
+
   Program() = delete;
 
   Program(const std::string& source, const std::string& hash = "");
@@ -87,16 +127,134 @@ public:
   template<typename Head, typename ...Tail>
   void adjustTypes();
 
+  ///
+  /// \brief Loads the binaries of the program from the cache (see
+  ///        ProgramCache). The program is built from source for the devices
+  ///        without a binary, therefore, the (transformed) source has to be
+  ///        provided if not all binaries are available.
+  ///
+  /// \return True, if the binaries for all devices have been loaded
+  ///
   bool loadBinary();
 
+  ///
+  /// \brief Loads the transformed source code of the program from the cache
+  ///
+  /// \return True, if the source has been found
+  ///
+  bool loadSource();
+
+  ///
+  /// \brief Prepares building the program. The program is built for a device
+  ///        lazily in the background, once a kernel for this device is
+  ///        requested for the first time. Therefore, a program is only built
+  ///        for the devices a skeleton actually runs on.
+  ///
   void build();
 
-  cl::Kernel kernel(const Device& device, const std::string& name) const;
+  ///
+  /// \brief Returns true if the program is built for all devices
+  ///
+  bool isBuilt() const;
+
+  ///
+  /// \brief Builds the program for all devices and blocks until the builds
+  ///        have finished. Aborts if the program could not be built.
+  ///
+  void wait() const;
+
+  ///
+  /// \brief Starts building the program for all devices in the background
+  ///        and returns immediately. The programs for different devices are
+  ///        built concurrently.
+  ///
+  void startBuilds() const;
+
+  ///
+  /// \brief Starts building the program for all devices in the background,
+  ///        where the programs for different devices are built concurrently.
+  ///
+  /// \return A handle to wait for all builds, e.g. together with other work
+  ///
+  std::shared_future<void> buildHandle() const;
+
+  ///
+  /// \brief Returns the kernel with the given name for the given device. The
+  ///        program is built for the device first if required.
+  ///
+  /// Kernel objects are cached. The returned kernel is reserved for the
+  /// caller until the returned object is destroyed.
+  ///
+  CachedKernel kernel(const Device& device, const std::string& name) const;
+
+  ///
+  /// \brief Returns the kernel with the given name for the given device from
+  ///        a variant of the program compiled with the given constants
+  ///        defined as macros.
+  ///
+  /// Variants are only compiled in the specialization mode (see
+  /// setMaxVariants). They are cached per combination of values, but at most
+  /// maxVariants() variants are created per program. Otherwise, the kernel of
+  /// the generic program is returned, which has to handle the values at
+  /// runtime, therefore, the values still have to be passed as arguments.
+  ///
+  CachedKernel kernel(const Device& device, const std::string& name,
+                      const Constants& constants) const;
+
+  ///
+  /// \brief Sets the maximum number of specialized variants per program.
+  ///        0 disables the specialization mode.
+  ///
+  /// The default is read from the environment variable SKELCL_SPECIALIZE,
+  /// which is either YES, NO, or the maximum number of variants.
+  ///
+  static void setMaxVariants(size_t maxVariants);
+
+  ///
+  /// \brief Returns the maximum number of specialized variants per program
+  ///
+  static size_t maxVariants();
+
+  ///
+  /// \brief Returns the times spent creating and building this program so far
+  ///
+  /// Builds are started lazily per device, therefore, the build times only
+  /// cover the devices the program has been built for until now.
+  ///
+  BuildTimings timings() const;
+
+  ///
+  /// \brief Returns the hash of the program source, which identifies the
+  ///        program. Empty, if the program has been created without a hash.
+  ///
+  const std::string& hash() const;
 
 private:
-  void createProgramsFromSource();
+  struct Timings {
+    Timings();
+
+    void add(BuildTimings::time_type BuildTimings::* phase,
+             BuildTimings::time_type time);
+
+    std::mutex    mutex;
+    BuildTimings  values;
+  };
+
+  const Program* variant(const Constants& constants) const;
+
+  bool loadBinary(const Device& device);
+
+  cl::Program createProgramFromSource(const Device& device) const;
+
+  std::shared_future<void> startBuild(const Device& device) const;
+
+  void waitForBuild(const Device& device,
+                    const std::shared_future<void>& build) const;
 
-  void saveBinary();
+  static void saveBinary(const std::string& hash,
+                         const std::string& buildOptions,
+                         const Device& device,
+                         const cl::Program& clProgram);
 
   void renameType(const int i, const std::string& name);
 
@@ -108,7 +266,17 @@ private:
 
   stooling::SourceCode      _source;
   std::string               _hash;
-  std::vector<cl::Program>  _clPrograms;
+  std::string               _buildOptions;
+  // one program per device, created lazily for devices without binary
+  mutable std::vector<cl::Program>  _clPrograms;
+  // false if binaries have been loaded for all devices, then the source has
+  // not been transformed
+  bool                      _sourceAvailable;
+  std::unique_ptr<std::mutex>                   _buildMutex;
+  mutable std::vector<std::shared_future<void>> _builds;
+  std::shared_ptr<KernelCache>                  _kernels;
+  mutable std::map<std::string, ptr_type>       _variants;
+  std::shared_ptr<Timings>                      _timings;
 };
 
 // function template definitions
@@ -0,0 +1,248 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file ProgramCache.h
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#ifndef PROGRAM_CACHE_H_
+#define PROGRAM_CACHE_H_
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "skelclDll.h"
+
+namespace skelcl {
+
+namespace detail {
+
+class Device;
+
+///
+/// \class ProgramCache
+///
+/// \brief A persistent, content-addressed on-disk cache for build artifacts
+///        like OpenCL program binaries.
+///
+/// Every artifact is stored as a single file named after its key inside the
+/// cache root directory. An index file next to the artifacts records the size
+/// of every entry and when it was used last, as the value of a use counter
+/// which is incremented on every load and store. Whenever the total size
+/// exceeds the configured limit the least recently used entries are evicted.
+/// Artifacts and the index are written to a temporary file first which is then
+/// renamed, so that concurrent processes never observe partially written
+/// files.
+///
+/// Besides the device specific binaries the cache stores the OpenCL source
+/// code produced by the source-to-source transformations of a program. This
+/// source is device independent and kept in memory as well, so that a missing
+/// binary (e.g. after a driver update or for a new device) only requires the
+/// OpenCL build but not another run of the transformations.
+///
+/// The cache is enabled by default. It is configured by the following
+/// environment variables, which are read when the cache is first used:
+///   SKELCL_CACHE          set to NO to disable the cache
+///   SKELCL_CACHE_DIR      root directory of the cache
+///                         (default: $XDG_CACHE_HOME/skelcl or
+///                                   $HOME/.cache/skelcl)
+///   SKELCL_CACHE_SIZE_MB  upper bound of the cache size in megabytes
+///
+class SKELCL_DLL ProgramCache {
+public:
+  ProgramCache();
+
+  ProgramCache(const ProgramCache&) = delete;
+
+  ProgramCache& operator=(const ProgramCache&) = delete;
+
+  ~ProgramCache();
+
+  ///
+  /// \brief Returns if the cache is enabled, i.e. if artifacts are loaded
+  ///        from and stored on disk
+  ///
+  bool isEnabled();
+
+  ///
+  /// \brief Enables or disables the cache. The cache can only be enabled if
+  ///        a root directory is set.
+  ///
+  void setEnabled(bool enabled);
+
+  ///
+  /// \brief Returns the root directory of the cache
+  ///
+  std::string root();
+
+  ///
+  /// \brief Sets the root directory of the cache, which is created if
+  ///        required. The index of the previous root is written before.
+  ///        The cache is disabled if the directory can not be created.
+  ///
+  void setRoot(const std::string& root);
+
+  ///
+  /// \brief Returns the upper bound of the cache size in bytes
+  ///
+  size_t maxSize();
+
+  ///
+  /// \brief Sets the upper bound of the cache size in bytes. The least
+  ///        recently used entries are evicted right away if the cache is
+  ///        larger.
+  ///
+  void setMaxSize(size_t bytes);
+
+  ///
+  /// \brief Computes the key of a program binary
+  ///
+  /// \param hash    Hash of the program source
+  ///        device  The device the binary is built for
+  ///        options The options passed to the OpenCL compiler
+  ///
+  /// \return A key identifying the binary, which takes the platform, the
+  ///         device and its driver version as well as the build options into
+  ///         account
+  ///
+  static std::string binaryKey(const std::string& hash,
+                               const Device& device,
+                               const std::string& options);
+
+  ///
+  /// \brief Computes the key of the transformed source code of a program
+  ///
+  /// \param hash Hash of the program source
+  ///
+  static std::string sourceKey(const std::string& hash);
+
+  ///
+  /// \brief Loads the transformed source code of the program with the given
+  ///        hash, either from memory or from disk
+  ///
+  /// \param hash   Hash of the program source
+  ///        source Pointer to a string receiving the transformed source
+  ///
+  /// \return True, if the source was found. False otherwise
+  ///
+  bool loadSource(const std::string& hash, std::string* source);
+
+  ///
+  /// \brief Stores the transformed source code of the program with the given
+  ///        hash in memory and on disk
+  ///
+  /// \param hash   Hash of the program source
+  ///        source The transformed source code
+  ///
+  void storeSource(const std::string& hash, const std::string& source);
+
+  ///
+  /// \brief Loads the artifact stored under the given key
+  ///
+  /// \param key  The key of the artifact
+  ///        data Pointer to a string receiving the content of the artifact
+  ///
+  /// \return True, if the artifact was found. False otherwise
+  ///
+  bool load(const std::string& key, std::string* data);
+
+  ///
+  /// \brief Stores the given artifact under the given key. The least
+  ///        recently used entries are evicted if the cache gets too large.
+  ///
+  /// \param key  The key of the artifact
+  ///        data The content of the artifact
+  ///
+  void store(const std::string& key, const std::string& data);
+
+  ///
+  /// \brief Removes the artifact stored under the given key, e.g. because it
+  ///        turned out to be unusable
+  ///
+  /// \param key The key of the artifact
+  ///
+  void remove(const std::string& key);
+
+  ///
+  /// \brief Removes all artifacts from the cache, on disk as well as the
+  ///        sources kept in memory
+  ///
+  void clear();
+
+  ///
+  /// \brief Writes pending updates of the index to disk, i.e. the uses of the
+  ///        entries loaded since the index was written last.
+  ///        skelcl::terminate() flushes the global cache.
+  ///
+  void flush();
+
+private:
+  struct Entry {
+    size_t              size;
+    unsigned long long  lastUse; // value of the use counter at the last use
+  };
+
+  void initialize();
+
+  std::string path(const std::string& key) const;
+
+  std::string indexPath() const;
+
+  void readIndex();
+
+  void writeIndex();
+
+  void evict();
+
+  std::mutex                    _mutex;
+  bool                          _initialized;
+  bool                          _enabled;
+  std::string                   _root;
+  size_t                        _maxSize;
+  bool                          _indexModified;
+  unsigned long long            _useCount;
+  std::map<std::string, Entry>  _index;
+  std::map<std::string, std::string> _sources;
+};
+
+SKELCL_DLL extern ProgramCache globalProgramCache;
+
+} // namespace detail
+
+} // namespace skelcl
+
+#endif // PROGRAM_CACHE_H_
+
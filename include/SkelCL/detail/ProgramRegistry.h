@@ -0,0 +1,141 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file ProgramRegistry.h
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#ifndef PROGRAM_REGISTRY_H_
+#define PROGRAM_REGISTRY_H_
+
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Program.h"
+#include "skelclDll.h"
+
+namespace skelcl {
+
+namespace detail {
+
+///
+/// \class ProgramRegistry
+///
+/// \brief Process-wide registry of built programs.
+///
+/// Skeletons constructed from the same source, function name(s) and element
+/// types end up with identical OpenCL programs. The registry makes sure such
+/// a program is created and built only once and is then shared by all
+/// skeleton instances requesting it. The registry is safe to be used from
+/// multiple threads. If two threads request the same program concurrently,
+/// one builds it and the other waits for the build to complete.
+///
+/// Programs are kept alive until the registry is cleared by
+/// skelcl::terminate(), because they depend on the OpenCL contexts of the
+/// devices currently in use.
+///
+class SKELCL_DLL ProgramRegistry {
+public:
+  ProgramRegistry();
+
+  ProgramRegistry(const ProgramRegistry&) = delete;
+
+  ProgramRegistry& operator=(const ProgramRegistry&) = delete;
+
+  ~ProgramRegistry();
+
+  ///
+  /// \brief Returns the program registered under the given key. If no program
+  ///        is registered so far create is called to create and build it.
+  ///
+  /// \param key    A hash uniquely identifying the final program, i.e. it has
+  ///               to take every input of the source code transformations
+  ///               into account
+  ///        create Function creating and building the program
+  ///
+  /// \return A shared pointer to the built program
+  ///
+  Program::ptr_type lookupOrCreate(const std::string& key,
+                                   const std::function<Program()>& create);
+
+  ///
+  /// \brief Starts building all registered programs for all devices in the
+  ///        background and returns immediately
+  ///
+  void startAll();
+
+  ///
+  /// \brief Blocks until all registered programs are built
+  ///
+  void waitForAll();
+
+  ///
+  /// \brief Returns the build timings of all registered programs, which have
+  ///        been created so far, by their keys
+  ///
+  std::map<std::string, Program::BuildTimings> timings();
+
+  ///
+  /// \brief Logs a summary of the build timings of all registered programs
+  ///
+  void logTimings();
+
+  ///
+  /// \brief Returns the number of registered programs
+  ///
+  size_t size();
+
+  ///
+  /// \brief Releases all registered programs
+  ///
+  void clear();
+
+private:
+  std::mutex                                                 _mutex;
+  std::map<std::string, std::shared_future<Program::ptr_type>> _programs;
+};
+
+SKELCL_DLL extern ProgramRegistry globalProgramRegistry;
+
+} // namespace detail
+
+} // namespace skelcl
+
+#endif // PROGRAM_REGISTRY_H_
+
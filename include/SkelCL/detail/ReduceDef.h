@@ -47,6 +47,7 @@
 #include <iostream>
 #include <istream>
 #include <iterator>
+#include <map>
 #include <numeric>
 #include <sstream>
 #include <string>
@@ -70,6 +71,7 @@
 #include "DeviceList.h"
 #include "KernelUtil.h"
 #include "Program.h"
+#include "ProgramRegistry.h"
 #include "Skeleton.h"
 #include "Util.h"
 
@@ -80,7 +82,7 @@ template <typename T>
 Reduce<T(T)>::Reduce(const Source& source, const std::string& id,
                      const std::string& funcName)
   : detail::Skeleton(), _id(id), _funcName(funcName), _userSource(source),
-    _program{createPrepareAndBuildProgram()}
+    _program{createPrepareAndBuildProgram()}, _scratchBuffers()
 {
 }
 
@@ -104,21 +106,23 @@ Vector<T>& Reduce<T(T)>::operator()(Out<Vector<T>> output,
   ASSERT(input.distribution().devices().size() == 1);
 
   // TODO: relax to multiple devices later
-  auto &device = *(input.distribution().devices().front());
+  auto& devicePtr = input.distribution().devices().front();
+  auto& device    = *devicePtr;
 
-  Vector<T> tmpOutput;
-  prepareOutput(tmpOutput, input, global_size);
-  prepareOutput(output.container(), tmpOutput, 1);
+  auto& tmpOutput = scratchBuffer(devicePtr, global_size);
+  prepareOutput(output.container(), input, 1);
 
-  execute_first_step(device, input.deviceBuffer(device),
-                     tmpOutput.deviceBuffer(device), input.size(), global_size,
-                     args...);
+  // both steps share one specialized variant of the program
+  auto specialization = constantsFor(device, input.size(), global_size);
+
+  execute_first_step(device, input.deviceBuffer(device), tmpOutput,
+                     input.size(), global_size, specialization, args...);
 
   size_t new_data_size = std::min(global_size, input.size());
 
-  execute_second_step(device, tmpOutput.deviceBuffer(device),
+  execute_second_step(device, tmpOutput,
                       output.container().deviceBuffer(device), new_data_size,
-                      args...);
+                      specialization, args...);
 
   // ... finally update modification status.
   updateModifiedStatus(output, std::forward<Args>(args)...);
@@ -159,17 +163,53 @@ void Reduce<T(T)>::prepareOutput(Vector<T>& output, const Vector<T>& input,
   output.createDeviceBuffers();
 }
 
+template <typename T>
+detail::DeviceBuffer&
+  Reduce<T(T)>::scratchBuffer(const detail::Device::ptr_type& devicePtr,
+                              size_t size)
+{
+  // the buffer of a previous call can be reused right away, as the device
+  // orders the new kernels after the ones still accessing it
+  auto& buffer = _scratchBuffers[devicePtr->id()];
+  if (buffer.devicePtr() != devicePtr || buffer.size() < size) {
+    buffer = detail::DeviceBuffer(devicePtr, size, sizeof(T));
+  }
+  return buffer;
+}
+
+template <typename T>
+detail::Program::Constants
+  Reduce<T(T)>::constantsFor(const detail::Device& device,
+                             size_t data_size, size_t global_size)
+{
+  detail::Program::Constants constants{
+    {"SCL_REDUCE_1_DATA_SIZE", data_size} };
+  // the global size is only adjusted by the first step, if it is smaller
+  // than the local size, which is bounded by the maximum work-group size
+  if (global_size >= device.maxWorkGroupSize()) {
+    constants["SCL_REDUCE_1_GLOBAL_SIZE"] = global_size;
+  }
+  // the second step reduces the results of the first one
+  const size_t second_size = std::min(global_size, data_size);
+  constants["SCL_REDUCE_2_DATA_SIZE"]  = second_size;
+  constants["SCL_REDUCE_2_LOCAL_SIZE"] =
+      std::min(second_size, device.maxWorkGroupSize());
+  return constants;
+}
+
 template <typename T>
 template <typename... Args>
 void Reduce<T(T)>::execute_first_step(const detail::Device& device,
                                       const detail::DeviceBuffer& input,
                                       detail::DeviceBuffer& output,
                                       size_t data_size, size_t global_size,
+                                      const detail::Program::Constants&
+                                        constants,
                                       Args&&... args)
 {
   try
   {
-    cl::Kernel kernel = _program.kernel(device, "SCL_REDUCE_1");
+    auto kernel = _program->kernel(device, "SCL_REDUCE_1", constants);
 
     const size_t max_local_size =
         kernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device.clDevice());
@@ -189,12 +229,9 @@ void Reduce<T(T)>::execute_first_step(const detail::Device& device,
                                                    output.clBuffer(),
                                                    std::forward<Args>(args)...);
 
-    // after finishing the kernel invoke this function ...
-    auto invokeAfter = [keepAlive]() {};
-
     device.enqueue(kernel, cl::NDRange(global_size), cl::NDRange(local_size),
                    cl::NullRange, // offset
-                   invokeAfter);
+                   keepAlive);
   }
   catch (cl::Error& err)
   {
@@ -207,15 +244,27 @@ template <typename... Args>
 void Reduce<T(T)>::execute_second_step(const detail::Device& device,
                                        const detail::DeviceBuffer& input,
                                        detail::DeviceBuffer& output,
-                                       size_t data_size, Args&&... args)
+                                       size_t data_size,
+                                       const detail::Program::Constants&
+                                         constants,
+                                       Args&&... args)
 {
   try
   {
-    cl::Kernel kernel = _program.kernel(device, "SCL_REDUCE_2");
-
-    const size_t max_local_size =
-        kernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device.clDevice());
-    const size_t local_size = std::min(data_size, max_local_size);
+    const size_t expected_local_size =
+        std::min(data_size, device.maxWorkGroupSize());
+    ASSERT(constants.at("SCL_REDUCE_2_DATA_SIZE") == data_size);
+    auto kernel = _program->kernel(device, "SCL_REDUCE_2", constants);
+
+    size_t local_size = std::min(data_size,
+        kernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device.clDevice()));
+    if (local_size != expected_local_size) {
+      // the kernel can not be launched with the local size it has been
+      // specialized for, fall back to the generic kernel
+      kernel = _program->kernel(device, "SCL_REDUCE_2");
+      local_size = std::min(data_size,
+        kernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device.clDevice()));
+    }
 
     kernel.setArg(0, input.clBuffer());
     kernel.setArg(1, output.clBuffer());
@@ -230,13 +279,10 @@ void Reduce<T(T)>::execute_second_step(const detail::Device& device,
                                                    output.clBuffer(),
                                                    std::forward<Args>(args)...);
 
-    // after finishing the kernel invoke this function ...
-    auto invokeAfter = [keepAlive]() {};
-
     ASSERT(local_size <= data_size);
     device.enqueue(kernel, cl::NDRange(local_size), cl::NDRange(local_size),
                    cl::NullRange, // offset
-                   invokeAfter);
+                   keepAlive);
   }
   catch (cl::Error& err)
   {
@@ -245,7 +291,7 @@ void Reduce<T(T)>::execute_second_step(const detail::Device& device,
 }
 
 template <typename T>
-skelcl::detail::Program Reduce<T(T)>::createPrepareAndBuildProgram()
+skelcl::detail::Program::ptr_type Reduce<T(T)>::createPrepareAndBuildProgram()
 {
   ASSERT_MESSAGE(!_userSource.empty(),
                  "Tried to create program with empty user source.");
@@ -258,20 +304,23 @@ skelcl::detail::Program Reduce<T(T)>::createPrepareAndBuildProgram()
 #include "ReduceKernel.cl"
       );
 
-  auto program =
-      detail::Program(s, skelcl::detail::util::hash("//Reduce\n" + s));
-  if (!program.loadBinary()) {
-    // append parameters from user function to kernels
-    program.transferParameters(_funcName, 2, "SCL_REDUCE_1");
-    program.transferParameters(_funcName, 2, "SCL_REDUCE_2");
-    program.transferArguments(_funcName, 2, "SCL_FUNC");
-    // rename user function
-    program.renameFunction(_funcName, "SCL_FUNC");
-    // rename typedefs
-    program.adjustTypes<T>();
-  }
-  program.build();
-  return program;
+  auto hash = detail::util::hash("//Reduce\n" + s + _funcName
+                                 + detail::util::typeNames<T>());
+  return detail::globalProgramRegistry.lookupOrCreate(hash, [&] {
+    auto program = detail::Program(s, hash);
+    if (!program.loadBinary() && !program.loadSource()) {
+      // append parameters from user function to kernels
+      program.transferParameters(_funcName, 2, "SCL_REDUCE_1");
+      program.transferParameters(_funcName, 2, "SCL_REDUCE_2");
+      program.transferArguments(_funcName, 2, "SCL_FUNC");
+      // rename user function
+      program.renameFunction(_funcName, "SCL_FUNC");
+      // rename typedefs
+      program.adjustTypes<T>();
+    }
+    program.build();
+    return program;
+  });
 }
 
 template <typename T>
@@ -51,9 +51,21 @@ typedef float SCL_TYPE_0;
 __kernel void SCL_REDUCE_1 (
     const __global SCL_TYPE_0* SCL_IN,
           __global SCL_TYPE_0* SCL_OUT,
-    const unsigned int  DATA_SIZE,
-    const unsigned int  GLOBAL_SIZE) 
+    const unsigned int  DATA_SIZE_ARG,
+    const unsigned int  GLOBAL_SIZE_ARG) 
 {
+    // sizes might be compile time constants in a specialized variant
+#ifdef SCL_REDUCE_1_DATA_SIZE
+    const unsigned int DATA_SIZE = SCL_REDUCE_1_DATA_SIZE;
+#else
+    const unsigned int DATA_SIZE = DATA_SIZE_ARG;
+#endif
+#ifdef SCL_REDUCE_1_GLOBAL_SIZE
+    const unsigned int GLOBAL_SIZE = SCL_REDUCE_1_GLOBAL_SIZE;
+#else
+    const unsigned int GLOBAL_SIZE = GLOBAL_SIZE_ARG;
+#endif
+
     const int my_pos = get_global_id(0);
     if (my_pos > DATA_SIZE) return;
         
@@ -79,9 +91,21 @@ __kernel void SCL_REDUCE_2 (
     const __global SCL_TYPE_0* SCL_IN,
           __global SCL_TYPE_0* SCL_OUT,
           __local  SCL_TYPE_0* LOCAL_BUF, // has size LOCAL_SIZE
-          unsigned int         DATA_SIZE,
-    const unsigned int         LOCAL_SIZE)    
+    const unsigned int         DATA_SIZE_ARG,
+    const unsigned int         LOCAL_SIZE_ARG)    
 {
+    // sizes might be compile time constants in a specialized variant
+#ifdef SCL_REDUCE_2_DATA_SIZE
+    unsigned int DATA_SIZE = SCL_REDUCE_2_DATA_SIZE;
+#else
+    unsigned int DATA_SIZE = DATA_SIZE_ARG;
+#endif
+#ifdef SCL_REDUCE_2_LOCAL_SIZE
+    const unsigned int LOCAL_SIZE = SCL_REDUCE_2_LOCAL_SIZE;
+#else
+    const unsigned int LOCAL_SIZE = LOCAL_SIZE_ARG;
+#endif
+
     const int my_pos  = get_global_id(0);
     
     int modul;
@@ -41,6 +41,7 @@
 #define SCAN_DEF_H_
 
 #include <algorithm>
+#include <array>
 #include <istream>
 #include <iterator>
 #include <memory>
@@ -62,6 +63,7 @@
 #include "Device.h"
 #include "KernelUtil.h"
 #include "Program.h"
+#include "ProgramRegistry.h"
 #include "Skeleton.h"
 #include "Util.h"
 
@@ -72,7 +74,8 @@ Scan<T(T)>::Scan(const Source& source,
                  const std::string& id,
                  const std::string& funcName)
   : detail::Skeleton(),
-    _program(createAndBuildProgram(source, id, funcName))
+    _program(createAndBuildProgram(source, id, funcName)),
+    _tmpBuffers()
 {
   LOG_DEBUG_INFO("Create new Scan object (", this, ")");
 }
@@ -126,16 +129,18 @@ void Scan<T(T)>::execute(Vector<T>& output,
   // calculate number of passes
   size_t passes = calculateNumberOfPasses(wgSize, elements);
 
-  // allocate intermediate buffers
-  auto tmpBuffers = createImmediateBuffers(passes, wgSize, elements, devicePtr);
+  // allocate intermediate buffers or reuse the ones of the last call
+  std::vector<size_t> sizes;
+  auto& tmpBuffers = createImmediateBuffers(passes, wgSize, elements,
+                                            devicePtr, &sizes);
 
   // perform scan for each pass
   performScanPasses(passes, wgSize, devicePtr,
-                    tmpBuffers, inputBuffer, outputBuffer);
+                    tmpBuffers, sizes, inputBuffer, outputBuffer);
 
   // perform uniform combination as last step
   performUniformCombination(passes, wgSize, devicePtr,
-                            tmpBuffers, outputBuffer);
+                            tmpBuffers, sizes, outputBuffer);
 
   LOG_DEBUG_INFO("Scan kernels started");
 }
@@ -156,21 +161,34 @@ size_t Scan<T(T)>::calculateNumberOfPasses(size_t workGroupSize,
 }
 
 template <typename T>
-std::vector<detail::DeviceBuffer>
+const std::vector<detail::DeviceBuffer>&
   Scan<T(T)>::createImmediateBuffers(size_t passes,
                                      size_t wgSize,
                                      size_t elements,
-                                     const detail::Device::ptr_type& devicePtr)
+                                     const detail::Device::ptr_type& devicePtr,
+                                     std::vector<size_t>* sizes)
 {
-  std::vector<detail::DeviceBuffer> tmpBuffers(passes);
+  ASSERT(sizes != nullptr);
+  // buffers which are large enough are reused, the kernels get the number of
+  // elements of every pass passed in sizes. The device orders the new kernels
+  // after the ones still accessing the buffers.
+  if (_tmpBuffers.size() < passes) {
+    // cleared first, as growing the vector would copy the existing buffers
+    _tmpBuffers.clear();
+    _tmpBuffers.resize(passes);
+  }
+  sizes->resize(passes);
   cl_uint n = static_cast<cl_uint>(elements);
-  for (auto& buffer : tmpBuffers) {
-
-    buffer = detail::DeviceBuffer(devicePtr, n, sizeof(T));
+  for (size_t i = 0; i < passes; ++i) {
+    auto& buffer = _tmpBuffers[i];
+    if (buffer.devicePtr() != devicePtr || buffer.size() < n) {
+      buffer = detail::DeviceBuffer(devicePtr, n, sizeof(T));
+    }
+    (*sizes)[i] = n;
     n = (n + static_cast<cl_uint>(wgSize) - 1)
         / static_cast<cl_uint>(wgSize); // round up while dividing
   }
-  return tmpBuffers;
+  return _tmpBuffers;
 }
 
 template <typename T>
@@ -180,11 +198,12 @@ void
                                 const detail::Device::ptr_type& devicePtr,
                                 const std::vector<detail::DeviceBuffer>&
                                   tmpBuffers,
+                                const std::vector<size_t>& sizes,
                                 const detail::DeviceBuffer& inputBuffer,
                                 const detail::DeviceBuffer& outputBuffer)
 {
   try {
-    cl::Kernel scanKernel(_program.kernel(*devicePtr, "SCL_SCAN"));
+    auto scanKernel = _program->kernel(*devicePtr, "SCL_SCAN");
 
     // allocate shared memory
     scanKernel.setArg( 2, cl::__local(sizeof(T) * wgSize) );
@@ -196,17 +215,22 @@ void
 
       cl_uint local  = static_cast<cl_uint>( wgSize / 2 );
       cl_uint global = static_cast<cl_uint>(
-                          detail::util::ceilToMultipleOf(currentTmp->size() / 2,
+                          detail::util::ceilToMultipleOf(sizes[i] / 2,
                                                          local) );
       scanKernel.setArg(0, currentInput->clBuffer());
       scanKernel.setArg(1, currentOutput->clBuffer());
       scanKernel.setArg(3, currentTmp->clBuffer());
-      scanKernel.setArg(4, static_cast<cl_uint>(currentTmp->size()));
+      scanKernel.setArg(4, static_cast<cl_uint>(sizes[i]));
 
       // TODO: set additional kernel args
 
+      std::array<cl::Buffer, 3> buffers = {{ currentInput->clBuffer(),
+                                             currentOutput->clBuffer(),
+                                             currentTmp->clBuffer() }};
+
       // launch kernel
-      devicePtr->enqueue(scanKernel, cl::NDRange(global), cl::NDRange(local));
+      devicePtr->enqueue(scanKernel, cl::NDRange(global), cl::NDRange(local),
+                         cl::NullRange, buffers);
       LOG_DEBUG_INFO("Perform pass number ", i, " with input (", currentInput,
                      ") and output (", currentTmp, ")");
 
@@ -226,12 +250,13 @@ void
                                           devicePtr,
                                         const std::vector<detail::DeviceBuffer>&
                                           tmpBuffers,
+                                        const std::vector<size_t>& sizes,
                                         const detail::DeviceBuffer& outputBuffer
                                        )
 {
   try {
-    cl::Kernel uniformCombinationKernel(
-        _program.kernel(*devicePtr, "SCL_UNIFORM_COMBINATION"));
+    auto uniformCombinationKernel =
+        _program->kernel(*devicePtr, "SCL_UNIFORM_COMBINATION");
     for (long i = passes - 2; i >= 0; i--) {
       auto* currentInput = &tmpBuffers[i];
       const detail::DeviceBuffer* currentOutput = nullptr;
@@ -243,15 +268,19 @@ void
 
       cl_uint local  = static_cast<cl_uint>( wgSize / 2 );
       cl_uint global = static_cast<cl_uint>(
-                        detail::util::ceilToMultipleOf(currentInput->size() / 2,
+                        detail::util::ceilToMultipleOf(sizes[i] / 2,
                                                        local) );
       uniformCombinationKernel.setArg(0, currentOutput->clBuffer());
       uniformCombinationKernel.setArg(1, currentInput->clBuffer());
       uniformCombinationKernel.setArg(2,
-          static_cast<cl_uint>(currentInput->size()));
+          static_cast<cl_uint>(sizes[i]));
+
+      std::array<cl::Buffer, 2> buffers = {{ currentOutput->clBuffer(),
+                                             currentInput->clBuffer() }};
 
       devicePtr->enqueue(uniformCombinationKernel,
-                         cl::NDRange(global), cl::NDRange(local));
+                         cl::NDRange(global), cl::NDRange(local),
+                         cl::NullRange, buffers);
     }
   } catch (cl::Error& err) {
     ABORT_WITH_ERROR(err);
@@ -259,7 +288,7 @@ void
 }
 
 template<typename T>
-detail::Program
+detail::Program::ptr_type
   Scan<T(T)>::createAndBuildProgram(const std::string& source,
                                     const std::string& id,
                                     const std::string& funcName) const
@@ -278,22 +307,26 @@ detail::Program
   s.append(
     #include "ScanKernel.cl"
   );
-  auto program = detail::Program(s, detail::util::hash(s));
-
-  // modify program
-  if (!program.loadBinary()) {
-    // append parameters from user function to kernel
-    program.transferParameters(funcName, 2, "SCL_SCAN");
-    program.transferArguments(funcName, 2, "SCL_FUNC");
-    // rename user function
-    program.renameFunction(funcName, "SCL_FUNC");
-    // rename typedefs
-    program.adjustTypes<T>();
-  }
-  // build program
-  program.build();
+  auto hash = detail::util::hash("//Scan\n" + s + funcName
+                                 + detail::util::typeNames<T>());
+  return detail::globalProgramRegistry.lookupOrCreate(hash, [&] {
+    auto program = detail::Program(s, hash);
+
+    // modify program
+    if (!program.loadBinary() && !program.loadSource()) {
+      // append parameters from user function to kernel
+      program.transferParameters(funcName, 2, "SCL_SCAN");
+      program.transferArguments(funcName, 2, "SCL_FUNC");
+      // rename user function
+      program.renameFunction(funcName, "SCL_FUNC");
+      // rename typedefs
+      program.adjustTypes<T>();
+    }
+    // build program
+    program.build();
 
-  return program;
+    return program;
+  });
 }
 
 template <typename T>
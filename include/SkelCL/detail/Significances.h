@@ -58,6 +58,7 @@ public:
   //Significances() = default;
   Significances(size_t deviceCount);
   Significances(std::initializer_list<value_type> significances);
+  Significances(const std::vector<value_type>& significances);
   //Significances(const Significances&) = default;
   //~Significances() = default;
   //Significances& operator=(const Significances&) = default;
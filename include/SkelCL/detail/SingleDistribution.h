@@ -73,6 +73,10 @@ public:
   size_t sizeForDevice(const C<T>& container,
                        const std::shared_ptr<detail::Device>& devicePtr) const;
 
+  bool hostOffsetForDevice(const C<T>& container,
+                           const std::shared_ptr<detail::Device>& devicePtr,
+                           size_t* offset) const;
+
   bool dataExchangeOnDistributionChange(Distribution<C<T>>& newDistribution);
 
 private:
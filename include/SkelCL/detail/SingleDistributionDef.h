@@ -117,6 +117,16 @@ size_t
   return single_distribution_helper::sizeForDevice<T>(container.size());
 }
 
+template <template <typename> class C, typename T>
+bool SingleDistribution<C<T>>::hostOffsetForDevice(const C<T>& /*container*/,
+                                                   const std::shared_ptr<
+                                                      detail::Device>& /*d*/,
+                                                   size_t* offset) const
+{
+  *offset = 0;
+  return true;
+}
+
 template <template <typename> class C, typename T>
 bool SingleDistribution<C<T>>::dataExchangeOnDistributionChange(
                                    Distribution<C<T>>& newDistribution)
@@ -40,9 +40,17 @@
 #ifndef SKELETON_H_
 #define SKELETON_H_
 
+#define __CL_ENABLE_EXCEPTIONS
+#include <CL/cl.hpp>
+#undef  __CL_ENABLE_EXCEPTIONS
+
 #include "../Distributions.h"
 #include "../Out.h"
 
+#include "Device.h"
+#include "LoadBalancer.h"
+#include "Program.h"
+
 #include "skelclDll.h"
 
 namespace skelcl {
@@ -92,6 +100,25 @@ protected:
   template <typename T, typename... Args>
   void updateModifiedStatus(T&& t, Args&&... args) const;
 
+  ///
+  /// \brief Sets the significances of an adaptive block distribution of the
+  ///        given container to the ones learned for the given program
+  ///
+  /// \return True, if the container has an adaptive block distribution
+  ///
+  template <typename T, template <typename> class C>
+  bool balance(const C<T>& container, const Program& program) const;
+
+  ///
+  /// \brief Records the kernel launched for the part of the given container
+  ///        on the given device, if the container has an adaptive block
+  ///        distribution
+  ///
+  template <typename T, template <typename> class C>
+  void recordKernel(const C<T>& container, const Program& program,
+                    const Device& device, size_t elements,
+                    const cl::Event& event) const;
+
 private:
   size_t _workGroupSize;
 };
@@ -141,6 +168,36 @@ void Skeleton::updateModifiedStatus(T&& /*t*/, Args&&... args) const
   updateModifiedStatus( std::forward<Args>(args)... );
 }
 
+template <typename T, template <typename> class C>
+bool Skeleton::balance(const C<T>& container, const Program& program) const
+{
+  auto block = dynamic_cast<const BlockDistribution<C<T>>*>(
+                  &container.distribution());
+  if (block == nullptr || !block->isAdaptive()) return false;
+  if (!globalLoadBalancer.isEnabled()) return true;
+
+  auto significances = globalLoadBalancer.significances(program.hash(),
+                                                        block->devices());
+  if (!(significances == block->getSignificances())) {
+    container.setDistribution(
+        BlockDistribution<C<T>>(block->devices(), significances, true) );
+  }
+  return true;
+}
+
+template <typename T, template <typename> class C>
+void Skeleton::recordKernel(const C<T>& container, const Program& program,
+                            const Device& device, size_t elements,
+                            const cl::Event& event) const
+{
+  auto block = dynamic_cast<const BlockDistribution<C<T>>*>(
+                  &container.distribution());
+  if (block == nullptr || !block->isAdaptive()) return;
+
+  globalLoadBalancer.record(program.hash(), block->devices(), device,
+                            elements, event);
+}
+
 } // namespace detail
 
 } // namespace skelcl
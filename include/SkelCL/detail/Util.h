@@ -97,6 +97,16 @@ std::string typeToString() {
   return name;
 }
 
+template<typename T>
+std::string typeNames() {
+  return typeToString<T>();
+}
+
+template<typename Head, typename Second, typename... Tail>
+std::string typeNames() {
+  return typeToString<Head>() + ", " + typeNames<Second, Tail...>();
+}
+
 } // namespace util
 
 } // namespace detail
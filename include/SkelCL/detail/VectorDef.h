@@ -41,6 +41,7 @@
 #define VECTOR_DEF_H_
 
 #include <algorithm>
+#include <functional>
 #include <ios>
 #include <iterator>
 #include <memory>
@@ -172,8 +173,9 @@ Vector<T>& Vector<T>::operator=(const Vector<T>& rhs)
   _distribution = detail::cloneAndConvert<Vector<T>>(rhs._distribution);
   _hostBufferUpToDate     = rhs._hostBufferUpToDate;
   _deviceBuffersUpToDate  = rhs._deviceBuffersUpToDate;
-  _hostBuffer             = rhs._hostBuffer;
+  // release zero copy buffers before their host storage is replaced
   _deviceBuffers          = rhs._deviceBuffers;
+  _hostBuffer             = rhs._hostBuffer;
   LOG_DEBUG_INFO("Assignment to Vector object (", this, ") now with ",
                  getDebugInfo());
   return *this;
@@ -186,8 +188,9 @@ Vector<T>& Vector<T>::operator=(Vector<T>&& rhs)
   _distribution           = std::move(rhs._distribution);
   _hostBufferUpToDate     = std::move(rhs._hostBufferUpToDate);
   _deviceBuffersUpToDate  = std::move(rhs._deviceBuffersUpToDate);
-  _hostBuffer             = std::move(rhs._hostBuffer);
+  // release zero copy buffers before their host storage is replaced
   _deviceBuffers          = std::move(rhs._deviceBuffers);
+  _hostBuffer             = std::move(rhs._hostBuffer);
   rhs._size = 0;
   rhs._hostBufferUpToDate = false;
   rhs._deviceBuffersUpToDate = false;
@@ -288,6 +291,7 @@ void Vector<T>::resize( typename Vector<T>::size_type sz, T c )
 {
   _size = sz;
   if (_hostBufferUpToDate) {
+    releaseZeroCopyBuffers();
     _hostBuffer.resize(sz, c);
     _deviceBuffersUpToDate = false;
     _deviceBuffers.clear();
@@ -311,6 +315,7 @@ bool Vector<T>::empty() const
 template <typename T>
 void Vector<T>::reserve( typename Vector<T>::size_type n )
 {
+  releaseZeroCopyBuffers();
   return _hostBuffer.reserve(n);
 }
 
@@ -376,18 +381,21 @@ template <typename T>
 template <class InputIterator>
 void Vector<T>::assign( InputIterator first, InputIterator last )
 {
+  releaseZeroCopyBuffers();
   _hostBuffer.assign(first, last);
 }
 
 template <typename T>
 void Vector<T>::assign( typename Vector<T>::size_type n, const T& u )
 {
+  releaseZeroCopyBuffers();
   _hostBuffer.assign(n, u);
 }
 
 template <typename T>
 void Vector<T>::push_back( const T& x )
 {
+  releaseZeroCopyBuffers();
   _hostBuffer.push_back(x);
   ++_size;
 }
@@ -403,6 +411,7 @@ template <typename T>
 typename Vector<T>::iterator
     Vector<T>::insert(typename Vector<T>::iterator position, const T& x)
 {
+  releaseZeroCopyBuffers();
   ++_size;
   return _hostBuffer.insert(position, x);
 }
@@ -412,6 +421,7 @@ typename Vector<T>::iterator
     Vector<T>::insert(typename Vector<T>::iterator position,
                       typename Vector<T>::size_type n, const T& x)
 {
+  releaseZeroCopyBuffers();
   _size += n;
   return _hostBuffer.insert(position, n, x);
 }
@@ -421,6 +431,7 @@ template <class InputIterator>
 void Vector<T>::insert(typename Vector<T>::iterator position,
                        InputIterator first, InputIterator last)
 {
+  releaseZeroCopyBuffers();
   _hostBuffer.insert(position, first, last);
   _size = _hostBuffer.size();
 // TODO This is NOT Compiling !?!?: _size += std::distance(first, last);
@@ -498,7 +509,8 @@ void Vector<T>::setDistribution(
   ASSERT(newDistribution->isValid());
 
   if (   _distribution->isValid()
-      && _distribution->dataExchangeOnDistributionChange(*newDistribution)) {
+      && _distribution->dataExchangeOnDistributionChange(*newDistribution)
+      && !redistributeOnDevices(*newDistribution)) {
     copyDataToHost();
     _deviceBuffersUpToDate = false;
     _deviceBuffers.clear(); // delete old device buffers,
@@ -515,8 +527,9 @@ void Vector<T>::setDistribution(
 template <typename T>
 void Vector<T>::createDeviceBuffers() const
 {
-  // create device buffers only if none have been created so far
-  if (_deviceBuffers.empty()) {
+  // create device buffers only if none have been created so far or if the
+  // host buffer used by zero copy buffers has been reallocated
+  if (_deviceBuffers.empty() || !zeroCopyBuffersValid()) {
     forceCreateDeviceBuffers();
   }
 }
@@ -530,10 +543,27 @@ void Vector<T>::forceCreateDeviceBuffers() const
 
   _deviceBuffers.clear();
 
+  // zero copy buffers use the host buffer as their storage
+  auto& devices = _distribution->devices();
+  if (   std::any_of(devices.begin(), devices.end(),
+                     [](std::shared_ptr<detail::Device> devicePtr) {
+                       return devicePtr->zeroCopy();
+                     })
+      && _hostBuffer.size() < _size) {
+    _hostBuffer.resize(_size);
+  }
+
   std::transform( _distribution->devices().begin(),
                   _distribution->devices().end(),
                   std::inserter(_deviceBuffers, _deviceBuffers.end()),
         [this](std::shared_ptr<detail::Device> devicePtr) {
+          size_t offset = 0;
+          T* hostPointer = nullptr;
+          if (   devicePtr->zeroCopy()
+              && this->_distribution->hostOffsetForDevice(*this, devicePtr,
+                                                          &offset) ) {
+            hostPointer = this->_hostBuffer.data() + offset;
+          }
           return std::make_pair(
                     devicePtr->id(),
                     detail::DeviceBuffer(
@@ -541,12 +571,72 @@ void Vector<T>::forceCreateDeviceBuffers() const
                       this->_distribution->sizeForDevice(
                               const_cast<Vector<T>&>(*this),
                               devicePtr ),
-                      sizeof(T)
+                      sizeof(T),
+                      hostPointer
                       /*,mem flags*/ )
                  );
         } );
 }
 
+template <typename T>
+bool Vector<T>::zeroCopyBuffersValid() const
+{
+  const T* first = _hostBuffer.data();
+  const T* last  = first + _hostBuffer.size();
+  for (auto& entry : _deviceBuffers) {
+    auto pointer = static_cast<const T*>(entry.second.hostPointer());
+    if (pointer == nullptr) continue;
+    if (   std::less<const T*>()(pointer, first)
+        || !std::less<const T*>()(pointer, last)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename T>
+void Vector<T>::releaseZeroCopyBuffers() const
+{
+  // commands using the host buffer as storage of zero copy buffers have to
+  // finish before the host buffer is reallocated (see Device::finish)
+  if (std::none_of(_deviceBuffers.begin(), _deviceBuffers.end(),
+                   [](const std::pair<const detail::Device::id_type,
+                                      detail::DeviceBuffer>& entry) {
+                     return entry.second.hostPointer() != nullptr;
+                   })) {
+    return;
+  }
+  copyDataToHost();
+  _deviceBuffers.clear();
+  _deviceBuffersUpToDate = false;
+}
+
+template <typename T>
+bool Vector<T>::redistributeOnDevices(
+        const detail::Distribution<Vector<T>>& newDistribution) const
+{
+  if (!_deviceBuffersUpToDate || _deviceBuffers.empty()) return false;
+
+  // parts might be moved through the host buffer
+  _hostBuffer.resize(_size);
+
+  auto& self = const_cast<Vector<T>&>(*this);
+  std::map<detail::Device::id_type, detail::DeviceBuffer> buffers;
+  if (!_distribution->redistribute(self, newDistribution,
+                                   _hostBufferUpToDate, &buffers)) {
+    return false;
+  }
+  // the old buffers can be released while the copies are pending (see
+  // Device::releaseBuffer)
+  _deviceBuffers = std::move(buffers);
+
+  detail::Event events;
+  newDistribution.startPadding(self, &events);
+
+  LOG_DEBUG_INFO("Redistributed data on devices (", getInfo(), ")");
+  return true;
+}
+
 template <typename T>
 detail::Event Vector<T>::startUpload() const
 {
@@ -609,6 +699,59 @@ void Vector<T>::copyDataToHost() const
   }
 }
 
+template <typename T>
+HostView<T> Vector<T>::hostView(HostAccess access, size_type first,
+                                size_type count) const
+{
+  ASSERT(first + count <= _size);
+  bool write = (access == HostAccess::READ_WRITE);
+
+  if (count == 0) return HostView<T>(nullptr, 0, nullptr);
+
+  if (   !_hostBufferUpToDate && _deviceBuffersUpToDate
+      && _distribution != nullptr && !_deviceBuffers.empty()) {
+    // map the range from the single device storing it
+    for (auto& devicePtr : _distribution->devices()) {
+      size_t offset = 0;
+      if (!_distribution->hostOffsetForDevice(*this, devicePtr, &offset)) {
+        break;
+      }
+      auto& buffer = _deviceBuffers[devicePtr->id()];
+      if (first < offset || first + count > offset + buffer.size()) continue;
+
+      cl::Event event;
+      auto data = static_cast<T*>(devicePtr->enqueueMap(buffer, write,
+                                                        first - offset, count,
+                                                        &event));
+      detail::Event events;
+      events.insert(event);
+      events.wait();
+
+      LOG_DEBUG_INFO("Mapped ", count, " elements from device ",
+                     devicePtr->id(), " (", getInfo(), ")");
+
+      auto bufferPtr = &buffer;
+      return HostView<T>(data, count, [this, devicePtr, bufferPtr, data,
+                                       write]() {
+        devicePtr->enqueueUnmap(*bufferPtr, data, write);
+        if (write) dataOnDeviceModified();
+      });
+    }
+  }
+
+  // the range is not stored on a single device => use the host buffer
+  copyDataToHost();
+  return HostView<T>(_hostBuffer.data() + first, count, [this, write]() {
+    if (write) dataOnHostModified();
+  });
+}
+
+template <typename T>
+HostView<T> Vector<T>::hostView(HostAccess access) const
+{
+  return hostView(access, 0, _size);
+}
+
 template <typename T>
 void Vector<T>::dataOnDeviceModified() const
 {
@@ -62,6 +62,7 @@
 #include "Device.h"
 #include "KernelUtil.h"
 #include "Program.h"
+#include "ProgramRegistry.h"
 #include "Skeleton.h"
 #include "Util.h"
 
@@ -100,6 +101,12 @@ C<Tout>& Zip<Tout(Tleft, Tright)>::operator()(Out<C<Tout>> output,
 {
   ASSERT(left.size() <= right.size());
 
+  // adapt the sizes of the blocks to the measured kernel times, the right
+  // container follows the distribution of the left one
+  if (this->balance(left, *_program)) {
+    right.setDistribution(left.distribution());
+  }
+
   prepareInput(left, right);
 
   prepareAdditionalInput(std::forward<Args>(args)...);
@@ -138,7 +145,7 @@ void Zip<Tout(Tleft, Tright)>::execute(C<Tout>& output,
                           detail::util::ceilToMultipleOf(elements, local) );
 
     try {
-      cl::Kernel kernel(_program.kernel(*devicePtr, "SCL_ZIP"));
+      auto kernel = _program->kernel(*devicePtr, "SCL_ZIP");
 
       kernel.setArg(0, leftBuffer.clBuffer());
       kernel.setArg(1, rightBuffer.clBuffer());
@@ -155,16 +162,12 @@ void Zip<Tout(Tleft, Tright)>::execute(C<Tout>& output,
                                                      std::forward<Args>(args)...
                                                     );
 
-      // after finishing the kernel invoke this function ...
-      auto invokeAfter = [=] () {
-                                  (void)keepAlive;
-                                };
-
-      devicePtr->enqueue(kernel,
-                         cl::NDRange(global), cl::NDRange(local),
-                         cl::NullRange, // offset
-                         invokeAfter);
+      auto event = devicePtr->enqueue(kernel,
+                                      cl::NDRange(global), cl::NDRange(local),
+                                      cl::NullRange, // offset
+                                      keepAlive);
 
+      this->recordKernel(left, *_program, *devicePtr, elements, event);
     } catch (cl::Error& err) {
       ABORT_WITH_ERROR(err);
     }
@@ -173,7 +176,7 @@ void Zip<Tout(Tleft, Tright)>::execute(C<Tout>& output,
 }
 
 template<typename Tleft, typename Tright, typename Tout>
-detail::Program
+detail::Program::ptr_type
   Zip<Tout(Tleft, Tright)>::createAndBuildProgram(
                                                   const std::string& source,
                                                   const std::string& funcName
@@ -205,22 +208,27 @@ __kernel void SCL_ZIP(
   }
 }
 )");
-  auto program = detail::Program(s, detail::util::hash(s));
-
-  // modify program
-  if (!program.loadBinary()) {
-    // append parameters from user function to kernel
-    program.transferParameters(funcName, 2, "SCL_ZIP");
-    program.transferArguments(funcName, 2, "SCL_FUNC");
-    // rename user function
-    program.renameFunction(funcName, "SCL_FUNC");
-    // rename typedefs
-    program.adjustTypes<Tleft, Tright, Tout>();
-  }
-  // build program
-  program.build();
+  auto hash = detail::util::hash("//Zip\n" + s + funcName
+                                 + detail::util::typeNames<Tleft, Tright,
+                                                           Tout>());
+  return detail::globalProgramRegistry.lookupOrCreate(hash, [&] {
+    auto program = detail::Program(s, hash);
+
+    // modify program
+    if (!program.loadBinary() && !program.loadSource()) {
+      // append parameters from user function to kernel
+      program.transferParameters(funcName, 2, "SCL_ZIP");
+      program.transferArguments(funcName, 2, "SCL_FUNC");
+      // rename user function
+      program.renameFunction(funcName, "SCL_FUNC");
+      // rename typedefs
+      program.adjustTypes<Tleft, Tright, Tout>();
+    }
+    // build program
+    program.build();
 
-  return program;
+    return program;
+  });
 }
 
 template <typename Tleft, typename Tright, typename Tout>
@@ -334,7 +342,7 @@ void Zip<void(Tleft, Tright)>::execute(const C<Tleft>& left,
                           detail::util::ceilToMultipleOf(elements, local) );
 
     try {
-      cl::Kernel kernel(_program.kernel(*devicePtr, "SCL_ZIP"));
+      auto kernel = _program->kernel(*devicePtr, "SCL_ZIP");
 
       kernel.setArg(0, leftBuffer.clBuffer());
       kernel.setArg(1, rightBuffer.clBuffer());
@@ -349,15 +357,10 @@ void Zip<void(Tleft, Tright)>::execute(const C<Tleft>& left,
                                                      std::forward<Args>(args)...
                                                     );
 
-      // after finishing the kernel invoke this function ...
-      auto invokeAfter = [=] () {
-                                  (void)keepAlive;
-                                };
-
       devicePtr->enqueue(kernel,
                          cl::NDRange(global), cl::NDRange(local),
                          cl::NullRange, // offset
-                         invokeAfter);
+                         keepAlive);
 
     } catch (cl::Error& err) {
       ABORT_WITH_ERROR(err);
@@ -367,7 +370,7 @@ void Zip<void(Tleft, Tright)>::execute(const C<Tleft>& left,
 }
 
 template<typename Tleft, typename Tright>
-detail::Program
+detail::Program::ptr_type
   Zip<void(Tleft, Tright)>::createAndBuildProgram(
                                                   const std::string& source,
                                                   const std::string& funcName
@@ -396,22 +399,26 @@ __kernel void SCL_ZIP(
   }
 }
 )");
-  auto program = detail::Program(s, detail::util::hash(s));
-
-  // modify program
-  if (!program.loadBinary()) {
-    // append parameters from user function to kernel
-    program.transferParameters(funcName, 2, "SCL_ZIP");
-    program.transferArguments(funcName, 2, "SCL_FUNC");
-    // rename user function
-    program.renameFunction(funcName, "SCL_FUNC");
-    // rename typedefs
-    program.adjustTypes<Tleft, Tright>();
-  }
-  // build program
-  program.build();
+  auto hash = detail::util::hash("//Zip\n" + s + funcName
+                                 + detail::util::typeNames<Tleft, Tright>());
+  return detail::globalProgramRegistry.lookupOrCreate(hash, [&] {
+    auto program = detail::Program(s, hash);
+
+    // modify program
+    if (!program.loadBinary() && !program.loadSource()) {
+      // append parameters from user function to kernel
+      program.transferParameters(funcName, 2, "SCL_ZIP");
+      program.transferArguments(funcName, 2, "SCL_FUNC");
+      // rename user function
+      program.renameFunction(funcName, "SCL_FUNC");
+      // rename typedefs
+      program.adjustTypes<Tleft, Tright>();
+    }
+    // build program
+    program.build();
 
-  return program;
+    return program;
+  });
 }
 
 template <typename Tleft, typename Tright>
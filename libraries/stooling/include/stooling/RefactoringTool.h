@@ -62,6 +62,10 @@ public:
   std::string transform(CustomToolInvocation& invocation,
                         clang::tooling::FrontendActionFactory *actionFactory);
 
+  // Applies the collected replacements to the source code of an invocation
+  // which has already been run, without parsing the code again
+  std::string rewrite(CustomToolInvocation& invocation);
+
   Replacements& replacements();
 
 private:
@@ -24,6 +24,15 @@ public:
   
   ~SourceCode();
 
+  // Starts a batch of rewrite operations. Until endBatch() is called the
+  // operations below are only queued instead of being applied immediately.
+  void beginBatch();
+
+  // Applies all queued operations and ends the batch. Independent operations
+  // are applied together in a single traversal of the AST with a single
+  // rewriter, so that the source is parsed as rarely as possible.
+  void endBatch();
+
   void transferParameters(const std::string& from,
                           unsigned int startIndex,
                           const std::string& to);
@@ -41,14 +50,44 @@ public:
 
   void fixKernelParameter(const std::string& kernel);
 
+  // Returns the source code. Operations queued in a pending batch are not
+  // yet reflected.
   const std::string& code() const;
 
   std::vector<std::string> parameterTypeNames(const std::string& funcName) const;
 
 private:
-
-  std::string       _source;
-  RefactoringTool*  _tool;
+  struct Operation {
+    enum Kind {
+      TransferParameters,
+      TransferArguments,
+      RenameFunction,
+      RenameTypedef,
+      RedefineTypedef,
+      FixKernelParameter
+    };
+
+    Kind          kind;
+    std::string   from;
+    unsigned int  startIndex;
+    std::string   to;
+  };
+
+  void enqueue(Operation::Kind kind,
+               const std::string& from,
+               unsigned int startIndex,
+               const std::string& to);
+
+  // Returns true if operation has to see the result of an operation in pass
+  static bool dependsOn(const Operation& operation,
+                        const std::vector<Operation>& pass);
+
+  void apply(const std::vector<Operation>& pass);
+
+  std::string             _source;
+  RefactoringTool*        _tool;
+  bool                    _batch;
+  std::vector<Operation>  _operations;
 };
 
 } // namespace stooling
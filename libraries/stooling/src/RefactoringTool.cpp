@@ -78,7 +78,11 @@ RefactoringTool::transform(CustomToolInvocation& invocation,
                            clang::tooling::FrontendActionFactory *actionFactory)
 {
   invocation.run(actionFactory->create());
+  return rewrite(invocation);
+}
 
+std::string RefactoringTool::rewrite(CustomToolInvocation& invocation)
+{
   //create rewriter
   clang::LangOptions defaultLangOptions;
   clang::Rewriter rewriter(invocation.getSources(), defaultLangOptions);
@@ -37,9 +37,13 @@
 
 #pragma GCC diagnostic pop
 
+#include <list>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "stooling/CustomToolInvocation.h"
 #include "stooling/RefactoringTool.h"
 
 #include "TransferArgumentsCallback.h"
@@ -59,17 +63,20 @@ using clang::tooling::newFrontendActionFactory;
 namespace stooling {
 
 SourceCode::SourceCode(const std::string& source)
-  : _source(source), _tool(new RefactoringTool())
+  : _source(source), _tool(new RefactoringTool()), _batch(false),
+    _operations()
 {
 }
 
 SourceCode::SourceCode(const SourceCode& rhs)
-  : _source(rhs._source), _tool(new RefactoringTool(*rhs._tool))
+  : _source(rhs._source), _tool(new RefactoringTool(*rhs._tool)),
+    _batch(rhs._batch), _operations(rhs._operations)
 {
 }
 
 SourceCode::SourceCode(SourceCode&& rhs)
-  : _source(std::move(rhs._source)), _tool(rhs._tool)
+  : _source(std::move(rhs._source)), _tool(rhs._tool), _batch(rhs._batch),
+    _operations(std::move(rhs._operations))
 {
   rhs._tool = nullptr;
 }
@@ -77,16 +84,21 @@ SourceCode::SourceCode(SourceCode&& rhs)
 SourceCode& SourceCode::operator=(const SourceCode& rhs)
 {
   if (this == &rhs) return *this;
-  _source = rhs._source;
-  _tool   = new RefactoringTool(*rhs._tool);
+  _source     = rhs._source;
+  delete _tool;
+  _tool       = new RefactoringTool(*rhs._tool);
+  _batch      = rhs._batch;
+  _operations = rhs._operations;
   return *this;
 }
 
 SourceCode& SourceCode::operator=(SourceCode&& rhs)
 {
   if (this == &rhs) return *this;
-  _source = std::move(rhs._source);
-  _tool   = rhs._tool; rhs._tool = nullptr;
+  _source     = std::move(rhs._source);
+  std::swap(_tool, rhs._tool);
+  _batch      = rhs._batch;
+  _operations = std::move(rhs._operations);
   return *this;
 }
 
@@ -95,171 +107,249 @@ SourceCode::~SourceCode()
   delete _tool;
 }
 
-void SourceCode::transferParameters(const std::string& from,
-                                unsigned int startIndex,
-                                const std::string& to)
+void SourceCode::beginBatch()
 {
-  // First extract the parameters from the "from" function into "parameter"
-  std::string parameter;
-  ast_matchers::MatchFinder parameterFinder;
-  ExtractParametersCallback extractCallback(&parameter, startIndex);
-  parameterFinder.addMatcher(
-      functionDecl(hasName(from)).bind("fromDecl"),
-      &extractCallback);
+  _batch = true;
+}
 
-  {
-    auto action = newFrontendActionFactory(&parameterFinder);
-    _tool->run(_source,
-#if (LLVM_VERSION_MAJOR >= 3 && LLVM_VERSION_MINOR <= 4)
-               action
-#else
-               action.get()
-#endif
-              );
+void SourceCode::endBatch()
+{
+  _batch = false;
+
+  // split the queued operations into passes of independent operations
+  std::vector<Operation> pass;
+  for (auto& operation : _operations) {
+    if (dependsOn(operation, pass)) {
+      apply(pass);
+      pass.clear();
+    }
+    pass.push_back(operation);
   }
+  apply(pass);
+  _operations.clear();
+}
 
-  if (!parameter.empty()) {
-    // Then insert the parameters to the declaration of the "to" function
-    ast_matchers::MatchFinder functionFinder;
-    ApplyParametersCallback applyCallback(_tool->replacements(), parameter);
-    functionFinder.addMatcher(
-        functionDecl(hasName(to)).bind("toDecl"),
-        &applyCallback);
-
-    auto action = newFrontendActionFactory(&functionFinder);
-    _source = _tool->transform(_source,
-#if (LLVM_VERSION_MAJOR >= 3 && LLVM_VERSION_MINOR <= 4)
-                               action
-#else
-                               action.get()
-#endif
-                               );
-  }
+void SourceCode::transferParameters(const std::string& from,
+                                unsigned int startIndex,
+                                const std::string& to)
+{
+  enqueue(Operation::TransferParameters, from, startIndex, to);
 }
 
 void SourceCode::transferArguments(const std::string& from,
                                unsigned int startIndex,
                                const std::string& to)
 {
-  // First extract argument names from the "from" function declaration into
-  // "arguments"
-  std::string arguments;
-  ast_matchers::MatchFinder argumentsFinder;
-  ExtractArgumentsCallback extractCallback(&arguments, startIndex);
-  argumentsFinder.addMatcher(
-      functionDecl(hasName(from)).bind("fromDecl"),
-      &extractCallback);
-  {
-    auto action = newFrontendActionFactory(&argumentsFinder);
-    _tool->run(_source,
-#if (LLVM_VERSION_MAJOR >= 3 && LLVM_VERSION_MINOR <= 4)
-               action
-#else
-               action.get()
-#endif
-               );
-  }
-  
-  if (!arguments.empty()) {
-    // Then insert the arguments to every call of the function "to"
-    ast_matchers::MatchFinder callFinder;
-    ApplyArgumentsCallback applyCallback(_tool->replacements(), arguments);
-    callFinder.addMatcher(
-        callExpr(callee(functionDecl(hasName(to)))).bind("toCall"),
-        &applyCallback);
-
-    auto action = newFrontendActionFactory(&callFinder);
-    _source = _tool->transform(_source,
-#if (LLVM_VERSION_MAJOR >= 3 && LLVM_VERSION_MINOR <= 4)
-                               action
-#else
-                               action.get()
-#endif
-                              );
-  }
+  enqueue(Operation::TransferArguments, from, startIndex, to);
 }
 
 void SourceCode::renameFunction(const std::string& from, const std::string& to)
 {
-  ast_matchers::MatchFinder finder;
-  RenameFunctionCallback callback(_tool->replacements(), to);
-  // match function declarations with the name "from"
-  finder.addMatcher(
-      functionDecl(hasName(from)).bind("decl"),
-      &callback);
-  // match call expressions calling a function with the name "from"
-  finder.addMatcher(
-      callExpr(callee(functionDecl(hasName(from)))).bind("call"),
-      &callback);
-
-  auto action = newFrontendActionFactory(&finder);
-  _source = _tool->transform(_source,
-#if (LLVM_VERSION_MAJOR >= 3 && LLVM_VERSION_MINOR <= 4)
-                             action
-#else
-                             action.get()
-#endif
-                            );
+  enqueue(Operation::RenameFunction, from, 0, to);
 }
 
 void SourceCode::renameTypedef(const std::string& from, const std::string& to)
 {
-  ast_matchers::MatchFinder finder;
-  RenameTypedefCallback callback(_tool->replacements(), from, to);
-  // match any named declaration
-  // filter further in the callback
-  finder.addMatcher(
-      namedDecl().bind("decl"),
-      &callback);
-
-  auto action = newFrontendActionFactory(&finder);
-  _source = _tool->transform(_source,
-#if (LLVM_VERSION_MAJOR >= 3 && LLVM_VERSION_MINOR <= 4)
-                             action
-#else
-                             action.get()
-#endif
-                            );
+  enqueue(Operation::RenameTypedef, from, 0, to);
 }
 
 void SourceCode::redefineTypedef(const std::string& typedefName,
                                  const std::string& newType)
 {
-  ast_matchers::MatchFinder finder;
-  RedefineTypedefCallback callback(_tool->replacements(), typedefName, newType);
-  // match any named declaration
-  // filter further in the callback
-  finder.addMatcher(
-      namedDecl().bind("decl"),
-      &callback);
-
-  auto action = newFrontendActionFactory(&finder);
-  _source = _tool->transform(_source,
-#if (LLVM_VERSION_MAJOR >= 3 && LLVM_VERSION_MINOR <= 4)
-                             action
-#else
-                             action.get()
-#endif
-                            );
+  enqueue(Operation::RedefineTypedef, typedefName, 0, newType);
 }
 
 void SourceCode::fixKernelParameter(const std::string& kernel)
 {
+  enqueue(Operation::FixKernelParameter, kernel, 0, kernel);
+}
+
+void SourceCode::enqueue(Operation::Kind kind,
+                         const std::string& from,
+                         unsigned int startIndex,
+                         const std::string& to)
+{
+  Operation operation = { kind, from, startIndex, to };
+  _operations.push_back(operation);
+  if (!_batch) {
+    endBatch();
+  }
+}
+
+bool SourceCode::dependsOn(const Operation& operation,
+                           const std::vector<Operation>& pass)
+{
+  // does the operation modify the parameter list of the function "name"?
+  auto modifiesParameters = [](const Operation& op, const std::string& name) {
+    return (   op.kind == Operation::TransferParameters
+            || op.kind == Operation::FixKernelParameter )
+        && op.to == name;
+  };
+
+  for (auto& previous : pass) {
+    switch (previous.kind) {
+    case Operation::RenameFunction:
+      // the operation has to see the function under its new name
+      if (   operation.from == previous.from || operation.from == previous.to
+          || operation.to   == previous.from || operation.to   == previous.to) {
+        return true;
+      }
+      break;
+    case Operation::RenameTypedef:
+    case Operation::RedefineTypedef:
+      if (   (   operation.kind == Operation::RenameTypedef
+              || operation.kind == Operation::RedefineTypedef)
+          && (   operation.from == previous.from
+              || operation.from == previous.to)) {
+        return true;
+      }
+      // transferred parameters have to be copied with the renamed types
+      if (   previous.kind  == Operation::RenameTypedef
+          && operation.kind == Operation::TransferParameters) {
+        return true;
+      }
+      break;
+    case Operation::TransferParameters:
+    case Operation::FixKernelParameter:
+      // replacements of the same parameters would overlap
+      if (modifiesParameters(operation, previous.to)) {
+        return true;
+      }
+      // the parameters have to be extracted after they have been modified
+      if (   (   operation.kind == Operation::TransferParameters
+              || operation.kind == Operation::TransferArguments)
+          && operation.from == previous.to) {
+        return true;
+      }
+      break;
+    case Operation::TransferArguments:
+      // replacements of the same arguments would overlap
+      if (   operation.kind == Operation::TransferArguments
+          && operation.to == previous.to) {
+        return true;
+      }
+      break;
+    }
+  }
+  return false;
+}
+
+void SourceCode::apply(const std::vector<Operation>& pass)
+{
+  if (pass.empty()) { return; }
+
+  // all callbacks add their replacements to the tool and are invoked during
+  // a single traversal of the AST
   ast_matchers::MatchFinder finder;
-  FixKernelParameterCallback callback(_tool->replacements());
-  // match function declarations with the name "from"
-  finder.addMatcher(
-      functionDecl(hasName(kernel)).bind("decl"),
-      &callback);
+  std::vector<std::unique_ptr<MatchFinder::MatchCallback>> callbacks;
+  // extracted parameters and arguments; a list keeps references valid
+  std::list<std::string> extracted;
+  std::vector<ApplyParametersCallback*> applyParameters;
+  std::vector<ApplyArgumentsCallback*> applyArguments;
+
+  for (auto& operation : pass) {
+    switch (operation.kind) {
+    case Operation::TransferParameters: {
+      // extract the parameters from the "from" function and insert them
+      // into the declaration of the "to" function
+      extracted.push_back(std::string());
+      auto extract = new ExtractParametersCallback(&extracted.back(),
+                                                   operation.startIndex);
+      callbacks.emplace_back(extract);
+      finder.addMatcher(
+          functionDecl(hasName(operation.from)).bind("fromDecl"),
+          extract);
+
+      auto apply = new ApplyParametersCallback(_tool->replacements(),
+                                               extracted.back());
+      callbacks.emplace_back(apply);
+      applyParameters.push_back(apply);
+      finder.addMatcher(
+          functionDecl(hasName(operation.to)).bind("toDecl"),
+          apply);
+      break;
+    }
+    case Operation::TransferArguments: {
+      // extract argument names from the "from" function declaration and
+      // insert them into every call of the function "to"
+      extracted.push_back(std::string());
+      auto extract = new ExtractArgumentsCallback(&extracted.back(),
+                                                  operation.startIndex);
+      callbacks.emplace_back(extract);
+      finder.addMatcher(
+          functionDecl(hasName(operation.from)).bind("fromDecl"),
+          extract);
+
+      auto apply = new ApplyArgumentsCallback(_tool->replacements(),
+                                              extracted.back());
+      callbacks.emplace_back(apply);
+      applyArguments.push_back(apply);
+      finder.addMatcher(
+          callExpr(callee(functionDecl(hasName(operation.to)))).bind("toCall"),
+          apply);
+      break;
+    }
+    case Operation::RenameFunction: {
+      auto callback = new RenameFunctionCallback(_tool->replacements(),
+                                                 operation.to);
+      callbacks.emplace_back(callback);
+      // match function declarations with the name "from"
+      finder.addMatcher(
+          functionDecl(hasName(operation.from)).bind("decl"),
+          callback);
+      // match call expressions calling a function with the name "from"
+      finder.addMatcher(
+          callExpr(callee(functionDecl(hasName(operation.from)))).bind("call"),
+          callback);
+      break;
+    }
+    case Operation::RenameTypedef: {
+      auto callback = new RenameTypedefCallback(_tool->replacements(),
+                                                operation.from, operation.to);
+      callbacks.emplace_back(callback);
+      // match any named declaration
+      // filter further in the callback
+      finder.addMatcher(namedDecl().bind("decl"), callback);
+      break;
+    }
+    case Operation::RedefineTypedef: {
+      auto callback = new RedefineTypedefCallback(_tool->replacements(),
+                                                  operation.from,
+                                                  operation.to);
+      callbacks.emplace_back(callback);
+      // match any named declaration
+      // filter further in the callback
+      finder.addMatcher(namedDecl().bind("decl"), callback);
+      break;
+    }
+    case Operation::FixKernelParameter: {
+      auto callback = new FixKernelParameterCallback(_tool->replacements());
+      callbacks.emplace_back(callback);
+      finder.addMatcher(
+          functionDecl(hasName(operation.from)).bind("decl"),
+          callback);
+      break;
+    }
+    }
+  }
 
-  auto action = newFrontendActionFactory(&finder);
-  _source = _tool->transform(_source,
+  CustomToolInvocation invocation(_source);
+  {
+    auto action = newFrontendActionFactory(&finder);
+    _tool->run(invocation,
 #if (LLVM_VERSION_MAJOR >= 3 && LLVM_VERSION_MINOR <= 4)
-                             action
+               action
 #else
-                             action.get()
+               action.get()
 #endif
-                            );
+              );
+  }
+
+  // every parameter and argument is extracted now
+  for (auto apply : applyParameters) { apply->finish(); }
+  for (auto apply : applyArguments)  { apply->finish(); }
+
+  _source = _tool->rewrite(invocation);
 }
 
 std::vector<std::string>
@@ -38,6 +38,7 @@
 #pragma GCC diagnostic pop
 
 #include <string>
+#include <vector>
 #include <sstream>
 #include <iostream>
 
@@ -78,7 +79,7 @@ void ExtractArgumentsCallback::run(
 ApplyArgumentsCallback::ApplyArgumentsCallback(
                           clang::tooling::Replacements& replacements,
                           const std::string& arguments)
-  : _replacements(replacements), _arguments(arguments)
+  : _replacements(replacements), _arguments(arguments), _pending()
 {}
 
 void ApplyArgumentsCallback::run(
@@ -91,9 +92,9 @@ void ApplyArgumentsCallback::run(
       std::string lastArg = getText(*result.SourceManager,
                                     *lastArgExpr);
 
-      _replacements.insert(Replacement(*result.SourceManager,
-                                       lastArgExpr,
-                                       lastArg + ", " + _arguments));
+      _pending.push_back(Replacement(*result.SourceManager,
+                                     lastArgExpr,
+                                     lastArg + ", "));
     } else {
       // look for the next token: a '('
       clang::SourceLocation insertLoc =
@@ -103,12 +104,24 @@ void ApplyArgumentsCallback::run(
                                              clang::LangOptions(),
                        /*skip Whitespace? */ true);
 
-      _replacements.insert(Replacement(*result.SourceManager,
-                                       insertLoc, 0,
-                                       _arguments));
+      _pending.push_back(Replacement(*result.SourceManager,
+                                     insertLoc, 0, ""));
     }
   }
 }
 
+void ApplyArgumentsCallback::finish()
+{
+  if (_arguments.empty()) { return; }
+  for (auto& r : _pending) {
+    _replacements.insert(Replacement(r.getFilePath(),
+                                     r.getOffset(),
+                                     r.getLength(),
+                                     r.getReplacementText().str()
+                                       + _arguments));
+  }
+  _pending.clear();
+}
+
 } // namespace stooling
 
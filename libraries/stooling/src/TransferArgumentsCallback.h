@@ -17,6 +17,7 @@
 #pragma GCC diagnostic pop
 
 #include <string>
+#include <vector>
 
 #ifndef TRANSFER_ARGUMENTS_CALLBACK_H
 #define TRANSFER_ARGUMENTS_CALLBACK_H
@@ -45,9 +46,15 @@ public:
 
   virtual void run(const clang::ast_matchers::MatchFinder::MatchResult& result);
 
+  // Inserts the replacements recorded by run(). This happens after the
+  // traversal, because the arguments might be extracted by a callback
+  // running later during the same traversal.
+  void finish();
+
 private:
-  clang::tooling::Replacements& _replacements;
-  const std::string&            _arguments;
+  clang::tooling::Replacements&             _replacements;
+  const std::string&                        _arguments;
+  std::vector<clang::tooling::Replacement>  _pending;
 };
 
 } // namespace stooling
@@ -38,6 +38,7 @@
 #pragma GCC diagnostic pop
 
 #include <string>
+#include <vector>
 #include <sstream>
 #include <iostream>
 
@@ -78,7 +79,7 @@ void ExtractParametersCallback::run(
 ApplyParametersCallback::ApplyParametersCallback(
                           clang::tooling::Replacements& replacements,
                           const std::string& parameter)
-  : _replacements(replacements), _parameter(parameter)
+  : _replacements(replacements), _parameter(parameter), _pending()
 {}
 
 void ApplyParametersCallback::run(
@@ -93,9 +94,9 @@ void ApplyParametersCallback::run(
       std::string lastParam = getText(*result.SourceManager,
                                       *lastParamDecl);
 
-      _replacements.insert(Replacement(*result.SourceManager,
-                                       lastParamDecl,
-                                       lastParam + ", " + _parameter));
+      _pending.push_back(Replacement(*result.SourceManager,
+                                     lastParamDecl,
+                                     lastParam + ", "));
     } else {
       // look for the next token: a '('
       clang::SourceLocation insertLoc =
@@ -105,12 +106,24 @@ void ApplyParametersCallback::run(
                                              clang::LangOptions(),
                        /*skip Whitespace? */ true);
 
-      _replacements.insert(Replacement(*result.SourceManager,
-                                       insertLoc, 0,
-                                       _parameter));
+      _pending.push_back(Replacement(*result.SourceManager,
+                                     insertLoc, 0, ""));
     }
   }
 }
 
+void ApplyParametersCallback::finish()
+{
+  if (_parameter.empty()) { return; }
+  for (auto& r : _pending) {
+    _replacements.insert(Replacement(r.getFilePath(),
+                                     r.getOffset(),
+                                     r.getLength(),
+                                     r.getReplacementText().str()
+                                       + _parameter));
+  }
+  _pending.clear();
+}
+
 } // namespace stooling
 
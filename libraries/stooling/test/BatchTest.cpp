@@ -0,0 +1,122 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+
+#include <string>
+
+#include "Test.h"
+
+using namespace testing;
+
+class BatchTest : public Test
+{
+protected:
+  BatchTest() {}
+};
+
+TEST_F(BatchTest, BatchIsAppliedAtTheEnd)
+{
+  const char* input = "\
+void foo(int x);\n\
+";
+  stooling::SourceCode s(input);
+
+  s.beginBatch();
+  s.renameFunction("foo", "bar");
+  ASSERT_EQ(input, s.code());
+
+  s.endBatch();
+
+  const char* expectedOutput = "\
+void bar(int x);\n\
+";
+  ASSERT_EQ(expectedOutput, s.code());
+}
+
+TEST_F(BatchTest, BatchMatchesSequentialApplication)
+{
+  const char* input = "\
+typedef float SCL_TYPE_0;\n\
+int foo(SCL_TYPE_0 x, int y, float z) { return y; }\n\
+__kernel void bar(__global SCL_TYPE_0* i)\n\
+{\n\
+  i[0] = SCL_FUNC(i[0]);\n\
+}\
+";
+  stooling::SourceCode sequential(input);
+  sequential.transferParameters("foo", 1, "bar");
+  sequential.transferArguments("foo", 1, "SCL_FUNC");
+  sequential.renameFunction("foo", "SCL_FUNC");
+  sequential.redefineTypedef("SCL_TYPE_0", "int");
+
+  stooling::SourceCode batched(input);
+  batched.beginBatch();
+  batched.transferParameters("foo", 1, "bar");
+  batched.transferArguments("foo", 1, "SCL_FUNC");
+  batched.renameFunction("foo", "SCL_FUNC");
+  batched.redefineTypedef("SCL_TYPE_0", "int");
+  batched.endBatch();
+
+  const char* expectedOutput = "\
+typedef int SCL_TYPE_0;\n\
+int SCL_FUNC(SCL_TYPE_0 x, int y, float z) { return y; }\n\
+__kernel void bar(__global SCL_TYPE_0* i, int y, float z)\n\
+{\n\
+  i[0] = SCL_FUNC(i[0], y, z);\n\
+}\
+";
+  ASSERT_EQ(expectedOutput, sequential.code());
+  ASSERT_EQ(expectedOutput, batched.code());
+}
+
+TEST_F(BatchTest, TransferParametersOfTwoFunctionsInOrder)
+{
+  const char* input = "\
+void foo(int x, int y);\n\
+void baz(int x, float z);\n\
+void bar(int i);\
+";
+  stooling::SourceCode s(input);
+
+  s.beginBatch();
+  s.transferParameters("foo", 1, "bar");
+  s.transferParameters("baz", 1, "bar");
+  s.endBatch();
+
+  const char* expectedOutput = "\
+void foo(int x, int y);\n\
+void baz(int x, float z);\n\
+void bar(int i, int y, float z);\
+";
+  ASSERT_EQ(expectedOutput, s.code());
+}
+
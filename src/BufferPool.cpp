@@ -0,0 +1,164 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file BufferPool.cpp
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#include <limits>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#define __CL_ENABLE_EXCEPTIONS
+#include <CL/cl.hpp>
+#undef  __CL_ENABLE_EXCEPTIONS
+
+#include <pvsutil/Logger.h>
+
+#include "SkelCL/detail/BufferPool.h"
+
+namespace {
+
+// allocations are at least of this size
+const size_t minSizeClass = 256;
+
+} // namespace
+
+namespace skelcl {
+
+namespace detail {
+
+BufferPool::BufferPool(size_t maxBytes)
+  : _mutex(), _maxBytes(maxBytes),
+    _maxAllocation(std::numeric_limits<size_t>::max()), _cachedBytes(0),
+    _free()
+{
+}
+
+size_t BufferPool::sizeClass(size_t bytes)
+{
+  if (bytes <= ::minSizeClass) return ::minSizeClass;
+  size_t power = ::minSizeClass;
+  while (power <= bytes / 2) power *= 2;
+  // power <= bytes < 2 * power, round up to a quarter of power
+  size_t step = power / 4;
+  return ((bytes + step - 1) / step) * step;
+}
+
+size_t BufferPool::allocationSize(size_t bytes) const
+{
+  auto size = sizeClass(bytes);
+  std::lock_guard<std::mutex> lock(_mutex);
+  // rounding up must not make a valid allocation fail
+  return (size > _maxAllocation) ? bytes : size;
+}
+
+cl::Buffer BufferPool::allocate(const cl::Context& context, size_t bytes,
+                                cl_mem_flags flags)
+{
+  auto size = allocationSize(bytes);
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto iter = _free.find(key_type(flags, size));
+    if (iter != _free.end() && !iter->second.empty()) {
+      auto buffer = iter->second.back();
+      iter->second.pop_back();
+      _cachedBytes -= size;
+      LOG_DEBUG_INFO("Reusing buffer ", buffer(), " of ", size,
+                     " bytes for ", bytes, " bytes");
+      return buffer;
+    }
+  }
+  return cl::Buffer(context, flags, size);
+}
+
+bool BufferPool::release(const cl::Buffer& buffer, size_t bytes,
+                         cl_mem_flags flags)
+{
+  auto size = allocationSize(bytes);
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_cachedBytes + size > _maxBytes) return false;
+  _free[key_type(flags, size)].push_back(buffer);
+  _cachedBytes += size;
+  return true;
+}
+
+std::vector<cl::Buffer> BufferPool::clear()
+{
+  std::vector<cl::Buffer> buffers;
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (auto& entry : _free) {
+    buffers.insert(buffers.end(), entry.second.begin(), entry.second.end());
+  }
+  _free.clear();
+  _cachedBytes = 0;
+  return buffers;
+}
+
+void BufferPool::setMaxBytes(size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _maxBytes = bytes;
+}
+
+size_t BufferPool::maxBytes() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _maxBytes;
+}
+
+void BufferPool::setMaxAllocation(size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _maxAllocation = bytes;
+}
+
+size_t BufferPool::maxAllocation() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _maxAllocation;
+}
+
+size_t BufferPool::cachedBytes() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _cachedBytes;
+}
+
+} // namespace detail
+
+} // namespace skelcl
@@ -0,0 +1,221 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file CompletionQueue.cpp
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define __CL_ENABLE_EXCEPTIONS
+#include <CL/cl.hpp>
+#undef  __CL_ENABLE_EXCEPTIONS
+
+#include <pvsutil/Logger.h>
+
+#include "SkelCL/detail/CompletionQueue.h"
+
+namespace {
+
+// failed commands report a negative status and are finished as well
+bool isFinished(const cl::Event& event)
+{
+  try {
+    return    event.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>()
+           <= CL_COMPLETE;
+  } catch (cl::Error& err) {
+    LOG_ERROR("Querying event status failed (", err, ")");
+    return true;
+  }
+}
+
+void waitFor(const cl::Event& event)
+{
+  try {
+    event.wait();
+  } catch (cl::Error& err) {
+    LOG_ERROR("Event returned with abnormal status (", err, ")");
+  }
+}
+
+} // namespace
+
+namespace skelcl {
+
+namespace detail {
+
+CompletionQueue::Record::Record()
+  : event(), buffers(), callback()
+{
+}
+
+CompletionQueue::CompletionQueue()
+  : _mutex(), _condition(), _records(), _submitted(0), _free(), _storage(),
+    _stop(false), _thread()
+{
+  _thread = std::thread(&CompletionQueue::run, this);
+}
+
+CompletionQueue::~CompletionQueue()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _condition.notify_one();
+  _thread.join();
+
+  std::vector<Record*> records(_records.begin(), _records.end());
+  _records.clear();
+  _submitted = 0;
+  for (auto record : records) {
+    ::waitFor(record->event);
+  }
+  retire(&records);
+}
+
+void CompletionQueue::add(const cl::Event& event,
+                          const cl::Buffer* buffers,
+                          size_t count,
+                          const std::function<void()>& callback)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto record = allocate();
+  record->event = event;
+  for (size_t i = 0; i < count; ++i) {
+    if (buffers[i]() == nullptr) continue; // not a buffer argument
+    record->buffers.push_back(buffers[i]);
+  }
+  record->callback = callback;
+  _records.push_back(record);
+}
+
+void CompletionQueue::submitted()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_submitted == _records.size()) return;
+    _submitted = _records.size();
+  }
+  _condition.notify_one();
+}
+
+void CompletionQueue::retireAll()
+{
+  std::vector<Record*> records;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    records.assign(_records.begin(), _records.end());
+    _records.clear();
+    _submitted = 0;
+  }
+  retire(&records);
+}
+
+size_t CompletionQueue::size() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _records.size();
+}
+
+size_t CompletionQueue::capacity() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _storage.size();
+}
+
+CompletionQueue::Record* CompletionQueue::allocate()
+{
+  if (_free.empty()) {
+    _storage.emplace_back(new Record());
+    return _storage.back().get();
+  }
+  auto record = _free.back();
+  _free.pop_back();
+  return record;
+}
+
+void CompletionQueue::retire(std::vector<Record*>* records)
+{
+  // invoke the callbacks and release the buffers without holding the lock
+  for (auto record : *records) {
+    if (record->callback) {
+      record->callback();
+    }
+    record->event    = cl::Event();
+    record->callback = nullptr;
+    record->buffers.clear(); // the capacity is kept for reuse
+  }
+  std::lock_guard<std::mutex> lock(_mutex);
+  _free.insert(_free.end(), records->begin(), records->end());
+  records->clear();
+}
+
+void CompletionQueue::run()
+{
+  std::vector<Record*> completed;
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    _condition.wait(lock, [this] { return _stop || _submitted > 0; });
+    if (_stop) return;
+
+    auto event = _records.front()->event;
+    lock.unlock();
+    ::waitFor(event);
+    lock.lock();
+
+    // retire all completed records at once
+    while (_submitted > 0 && ::isFinished(_records.front()->event)) {
+      completed.push_back(_records.front());
+      _records.pop_front();
+      --_submitted;
+    }
+    if (completed.empty()) continue;
+
+    lock.unlock();
+    retire(&completed);
+    lock.lock();
+  }
+}
+
+} // namespace detail
+
+} // namespace skelcl
@@ -37,10 +37,14 @@
 /// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
 ///
 
+#include <algorithm>
+#include <cstdlib>
 #include <functional>
+#include <mutex>
 #include <stdexcept>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #define __CL_ENABLE_EXCEPTIONS
 #include <CL/cl.hpp>
@@ -52,11 +56,12 @@
 #include "SkelCL/detail/Device.h"
 
 #include "SkelCL/detail/DeviceBuffer.h"
+#include "SkelCL/detail/LoadBalancer.h"
+#include "SkelCL/detail/Profiler.h"
+#include "SkelCL/detail/Util.h"
 
 namespace {
 
-#ifndef NDEBUG // DEBUG build
-
 std::string printNDRange(const cl::NDRange& range)
 {
   std::stringstream s;
@@ -72,17 +77,72 @@ std::string printNDRange(const cl::NDRange& range)
   return s.str();
 }
 
-#endif
+void addPending(std::vector<cl::Event>* events, const cl::Event& event)
+{
+  if (event() != nullptr) {
+    events->push_back(event);
+  }
+}
 
-void invokeCallback(cl_event /*event*/, cl_int status, void * userData)
+skelcl::detail::Device::FlushPolicy flushPolicyFromEnvironment()
 {
-  auto callback = static_cast<std::function<void()>*>(userData);
-  (*callback)(); // invoke callback
-  delete callback;
+  typedef skelcl::detail::Device::FlushPolicy FlushPolicy;
+
+  auto value = skelcl::detail::util::envVarValue("SKELCL_FLUSH");
+  if (value.empty() || value == "IMMEDIATE") return FlushPolicy::immediate();
+  if (value == "WAIT") return FlushPolicy::onWait();
 
-  if (status != CL_COMPLETE) {
-    LOG_ERROR("Event returned with abnormal status (", cl::Error(status), ")");
+  char* end = nullptr;
+  auto commands = std::strtoull(value.c_str(), &end, 10);
+  unsigned long long bytes = 0;
+  if (*end == ',') {
+    bytes = std::strtoull(end + 1, nullptr, 10);
   }
+  return FlushPolicy::threshold(static_cast<size_t>(commands),
+                                static_cast<size_t>(bytes));
+}
+
+skelcl::detail::Device::FlushPolicy& defaultFlushPolicySetting()
+{
+  static auto policy = flushPolicyFromEnvironment();
+  return policy;
+}
+
+bool& defaultOutOfOrderSetting()
+{
+  static bool outOfOrder =
+    (skelcl::detail::util::envVarValue("SKELCL_OUT_OF_ORDER") == "YES");
+  return outOfOrder;
+}
+
+bool& defaultZeroCopySetting()
+{
+  static bool zeroCopy =
+    (skelcl::detail::util::envVarValue("SKELCL_ZERO_COPY") == "YES");
+  return zeroCopy;
+}
+
+bool& defaultBufferPoolingSetting()
+{
+  static bool pooling =
+    (skelcl::detail::util::envVarValue("SKELCL_BUFFER_POOL") != "NO");
+  return pooling;
+}
+
+bool& defaultSharedContextSetting()
+{
+  static bool shared =
+    (skelcl::detail::util::envVarValue("SKELCL_SHARED_CONTEXT") == "YES");
+  return shared;
+}
+
+// reads beyond this number are checked for completion before adding more
+const size_t maxTrackedReads = 16;
+
+bool isComplete(const cl::Event& event)
+{
+  return    event.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>()
+         == CL_COMPLETE;
 }
 
 } // namespace
@@ -91,24 +151,117 @@ namespace skelcl {
 
 namespace detail {
 
+Device::FlushPolicy Device::FlushPolicy::immediate()
+{
+  return threshold(1);
+}
+
+Device::FlushPolicy Device::FlushPolicy::onWait()
+{
+  return threshold(0, 0);
+}
+
+Device::FlushPolicy Device::FlushPolicy::threshold(size_t commands,
+                                                   size_t bytes)
+{
+  FlushPolicy policy = { commands, bytes };
+  return policy;
+}
+
+Device::SubDevice::SubDevice()
+  : device(nullptr)
+{
+}
+
+Device::SubDevice::~SubDevice()
+{
+  if (device == nullptr) return;
+
+  auto release = reinterpret_cast<clReleaseDeviceEXT_fn>(
+                   clGetExtensionFunctionAddress("clReleaseDeviceEXT"));
+  if (release == nullptr) return;
+  cl_int err = release(device);
+  if (err != CL_SUCCESS) {
+    LOG_WARNING("Releasing sub-device failed (error ", err, ")");
+  }
+}
+
+Device::BufferEvents::BufferEvents()
+  : write(), reads(), mappedBuffer(), mapped(nullptr)
+{
+}
+
+Device::Pending::Pending()
+  : commands(0), bytes(0)
+{
+}
+
 Device::Device(const cl::Device& device,
                const cl::Platform& platform,
-               const Device::id_type id)
-  : _device(device), _context(), _commandQueue(), _id(id)
+               const Device::id_type id,
+               const cl::Context& context)
+  : _subDevice(), _device(device), _context(context), _commandQueue(),
+    _transferQueue(),
+    _id(id), _outOfOrder(false), _profiling(false), _zeroCopy(false),
+    _bufferPooling(false), _queueMutex(), _bufferEvents(),
+    _lastUnknownCompute(), _flushPolicy(defaultFlushPolicy()),
+    _pendingCompute(), _pendingTransfer(), _bufferPool(0), _completions()
 {
   try {
-    VECTOR_CLASS<cl::Device> devices(1, _device);
-
-    // create separate context for every device
-    cl_context_properties props[] = {
-                CL_CONTEXT_PLATFORM,
-                reinterpret_cast<cl_context_properties>( (platform)() ),
-                0
-              };
-    _context = cl::Context(devices, props);
-
-    // create command queue for every device
-    _commandQueue = cl::CommandQueue(_context, _device);
+    // sub-devices created by DeviceProperties::partition are owned by this
+    if (   _device.getInfo<CL_DEVICE_EXTENSIONS>().find("cl_ext_device_fission")
+        != std::string::npos) {
+      cl_device_id parent = nullptr;
+      cl_int err = clGetDeviceInfo(_device(), CL_DEVICE_PARENT_DEVICE_EXT,
+                                   sizeof(parent), &parent, nullptr);
+      if (err == CL_SUCCESS && parent != nullptr) {
+        _subDevice.device = _device();
+      }
+    }
+
+    if (_context() == nullptr) {
+      VECTOR_CLASS<cl::Device> devices(1, _device);
+
+      // create separate context for every device
+      cl_context_properties props[] = {
+                  CL_CONTEXT_PLATFORM,
+                  reinterpret_cast<cl_context_properties>( (platform)() ),
+                  0
+                };
+      _context = cl::Context(devices, props);
+    }
+
+    cl_command_queue_properties properties = 0;
+    if (globalProfiler.isEnabled()) {
+      properties |= CL_QUEUE_PROFILING_ENABLE;
+      _profiling  = true;
+      globalProfiler.addDevice(_id, name());
+    }
+    if (globalLoadBalancer.isEnabled()) {
+      // the kernel times are measured to balance adaptive block distributions
+      properties |= CL_QUEUE_PROFILING_ENABLE;
+    }
+    if (defaultOutOfOrderExecution()) {
+      if (  _device.getInfo<CL_DEVICE_QUEUE_PROPERTIES>()
+          & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) {
+        properties |= CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+        _outOfOrder = true;
+      } else {
+        LOG_WARNING("Device `", name(), "' does not support out of order ",
+                    "execution, using in order command queues");
+      }
+    }
+
+    // create command queues for every device
+    _commandQueue  = cl::CommandQueue(_context, _device, properties);
+    _transferQueue = cl::CommandQueue(_context, _device, properties);
+
+    // the host memory is the device memory for CPU devices
+    _zeroCopy = defaultZeroCopy() && isType(CPU);
+
+    _bufferPooling = defaultBufferPooling();
+    _bufferPool.setMaxBytes(globalMemSize() / 4);
+    _bufferPool.setMaxAllocation(maxMemAllocSize());
   } catch (cl::Error& err) {
     ABORT_WITH_ERROR(err);
   }
@@ -122,6 +275,19 @@ cl::Event Device::enqueue(const cl::Kernel& kernel,
                           const cl::NDRange& local,
                           const cl::NDRange& offset,
                           const std::function<void()> callback) const
+{
+  return enqueueKernel(kernel, global, local, offset, nullptr, 0, false,
+                       callback);
+}
+
+cl::Event Device::enqueueKernel(const cl::Kernel& kernel,
+                                const cl::NDRange& global,
+                                const cl::NDRange& local,
+                                const cl::NDRange& offset,
+                                const cl::Buffer* buffers,
+                                size_t bufferCount,
+                                bool buffersKnown,
+                                const std::function<void()>& callback) const
 {
   ASSERT(global.dimensions() == local.dimensions());
 #pragma GCC diagnostic push
@@ -140,22 +306,66 @@ cl::Event Device::enqueue(const cl::Kernel& kernel,
   
   cl::Event event;
   try {
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    // the device accesses the buffers, therefore, they must not be mapped
+    if (buffersKnown) {
+      for (size_t i = 0; i < bufferCount; ++i) {
+        if (buffers[i]() == nullptr) continue; // not a buffer argument
+        unmap(buffers[i], _commandQueue, &_pendingCompute);
+      }
+    } else {
+      for (auto& entry : _bufferEvents) {
+        if (entry.second.mapped == nullptr) continue;
+        unmap(entry.second.mappedBuffer, _commandQueue, &_pendingCompute);
+      }
+    }
+
+    // wait for the commands accessing the buffers used by the kernel
+    std::vector<cl::Event> dependencies;
+    if (buffersKnown) {
+      for (size_t i = 0; i < bufferCount; ++i) {
+        if (buffers[i]() == nullptr) continue; // not a buffer argument
+        addDependencies(buffers[i], true, &dependencies);
+      }
+    } else {
+      ::addPending(&dependencies, _lastUnknownCompute);
+      for (auto& entry : _bufferEvents) {
+        ::addPending(&dependencies, entry.second.write);
+        dependencies.insert(dependencies.end(), entry.second.reads.begin(),
+                                                entry.second.reads.end());
+      }
+    }
+
+    flushForDependencies(dependencies, _commandQueue);
     _commandQueue.enqueueNDRangeKernel(kernel, offset, global, local,
-                                       NULL, &event);
-    _commandQueue.flush(); // always start calculation right away
+                                       &dependencies, &event);
+    // added before submitting, so that the record is submitted as well
+    if (bufferCount != 0 || callback != nullptr) {
+      _completions.add(event, buffers, bufferCount, callback);
+    }
+    submitted(_commandQueue, &_pendingCompute, 0);
+    if (_profiling) {
+      globalProfiler.record(Profiler::KERNEL, _id, event,
+                            kernel.getInfo<CL_KERNEL_FUNCTION_NAME>(), 0,
+                            "global: " + ::printNDRange(global)
+                            + ", local: " + ::printNDRange(local));
+    }
+
+    if (buffersKnown) {
+      for (size_t i = 0; i < bufferCount; ++i) {
+        if (buffers[i]() == nullptr) continue;
+        recordAccess(buffers[i], true, event);
+      }
+    } else {
+      // every following command waits for this kernel, which itself waited
+      // for all commands tracked so far
+      _bufferEvents.clear();
+      _lastUnknownCompute = event;
+    }
   } catch (cl::Error& err) {
     ABORT_WITH_ERROR(err);
   }
 
-  // if callback is given, register the function to be called after the kernel
-  // has finished
-  if (callback != nullptr) {
-    // copy function object to be used as user data
-    // the pointer is deleted inside the invokeCallback wrapper function
-    auto userData = static_cast<void*>(new std::function<void()>(callback));
-    event.setCallback(CL_COMPLETE, ::invokeCallback, userData);
-  }
-
   LOG_DEBUG_INFO("Kernel for device ", _id, " enqueued with global range: ",
                  ::printNDRange(global), ", local: ", ::printNDRange(local),
                  ", offset: ", ::printNDRange(offset));
@@ -166,9 +376,18 @@ cl::Event Device::enqueueWrite(const  DeviceBuffer& buffer,
                                const void* hostPointer,
                                size_t hostOffset) const
 {
+  auto address = static_cast<const char*>(hostPointer)
+               + hostOffset * buffer.elemSize();
+  if (isZeroCopyTransfer(buffer, address, 0)) return unmap(buffer);
+
   cl::Event event;
   try {
-    _commandQueue.enqueueWriteBuffer(buffer.clBuffer(),
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    unmap(buffer.clBuffer(), _transferQueue, &_pendingTransfer);
+    std::vector<cl::Event> dependencies;
+    addDependencies(buffer.clBuffer(), true, &dependencies);
+    flushForDependencies(dependencies, _transferQueue);
+    _transferQueue.enqueueWriteBuffer(buffer.clBuffer(),
                                      CL_FALSE,
                                      0,
                                      buffer.sizeInBytes(),
@@ -176,9 +395,14 @@ cl::Event Device::enqueueWrite(const  DeviceBuffer& buffer,
                                        static_cast<const char*>(
                                          hostPointer)
                                        +(hostOffset * buffer.elemSize() ) ),
-                                     NULL,
+                                     &dependencies,
                                      &event);
-    _commandQueue.flush(); // always start operation right away
+    submitted(_transferQueue, &_pendingTransfer, buffer.sizeInBytes());
+    if (_profiling) {
+      globalProfiler.record(Profiler::WRITE, _id, event, "",
+                            buffer.sizeInBytes(), "");
+    }
+    recordAccess(buffer.clBuffer(), true, event);
   } catch (cl::Error& err) {
     ABORT_WITH_ERROR(err);
   }
@@ -200,9 +424,18 @@ cl::Event Device::enqueueWrite(const  DeviceBuffer& buffer,
                                size_t deviceOffset,
                                size_t hostOffset) const
 {
+  auto address = static_cast<const char*>(hostPointer)
+               + hostOffset * buffer.elemSize();
+  if (isZeroCopyTransfer(buffer, address, deviceOffset)) return unmap(buffer);
+
   cl::Event event;
   try {
-    _commandQueue.enqueueWriteBuffer(buffer.clBuffer(),
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    unmap(buffer.clBuffer(), _transferQueue, &_pendingTransfer);
+    std::vector<cl::Event> dependencies;
+    addDependencies(buffer.clBuffer(), true, &dependencies);
+    flushForDependencies(dependencies, _transferQueue);
+    _transferQueue.enqueueWriteBuffer(buffer.clBuffer(),
                                      CL_FALSE,
                                      (deviceOffset * buffer.elemSize()),
                                      size * buffer.elemSize(),
@@ -210,9 +443,14 @@ cl::Event Device::enqueueWrite(const  DeviceBuffer& buffer,
                                        static_cast<char*const>(
                                          hostPointer)
                                        +(hostOffset * buffer.elemSize() ) ),
-                                     NULL,
+                                     &dependencies,
                                      &event);
-    _commandQueue.flush(); // always start operation right away
+    submitted(_transferQueue, &_pendingTransfer, size * buffer.elemSize());
+    if (_profiling) {
+      globalProfiler.record(Profiler::WRITE, _id, event, "",
+                            size * buffer.elemSize(), "");
+    }
+    recordAccess(buffer.clBuffer(), true, event);
   } catch (cl::Error& err) {
     ABORT_WITH_ERROR(err);
   }
@@ -232,9 +470,18 @@ cl::Event Device::enqueueRead(const DeviceBuffer& buffer,
                               void* hostPointer,
                               size_t hostOffset) const
 {
+  auto address = static_cast<const char*>(hostPointer)
+               + hostOffset * buffer.elemSize();
+  if (isZeroCopyTransfer(buffer, address, 0)) return map(buffer);
+
   cl::Event event;
   try {
-    _commandQueue.enqueueReadBuffer(buffer.clBuffer(),
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    unmap(buffer.clBuffer(), _transferQueue, &_pendingTransfer);
+    std::vector<cl::Event> dependencies;
+    addDependencies(buffer.clBuffer(), false, &dependencies);
+    flushForDependencies(dependencies, _transferQueue);
+    _transferQueue.enqueueReadBuffer(buffer.clBuffer(),
                                     CL_FALSE,
                                     0,
                                     buffer.sizeInBytes(),
@@ -242,9 +489,14 @@ cl::Event Device::enqueueRead(const DeviceBuffer& buffer,
                                       static_cast<char*>(
                                         hostPointer)
                                       +(hostOffset * buffer.elemSize()) ),
-                                    NULL,
+                                    &dependencies,
                                     &event);
-    _commandQueue.flush(); // always start operation right away
+    submitted(_transferQueue, &_pendingTransfer, buffer.sizeInBytes());
+    if (_profiling) {
+      globalProfiler.record(Profiler::READ, _id, event, "",
+                            buffer.sizeInBytes(), "");
+    }
+    recordAccess(buffer.clBuffer(), false, event);
   } catch (cl::Error& err) {
     ABORT_WITH_ERROR(err);
   }
@@ -266,9 +518,18 @@ cl::Event Device::enqueueRead(const DeviceBuffer& buffer,
                               size_t deviceOffset,
                               size_t hostOffset) const
 {
+  auto address = static_cast<const char*>(hostPointer)
+               + hostOffset * buffer.elemSize();
+  if (isZeroCopyTransfer(buffer, address, deviceOffset)) return map(buffer);
+
   cl::Event event;
   try {
-    _commandQueue.enqueueReadBuffer(buffer.clBuffer(),
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    unmap(buffer.clBuffer(), _transferQueue, &_pendingTransfer);
+    std::vector<cl::Event> dependencies;
+    addDependencies(buffer.clBuffer(), false, &dependencies);
+    flushForDependencies(dependencies, _transferQueue);
+    _transferQueue.enqueueReadBuffer(buffer.clBuffer(),
                                     CL_FALSE,
                                     deviceOffset * buffer.elemSize(),
                                     size * buffer.elemSize(),
@@ -276,9 +537,14 @@ cl::Event Device::enqueueRead(const DeviceBuffer& buffer,
                                       static_cast<char*const>(
                                         hostPointer)
                                       +(hostOffset * buffer.elemSize()) ),
-                                    NULL,
+                                    &dependencies,
                                     &event);
-    _commandQueue.flush(); // always start operation right away
+    submitted(_transferQueue, &_pendingTransfer, size * buffer.elemSize());
+    if (_profiling) {
+      globalProfiler.record(Profiler::READ, _id, event, "",
+                            size * buffer.elemSize(), "");
+    }
+    recordAccess(buffer.clBuffer(), false, event);
   } catch (cl::Error& err) {
     ABORT_WITH_ERROR(err);
   }
@@ -301,16 +567,69 @@ cl::Event Device::enqueueCopy(const DeviceBuffer& from,
 {
   ASSERT(    (from.sizeInBytes() - fromOffset)
           <= (to.sizeInBytes() - toOffset) );
+  return enqueueCopy(from, to, fromOffset, toOffset,
+                     from.sizeInBytes() - fromOffset);
+}
+
+cl::Event Device::enqueueCopy(const DeviceBuffer& from,
+                              const DeviceBuffer& to,
+                              size_t fromOffset,
+                              size_t toOffset,
+                              size_t size) const
+{
+  ASSERT(fromOffset + size <= from.sizeInBytes());
+  ASSERT(toOffset + size <= to.sizeInBytes());
+  ASSERT(from.devicePtr().get() == this);
+  auto target = to.devicePtr();
+  bool foreign = (target.get() != this);
+  ASSERT(sharesContextWith(*target));
+
   cl::Event event;
   try {
+    // for a copy to another device, the target's lock is held from looking
+    // up its dependencies until the copy is recorded, so that no command
+    // accessing the target buffer can be enqueued in between
+    std::unique_lock<std::mutex> lock(_queueMutex, std::defer_lock);
+    std::unique_lock<std::mutex> targetLock(target->_queueMutex,
+                                            std::defer_lock);
+    if (foreign) {
+      std::lock(lock, targetLock);
+    } else {
+      lock.lock();
+    }
+
+    std::vector<cl::Event> dependencies;
+    if (foreign) {
+      target->addForeignDependencies(to.clBuffer(), true, &dependencies);
+    }
+    unmap(from.clBuffer(), _commandQueue, &_pendingCompute);
+    addDependencies(from.clBuffer(), false, &dependencies);
+    if (!foreign) {
+      unmap(to.clBuffer(), _commandQueue, &_pendingCompute);
+      addDependencies(to.clBuffer(), true, &dependencies);
+    }
+    flushForDependencies(dependencies, _commandQueue);
     _commandQueue.enqueueCopyBuffer(from.clBuffer(),
                                     to.clBuffer(),
                                     fromOffset,
                                     toOffset,
-                                    from.sizeInBytes() - fromOffset,
-                                    NULL,
+                                    size,
+                                    &dependencies,
                                     &event);
-    _commandQueue.flush(); // always start operation right away
+    submitted(_commandQueue, &_pendingCompute, 0);
+    if (foreign) {
+      // the other device can only wait for a submitted copy
+      flushQueue(_commandQueue, &_pendingCompute);
+    }
+    if (_profiling) {
+      globalProfiler.record(Profiler::COPY, _id, event, "", size, "");
+    }
+    recordAccess(from.clBuffer(), false, event);
+    if (foreign) {
+      target->recordForeignAccess(to.clBuffer(), true, event);
+    } else {
+      recordAccess(to.clBuffer(), true, event);
+    }
   } catch (cl::Error& err) {
     ABORT_WITH_ERROR(err);
   }
@@ -318,24 +637,453 @@ cl::Event Device::enqueueCopy(const DeviceBuffer& from,
   LOG_DEBUG_INFO("Enqueued copy buffer for device ", _id,
                  " (from: ", from.clBuffer()(),
                  ", to: ", to.clBuffer()(),
-                 ", size: ", from.sizeInBytes() - fromOffset,
+                 ", toDevice: ", target->id(),
+                 ", size: ", size,
                  ", fromOffset: ", fromOffset,
                  ", toOffset: ", toOffset, ")");
 
   return event;
 }
 
+void* Device::enqueueMap(const DeviceBuffer& buffer,
+                         bool write,
+                         size_t offset,
+                         size_t size,
+                         cl::Event* event) const
+{
+  ASSERT(offset + size <= buffer.size());
+  void* pointer = nullptr;
+  try {
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    unmap(buffer.clBuffer(), _transferQueue, &_pendingTransfer);
+    std::vector<cl::Event> dependencies;
+    addDependencies(buffer.clBuffer(), write, &dependencies);
+    flushForDependencies(dependencies, _transferQueue);
+    pointer = _transferQueue.enqueueMapBuffer(buffer.clBuffer(),
+                                              CL_FALSE,
+                                              write ? CL_MAP_READ | CL_MAP_WRITE
+                                                    : CL_MAP_READ,
+                                              offset * buffer.elemSize(),
+                                              size * buffer.elemSize(),
+                                              &dependencies,
+                                              event);
+    submitted(_transferQueue, &_pendingTransfer, size * buffer.elemSize());
+    if (_profiling) {
+      globalProfiler.record(Profiler::READ, _id, *event, "map",
+                            size * buffer.elemSize(), "");
+    }
+    recordAccess(buffer.clBuffer(), write, *event);
+  } catch (cl::Error& err) {
+    ABORT_WITH_ERROR(err);
+  }
+
+  LOG_DEBUG_INFO("Enqueued map buffer range for device ", _id,
+                 " (size: ", size * buffer.elemSize(),
+                 ", clBuffer: ", buffer.clBuffer()(),
+                 ", deviceOffset: ", offset * buffer.elemSize(),
+                 ", write: ", write,
+                 ", hostPointer: ", pointer, ")");
+  return pointer;
+}
+
+cl::Event Device::enqueueUnmap(const DeviceBuffer& buffer,
+                               void* pointer,
+                               bool write) const
+{
+  cl::Event event;
+  try {
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    std::vector<cl::Event> dependencies;
+    addDependencies(buffer.clBuffer(), write, &dependencies);
+    flushForDependencies(dependencies, _transferQueue);
+    _transferQueue.enqueueUnmapMemObject(buffer.clBuffer(), pointer,
+                                         &dependencies, &event);
+    submitted(_transferQueue, &_pendingTransfer, 0);
+    recordAccess(buffer.clBuffer(), write, event);
+  } catch (cl::Error& err) {
+    ABORT_WITH_ERROR(err);
+  }
+
+  LOG_DEBUG_INFO("Enqueued unmap buffer range for device ", _id,
+                 " (clBuffer: ", buffer.clBuffer()(),
+                 ", hostPointer: ", pointer, ")");
+  return event;
+}
+
 void Device::wait() const
 {
   LOG_DEBUG_INFO("Start waiting for device with id: ", _id);
   try {
+    std::lock_guard<std::mutex> lock(_queueMutex);
     _commandQueue.finish();
+    _transferQueue.finish();
+    // all tracked events are completed now, only the mapped buffers have to
+    // be remembered
+    for (auto iter = _bufferEvents.begin(); iter != _bufferEvents.end(); ) {
+      if (iter->second.mapped == nullptr) {
+        iter = _bufferEvents.erase(iter);
+      } else {
+        iter->second.write = cl::Event();
+        iter->second.reads.clear();
+        ++iter;
+      }
+    }
+    _lastUnknownCompute = cl::Event();
+    _pendingCompute     = Pending();
+    _pendingTransfer    = Pending();
   } catch (cl::Error& err) {
     ABORT_WITH_ERROR(err);
   }
+  // all kernels have finished, the callbacks are invoked without holding the
+  // lock
+  _completions.retireAll();
   LOG_DEBUG_INFO("Finished waiting for device with id: ", _id);
 }
 
+void Device::flush() const
+{
+  try {
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    flushQueue(_transferQueue, &_pendingTransfer);
+    flushQueue(_commandQueue, &_pendingCompute);
+  } catch (cl::Error& err) {
+    ABORT_WITH_ERROR(err);
+  }
+}
+
+void Device::setFlushPolicy(const FlushPolicy& policy)
+{
+  std::lock_guard<std::mutex> lock(_queueMutex);
+  _flushPolicy = policy;
+}
+
+Device::FlushPolicy Device::flushPolicy() const
+{
+  std::lock_guard<std::mutex> lock(_queueMutex);
+  return _flushPolicy;
+}
+
+void Device::setDefaultFlushPolicy(const FlushPolicy& policy)
+{
+  ::defaultFlushPolicySetting() = policy;
+}
+
+Device::FlushPolicy Device::defaultFlushPolicy()
+{
+  return ::defaultFlushPolicySetting();
+}
+
+bool Device::outOfOrderExecution() const
+{
+  return _outOfOrder;
+}
+
+void Device::setDefaultOutOfOrderExecution(bool enable)
+{
+  ::defaultOutOfOrderSetting() = enable;
+}
+
+bool Device::defaultOutOfOrderExecution()
+{
+  return ::defaultOutOfOrderSetting();
+}
+
+bool Device::zeroCopy() const
+{
+  return _zeroCopy;
+}
+
+void Device::setDefaultZeroCopy(bool enable)
+{
+  ::defaultZeroCopySetting() = enable;
+}
+
+bool Device::defaultZeroCopy()
+{
+  return ::defaultZeroCopySetting();
+}
+
+cl::Buffer Device::allocateBuffer(size_t bytes, cl_mem_flags flags) const
+{
+  if (!_bufferPooling) return cl::Buffer(_context, flags, bytes);
+  try {
+    return _bufferPool.allocate(_context, bytes, flags);
+  } catch (cl::Error& err) {
+    if (_bufferPool.cachedBytes() == 0) throw;
+    // free the memory held by the cached buffers and try once more
+    LOG_WARNING("Allocating ", bytes, " bytes on device ", _id, " failed (",
+                err, "), releasing ", _bufferPool.cachedBytes(),
+                " bytes of cached buffers");
+    for (auto& buffer : _bufferPool.clear()) {
+      finish(buffer);
+      forget(buffer);
+    }
+    return _bufferPool.allocate(_context, bytes, flags);
+  }
+}
+
+void Device::releaseBuffer(const cl::Buffer& buffer, size_t bytes,
+                           cl_mem_flags flags) const
+{
+  if (_bufferPooling) {
+    {
+      std::lock_guard<std::mutex> lock(_queueMutex);
+      try {
+        // only the tracked events are kept, not the mapping
+        unmap(buffer, _transferQueue, &_pendingTransfer);
+      } catch (cl::Error& err) {
+        LOG_ERROR("Unmapping buffer failed (", err, ")");
+      }
+    }
+    if (_bufferPool.release(buffer, bytes, flags)) return;
+  }
+  forget(buffer);
+}
+
+void Device::clearBufferPool() const
+{
+  for (auto& buffer : _bufferPool.clear()) {
+    forget(buffer);
+  }
+}
+
+size_t Device::pooledBytes() const
+{
+  return _bufferPool.cachedBytes();
+}
+
+void Device::setDefaultBufferPooling(bool enable)
+{
+  ::defaultBufferPoolingSetting() = enable;
+}
+
+bool Device::defaultBufferPooling()
+{
+  return ::defaultBufferPoolingSetting();
+}
+
+bool Device::sharesContextWith(const Device& other) const
+{
+  return _context() == other._context();
+}
+
+void Device::setDefaultSharedContext(bool enable)
+{
+  ::defaultSharedContextSetting() = enable;
+}
+
+bool Device::defaultSharedContext()
+{
+  return ::defaultSharedContextSetting();
+}
+
+void Device::forget(const cl::Buffer& buffer) const
+{
+  std::lock_guard<std::mutex> lock(_queueMutex);
+  try {
+    unmap(buffer, _transferQueue, &_pendingTransfer);
+  } catch (cl::Error& err) {
+    LOG_ERROR("Unmapping buffer failed (", err, ")");
+  }
+  _bufferEvents.erase(buffer());
+}
+
+void Device::finish(const cl::Buffer& buffer) const
+{
+  std::vector<cl::Event> events;
+  try {
+    {
+      std::lock_guard<std::mutex> lock(_queueMutex);
+      unmap(buffer, _transferQueue, &_pendingTransfer);
+      addDependencies(buffer, true, &events);
+      if (events.empty()) return;
+      // only submitted commands can be waited for
+      flushQueue(_transferQueue, &_pendingTransfer);
+      flushQueue(_commandQueue, &_pendingCompute);
+    }
+    cl::Event::waitForEvents(events);
+  } catch (cl::Error& err) {
+    ABORT_WITH_ERROR(err);
+  }
+}
+
+void Device::addDependencies(const cl::Buffer& buffer, bool write,
+                             std::vector<cl::Event>* events) const
+{
+  ::addPending(events, _lastUnknownCompute);
+  auto iter = _bufferEvents.find(buffer());
+  if (iter == _bufferEvents.end()) return;
+
+  // read after write
+  ::addPending(events, iter->second.write);
+  if (write) {
+    // write after read
+    events->insert(events->end(), iter->second.reads.begin(),
+                                  iter->second.reads.end());
+  }
+}
+
+void Device::recordAccess(const cl::Buffer& buffer, bool write,
+                          const cl::Event& event) const
+{
+  auto& entry = _bufferEvents[buffer()];
+  if (write) {
+    // the new writer waited for all readers
+    entry.write = event;
+    entry.reads.clear();
+  } else {
+    if (entry.reads.size() >= ::maxTrackedReads) {
+      entry.reads.erase(std::remove_if(entry.reads.begin(), entry.reads.end(),
+                                       ::isComplete),
+                        entry.reads.end());
+    }
+    entry.reads.push_back(event);
+  }
+}
+
+void Device::flushForDependencies(const std::vector<cl::Event>& dependencies,
+                                  const cl::CommandQueue& queue) const
+{
+  if (dependencies.empty()) return;
+  // commands of the other queue have to be submitted to be waited for
+  if (queue() == _commandQueue()) {
+    flushQueue(_transferQueue, &_pendingTransfer);
+  } else {
+    flushQueue(_commandQueue, &_pendingCompute);
+  }
+}
+
+void Device::addForeignDependencies(const cl::Buffer& buffer, bool write,
+                                    std::vector<cl::Event>* events) const
+{
+  unmap(buffer, _commandQueue, &_pendingCompute);
+  addDependencies(buffer, write, events);
+  // the other device can only wait for submitted commands
+  flushQueue(_transferQueue, &_pendingTransfer);
+  flushQueue(_commandQueue, &_pendingCompute);
+}
+
+void Device::recordForeignAccess(const cl::Buffer& buffer, bool write,
+                                 const cl::Event& event) const
+{
+  recordAccess(buffer, write, event);
+}
+
+bool Device::isZeroCopyTransfer(const DeviceBuffer& buffer,
+                                const void* hostPointer,
+                                size_t deviceOffset) const
+{
+  if (buffer.hostPointer() == nullptr) return false;
+  // only the buffer's own host memory can be synchronized by mapping
+  return    static_cast<const char*>(buffer.hostPointer())
+          + deviceOffset * buffer.elemSize()
+         == hostPointer;
+}
+
+cl::Event Device::map(const DeviceBuffer& buffer) const
+{
+  cl::Event event;
+  try {
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    if (_bufferEvents[buffer.clBuffer()()].mapped != nullptr) {
+      // the host memory is up to date already
+      _transferQueue.enqueueMarker(&event);
+      submitted(_transferQueue, &_pendingTransfer, 0);
+      return event;
+    }
+
+    std::vector<cl::Event> dependencies;
+    addDependencies(buffer.clBuffer(), true, &dependencies);
+    flushForDependencies(dependencies, _transferQueue);
+    auto pointer = _transferQueue.enqueueMapBuffer(buffer.clBuffer(),
+                                                   CL_FALSE,
+                                                   CL_MAP_READ | CL_MAP_WRITE,
+                                                   0,
+                                                   buffer.sizeInBytes(),
+                                                   &dependencies,
+                                                   &event);
+    submitted(_transferQueue, &_pendingTransfer, 0);
+    recordAccess(buffer.clBuffer(), true, event);
+    auto& entry        = _bufferEvents[buffer.clBuffer()()];
+    entry.mappedBuffer = buffer.clBuffer();
+    entry.mapped       = pointer;
+  } catch (cl::Error& err) {
+    ABORT_WITH_ERROR(err);
+  }
+
+  LOG_DEBUG_INFO("Enqueued map buffer for device ", _id,
+                 " (size: ", buffer.sizeInBytes(),
+                 ", clBuffer: ", buffer.clBuffer()(),
+                 ", hostPointer: ", buffer.hostPointer(), ")");
+  return event;
+}
+
+cl::Event Device::unmap(const DeviceBuffer& buffer) const
+{
+  cl::Event event;
+  try {
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    auto iter = _bufferEvents.find(buffer.clBuffer()());
+    if (iter != _bufferEvents.end() && iter->second.mapped != nullptr) {
+      unmap(buffer.clBuffer(), _transferQueue, &_pendingTransfer);
+      event = _bufferEvents[buffer.clBuffer()()].write;
+    } else {
+      // the buffer uses the host memory directly
+      _transferQueue.enqueueMarker(&event);
+      submitted(_transferQueue, &_pendingTransfer, 0);
+    }
+  } catch (cl::Error& err) {
+    ABORT_WITH_ERROR(err);
+  }
+
+  LOG_DEBUG_INFO("Enqueued unmap buffer for device ", _id,
+                 " (size: ", buffer.sizeInBytes(),
+                 ", clBuffer: ", buffer.clBuffer()(),
+                 ", hostPointer: ", buffer.hostPointer(), ")");
+  return event;
+}
+
+void Device::unmap(const cl::Buffer& buffer, const cl::CommandQueue& queue,
+                   Pending* pending) const
+{
+  auto iter = _bufferEvents.find(buffer());
+  if (iter == _bufferEvents.end() || iter->second.mapped == nullptr) return;
+
+  std::vector<cl::Event> dependencies;
+  addDependencies(buffer, true, &dependencies);
+  flushForDependencies(dependencies, queue);
+  cl::Event event;
+  queue.enqueueUnmapMemObject(buffer, iter->second.mapped, &dependencies,
+                              &event);
+  submitted(queue, pending, 0);
+  recordAccess(buffer, true, event);
+  iter->second.mappedBuffer = cl::Buffer();
+  iter->second.mapped       = nullptr;
+}
+
+void Device::submitted(const cl::CommandQueue& queue, Pending* pending,
+                       size_t bytes) const
+{
+  ++pending->commands;
+  pending->bytes += bytes;
+  if (   (   _flushPolicy.maxCommands != 0
+          && pending->commands >= _flushPolicy.maxCommands)
+      || (   _flushPolicy.maxBytes != 0
+          && pending->bytes >= _flushPolicy.maxBytes) ) {
+    flushQueue(queue, pending);
+  }
+}
+
+void Device::flushQueue(const cl::CommandQueue& queue, Pending* pending) const
+{
+  if (pending->commands == 0) return;
+  queue.flush();
+  *pending = Pending();
+  if (queue() == _commandQueue()) {
+    _completions.submitted();
+  }
+}
+
 Device::id_type Device::id() const
 {
   return _id;
@@ -356,6 +1104,11 @@ std::string Device::vendorName() const
   return _device.getInfo<CL_DEVICE_VENDOR>();
 }
 
+std::string Device::driverVersion() const
+{
+  return _device.getInfo<CL_DRIVER_VERSION>();
+}
+
 unsigned int Device::maxClockFrequency() const
 {
   return _device.getInfo<CL_DEVICE_MAX_CLOCK_FREQUENCY>();
@@ -382,6 +1135,18 @@ unsigned long Device::globalMemSize() const
   return _device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>();
 }
 
+unsigned long Device::maxMemAllocSize() const
+{
+  return _device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
+}
+
+size_t Device::memBaseAddrAlign() const
+{
+  // the alignment is given in bits
+  return std::max<size_t>(_device.getInfo<CL_DEVICE_MEM_BASE_ADDR_ALIGN>() / 8,
+                          1);
+}
+
 unsigned long Device::localMemSize() const
 {
   return _device.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>();
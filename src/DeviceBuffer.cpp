@@ -37,6 +37,7 @@
 /// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
 ///
 
+#include <cstdint>
 #include <sstream>
 #include <string>
 #include <memory>
@@ -60,16 +61,35 @@ using namespace skelcl::detail;
 cl::Buffer createCLBuffer(const std::shared_ptr<Device>& devicePtr,
                           const size_t size,
                           const size_t elemSize,
-                          cl_mem_flags flags) {
+                          cl_mem_flags flags,
+                          void* hostPointer = nullptr) {
   cl::Buffer buffer;
   try {
-    buffer = cl::Buffer(devicePtr->clContext(), flags, size * elemSize);
+    if (hostPointer == nullptr) {
+      buffer = devicePtr->allocateBuffer(size * elemSize, flags);
+    } else {
+      buffer = cl::Buffer(devicePtr->clContext(), flags, size * elemSize,
+                          hostPointer);
+    }
   } catch (cl::Error& err) {
     ABORT_WITH_ERROR(err);
   }
   return buffer;
 }
 
+void* zeroCopyPointer(const std::shared_ptr<Device>& devicePtr,
+                      void* hostPointer)
+{
+  if (!devicePtr->zeroCopy()) return nullptr;
+  auto address = reinterpret_cast<std::uintptr_t>(hostPointer);
+  if (address % devicePtr->memBaseAddrAlign() != 0) {
+    LOG_DEBUG_INFO("Host memory ", hostPointer, " is not aligned for device ",
+                   devicePtr->id(), ", creating a regular buffer");
+    return nullptr;
+  }
+  return hostPointer;
+}
+
 } // namespace
 
 namespace skelcl {
@@ -77,7 +97,8 @@ namespace skelcl {
 namespace detail {
 
 DeviceBuffer::DeviceBuffer()
-  : _device(), _size(), _elemSize(), _flags(), _buffer()
+  : _device(), _size(), _elemSize(), _flags(), _hostPointer(nullptr),
+    _buffer()
 {
 }
 
@@ -89,17 +110,39 @@ DeviceBuffer::DeviceBuffer(const std::shared_ptr<Device>& devicePtr,
     _size(size),
     _elemSize(elemSize),
     _flags(flags),
+    _hostPointer(nullptr),
     _buffer(::createCLBuffer(_device, _size, _elemSize, _flags))
 {
   LOG_DEBUG_INFO("Created new DeviceBuffer object (", this, ") with ",
                  getInfo());
 }
 
+DeviceBuffer::DeviceBuffer(const std::shared_ptr<Device>& devicePtr,
+                           const size_t size,
+                           const size_t elemSize,
+                           void* hostPointer,
+                           cl_mem_flags flags)
+  : _device(devicePtr),
+    _size(size),
+    _elemSize(elemSize),
+    _flags(flags),
+    _hostPointer(::zeroCopyPointer(devicePtr, hostPointer)),
+    _buffer()
+{
+  if (_hostPointer != nullptr) {
+    _flags |= CL_MEM_USE_HOST_PTR;
+  }
+  _buffer = ::createCLBuffer(_device, _size, _elemSize, _flags, _hostPointer);
+  LOG_DEBUG_INFO("Created new DeviceBuffer object (", this, ") with ",
+                 getInfo());
+}
+
 DeviceBuffer::DeviceBuffer(const DeviceBuffer& rhs)
   : _device(rhs._device),
     _size(rhs._size),
     _elemSize(rhs._elemSize),
-    _flags(rhs._flags),
+    _flags(rhs._flags & ~cl_mem_flags(CL_MEM_USE_HOST_PTR)),
+    _hostPointer(nullptr),
     _buffer()
 {
   // make deep copy of the rhs buffer
@@ -115,8 +158,10 @@ DeviceBuffer::DeviceBuffer(DeviceBuffer&& rhs)
     _size(std::move(rhs._size)),
     _elemSize(std::move(rhs._elemSize)),
     _flags(std::move(rhs._flags)),
+    _hostPointer(rhs._hostPointer),
     _buffer(std::move(rhs._buffer)) // only wrapper object (pointer) is copied
 {
+  rhs._hostPointer = nullptr;
   rhs._size     = 0;
   rhs._elemSize = 0;
   rhs._buffer   = cl::Buffer();
@@ -127,10 +172,12 @@ DeviceBuffer::DeviceBuffer(DeviceBuffer&& rhs)
 DeviceBuffer& DeviceBuffer::operator=(const DeviceBuffer& rhs)
 {
   if (this == &rhs) return *this; // handle self assignement
+  release();
   _device   = rhs._device;
   _size     = rhs._size;
   _elemSize = rhs._elemSize;
-  _flags    = rhs._flags;
+  _flags    = rhs._flags & ~cl_mem_flags(CL_MEM_USE_HOST_PTR);
+  _hostPointer = nullptr;
   // make deep copy of the rhs buffer
   _buffer   = ::createCLBuffer(_device, _size, _elemSize, _flags);
   _device->enqueueCopy(rhs, *this);
@@ -143,12 +190,15 @@ DeviceBuffer& DeviceBuffer::operator=(const DeviceBuffer& rhs)
 DeviceBuffer& DeviceBuffer::operator=(DeviceBuffer&& rhs)
 {
   if (this == &rhs) return *this;
+  release();
   _device   = std::move(rhs._device);
   _size     = std::move(rhs._size);
   _elemSize = std::move(rhs._elemSize);
   _flags    = std::move(rhs._flags);
+  _hostPointer = rhs._hostPointer;
   _buffer   = std::move(rhs._buffer); // copy only wrapper object (pointer)
 
+  rhs._hostPointer = nullptr;
   rhs._size     = 0;
   rhs._elemSize = 0;
   rhs._buffer   = cl::Buffer();
@@ -164,13 +214,7 @@ DeviceBuffer::~DeviceBuffer()
   } else {
     LOG_DEBUG_INFO("DeviceBuffer object (", this, ") destroyed");
   }
-  if (_buffer() != nullptr) {
-    auto refCount = _buffer.getInfo<CL_MEM_REFERENCE_COUNT>();
-    if (refCount > 1) {
-      LOG_DEBUG_INFO("OpenCL Buffer object remains alive (Ref count ",
-                     refCount, ")");
-    }
-  }
+  release();
 }
 
 std::shared_ptr<Device> DeviceBuffer::devicePtr() const
@@ -198,17 +242,36 @@ const cl::Buffer& DeviceBuffer::clBuffer() const
   return _buffer;
 }
 
+void* DeviceBuffer::hostPointer() const
+{
+  return _hostPointer;
+}
+
 bool DeviceBuffer::isValid() const
 {
   return (_buffer() != NULL);
 }
 
+void DeviceBuffer::release()
+{
+  if (_buffer() == nullptr) return;
+  if (_hostPointer != nullptr) {
+    // the host memory is freed by the container after the buffer is released
+    _device->finish(_buffer);
+    _device->forget(_buffer);
+  } else {
+    // the buffer can be reused for later allocations on the device
+    _device->releaseBuffer(_buffer, sizeInBytes(), _flags);
+  }
+}
+
 std::string DeviceBuffer::getInfo() const
 {
   std::stringstream s;
   s << "device: "   << _device->id()
     << ", size: "   << _size
     << ", flags: "  << _flags
+    << ", hostPointer: " << _hostPointer
     << ", buffer: " << _buffer();
   return s.str();
 }
@@ -100,6 +100,7 @@ void DeviceList::init(DeviceProperties properties)
       LOG_INFO(devices.size(), " device(s) for OpenCL platform `",
                platform.getInfo<CL_PLATFORM_NAME>(), "' found");
 
+      std::vector<cl::Device> selected;
       for (auto& device : devices) {
         // ... if device not matches properties ..
         if (!properties.matchAndTake(device)) {
@@ -107,10 +108,32 @@ void DeviceList::init(DeviceProperties properties)
                    "' not machting given criteria for device selection.");
           continue; // skip device
         }
-        // ... create Device instance and push into _devices
+        // ... select the device (or its sub-devices, if partitioned) ...
+        auto parts = properties.partition(device);
+        selected.insert(selected.end(), parts.begin(), parts.end());
+      }
+      if (selected.empty()) continue;
+
+      // ... create a context shared by the selected devices if requested ...
+      cl::Context context;
+      if (Device::defaultSharedContext()) {
+        cl_context_properties props[] = {
+                    CL_CONTEXT_PLATFORM,
+                    reinterpret_cast<cl_context_properties>( (platform)() ),
+                    0
+                  };
+        context = cl::Context(selected, props);
+        LOG_INFO("Created context shared by ", selected.size(),
+                 " device(s) of OpenCL platform `",
+                 platform.getInfo<CL_PLATFORM_NAME>(), "'");
+      }
+
+      // ... create Device instances and push them into _devices
+      for (auto& device : selected) {
         _devices.push_back( std::make_shared<Device>(device,
                                                      platform,
-                                                     deviceId)
+                                                     deviceId,
+                                                     context)
                           );
         ++deviceId;
       }
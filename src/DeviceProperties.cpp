@@ -39,11 +39,21 @@
 
 #include <string>
 #include <limits>
+#include <vector>
+
+#define __CL_ENABLE_EXCEPTIONS
+#include <CL/cl.hpp>
+#undef  __CL_ENABLE_EXCEPTIONS
+
+#include <pvsutil/Logger.h>
 
 #include "SkelCL/detail/DeviceProperties.h"
 
 namespace {
 
+// terminates the property list and the list of counts
+const cl_device_partition_property_ext listEnd = 0;
+
 } // namespace
 
 namespace skelcl {
@@ -67,7 +77,8 @@ DeviceProperties DeviceProperties::allDevices()
 DeviceProperties::DeviceProperties()
   : _deviceType(Device::Type::ALL),
     _takeAll(false),
-    _count(0)//,
+    _count(0),
+    _partition()//,
 #if 0
     _id(std::numeric_limits<Device::id_type>::max()),
     _name(),
@@ -116,6 +127,66 @@ DeviceProperties& DeviceProperties::deviceType(Device::Type value)
   return *this;
 }
 
+DeviceProperties& DeviceProperties::partitionEqually(unsigned int computeUnits)
+{
+  _partition = { CL_DEVICE_PARTITION_EQUALLY_EXT, computeUnits, ::listEnd };
+  return *this;
+}
+
+DeviceProperties& DeviceProperties::partitionByCounts(
+                                  const std::vector<unsigned int>& computeUnits)
+{
+  _partition.assign(1, CL_DEVICE_PARTITION_BY_COUNTS_EXT);
+  _partition.insert(_partition.end(), computeUnits.begin(),
+                                      computeUnits.end());
+  _partition.push_back(::listEnd); // end of counts
+  _partition.push_back(::listEnd);
+  return *this;
+}
+
+DeviceProperties& DeviceProperties::partitionByNumaDomain()
+{
+  _partition = { CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN_EXT,
+                 CL_AFFINITY_DOMAIN_NUMA_EXT, ::listEnd };
+  return *this;
+}
+
+std::vector<cl::Device>
+  DeviceProperties::partition(const cl::Device& device) const
+{
+  std::vector<cl::Device> devices(1, device);
+  if (   _partition.empty()
+      || device.getInfo<CL_DEVICE_TYPE>() != CL_DEVICE_TYPE_CPU) {
+    return devices;
+  }
+
+  auto name = device.getInfo<CL_DEVICE_NAME>();
+  auto create = reinterpret_cast<clCreateSubDevicesEXT_fn>(
+                  clGetExtensionFunctionAddress("clCreateSubDevicesEXT"));
+  if (   device.getInfo<CL_DEVICE_EXTENSIONS>().find("cl_ext_device_fission")
+          == std::string::npos
+      || create == nullptr) {
+    LOG_WARNING("Device `", name, "' does not support partitioning, ",
+                "using it as a whole");
+    return devices;
+  }
+
+  cl_uint count = 0;
+  cl_int err = create(device(), _partition.data(), 0, nullptr, &count);
+  std::vector<cl_device_id> ids(count);
+  if (err == CL_SUCCESS && count > 0) {
+    err = create(device(), _partition.data(), count, ids.data(), nullptr);
+  }
+  if (err != CL_SUCCESS || count == 0) {
+    LOG_WARNING("Partitioning device `", name, "' failed (error ", err,
+                "), using it as a whole");
+    return devices;
+  }
+
+  LOG_INFO("Partitioned device `", name, "' into ", count, " sub-devices");
+  return std::vector<cl::Device>(ids.begin(), ids.end());
+}
+
 } // namespace detail
 
 } // namespace skelcl
@@ -0,0 +1,134 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file KernelCache.cpp
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define __CL_ENABLE_EXCEPTIONS
+#include <CL/cl.hpp>
+#undef  __CL_ENABLE_EXCEPTIONS
+
+#include <pvsutil/Logger.h>
+
+#include "SkelCL/detail/KernelCache.h"
+
+namespace skelcl {
+
+namespace detail {
+
+KernelCache::KernelCache()
+  : _mutex(), _kernels()
+{
+}
+
+KernelCache::~KernelCache()
+{
+}
+
+CachedKernel KernelCache::checkout(const cl::Program& program,
+                                   Device::id_type device,
+                                   const std::string& name)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& kernels = _kernels[key_type(device, name)];
+    if (!kernels.empty()) {
+      cl::Kernel kernel = kernels.back();
+      kernels.pop_back();
+      return CachedKernel(kernel, shared_from_this(), device, name);
+    }
+  }
+
+  // create a new kernel without holding the lock
+  LOG_DEBUG_INFO("Create kernel ", name, " for device ", device);
+  return CachedKernel(cl::Kernel(program, name.c_str()), shared_from_this(),
+                      device, name);
+}
+
+void KernelCache::checkin(Device::id_type device,
+                          const std::string& name,
+                          const cl::Kernel& kernel)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _kernels[key_type(device, name)].push_back(kernel);
+}
+
+CachedKernel::CachedKernel(const cl::Kernel& kernel,
+                           const std::shared_ptr<KernelCache>& cache,
+                           Device::id_type device,
+                           const std::string& name)
+  : cl::Kernel(kernel), _cache(cache), _device(device), _name(name)
+{
+}
+
+CachedKernel::CachedKernel(CachedKernel&& rhs)
+  : cl::Kernel(rhs), _cache(std::move(rhs._cache)), _device(rhs._device),
+    _name(std::move(rhs._name))
+{
+}
+
+CachedKernel& CachedKernel::operator=(CachedKernel&& rhs)
+{
+  if (this != &rhs) {
+    if (_cache) {
+      _cache->checkin(_device, _name, *this);
+    }
+    cl::Kernel::operator=(rhs);
+    _cache  = std::move(rhs._cache);
+    _device = rhs._device;
+    _name   = std::move(rhs._name);
+  }
+  return *this;
+}
+
+CachedKernel::~CachedKernel()
+{
+  // moved-from objects don't own the kernel anymore
+  if (_cache) {
+    _cache->checkin(_device, _name, *this);
+  }
+}
+
+} // namespace detail
+
+} // namespace skelcl
@@ -0,0 +1,299 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+///
+/// \file LoadBalancer.cpp
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define __CL_ENABLE_EXCEPTIONS
+#include <CL/cl.hpp>
+#undef  __CL_ENABLE_EXCEPTIONS
+
+#include <pvsutil/Logger.h>
+
+#include "SkelCL/detail/LoadBalancer.h"
+
+#include "SkelCL/detail/Device.h"
+#include "SkelCL/detail/DeviceList.h"
+#include "SkelCL/detail/ProgramCache.h"
+#include "SkelCL/detail/Significances.h"
+#include "SkelCL/detail/Util.h"
+
+namespace {
+
+typedef skelcl::detail::Significances::value_type value_type;
+
+// weight of a new measurement in the moving average of the throughput
+const double smoothing = 0.5;
+
+// the significances are only changed if one of them changes by more than this
+const double threshold = 0.05;
+
+// computes significances proportional to the given values of the devices
+std::vector<value_type>
+  proportionalWeights(const std::vector<skelcl::detail::Device::id_type>&
+                        devices,
+                      const std::vector<double>& values)
+{
+  double total = 0.0;
+  for (auto id : devices) total += values[id];
+
+  std::vector<value_type> weights(values.size(), 0.0f);
+  for (auto id : devices) {
+    weights[id] = static_cast<value_type>(values[id] / total);
+  }
+
+  // make sure rounding does not make the significances exceed one
+  auto largest = std::max_element(weights.begin(), weights.end());
+  while (std::accumulate(weights.begin(), weights.end(), 0.0f) > 1.0f) {
+    *largest = std::nextafter(*largest, 0.0f);
+  }
+  return weights;
+}
+
+} // namespace
+
+namespace skelcl {
+
+namespace detail {
+
+LoadBalancer globalLoadBalancer;
+
+LoadBalancer::Entry::Entry()
+  : devices(), throughputs(), weights(), modified(false)
+{
+}
+
+LoadBalancer::LoadBalancer()
+  : _mutex(), _enabled(util::envVarValue("SKELCL_ADAPTIVE_BLOCK") == "YES"),
+    _entries(), _records()
+{
+}
+
+LoadBalancer::~LoadBalancer()
+{
+}
+
+bool LoadBalancer::isEnabled() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _enabled;
+}
+
+void LoadBalancer::setEnabled(bool enabled)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _enabled = enabled;
+}
+
+Significances LoadBalancer::significances(const std::string& key,
+                                          const DeviceList& devices)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  update();
+  auto& e = entry(key, devices);
+
+  // wait until every device has been measured
+  for (auto id : e.devices) {
+    if (e.throughputs[id] <= 0.0) return Significances(e.weights);
+  }
+
+  auto weights = proportionalWeights(e.devices, e.throughputs);
+  double change = 0.0;
+  for (auto id : e.devices) {
+    change = std::max(change, std::fabs(static_cast<double>(weights[id])
+                                        - e.weights[id]));
+  }
+  if (change > threshold) {
+    e.weights   = std::move(weights);
+    e.modified  = true;
+    LOG_DEBUG_INFO("Adapt significances of block distribution by ", change);
+  }
+  return Significances(e.weights);
+}
+
+void LoadBalancer::record(const std::string& key,
+                          const DeviceList& devices,
+                          const Device& device,
+                          size_t elements,
+                          const cl::Event& event)
+{
+  if (elements == 0) return;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!_enabled) return;
+  entry(key, devices);
+  _records.push_back( Record{ cacheKey(key, devices), device.id(), elements,
+                              event } );
+}
+
+void LoadBalancer::recordThroughput(const std::string& key,
+                                    const DeviceList& devices,
+                                    const Device& device,
+                                    size_t elements,
+                                    cl_ulong nanoseconds)
+{
+  if (elements == 0 || nanoseconds == 0) return;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!_enabled) return;
+  entry(key, devices);
+  addThroughput(cacheKey(key, devices), device.id(), elements, nanoseconds);
+}
+
+void LoadBalancer::save()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  update();
+  _records.clear();
+
+  for (auto& pair : _entries) {
+    auto& e = pair.second;
+    if (!e.modified) continue;
+
+    std::stringstream s;
+    for (auto id : e.devices) s << e.weights[id] << "\n";
+    globalProgramCache.store(pair.first, s.str());
+    e.modified = false;
+  }
+}
+
+void LoadBalancer::clear()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _entries.clear();
+  _records.clear();
+}
+
+LoadBalancer::Entry& LoadBalancer::entry(const std::string& key,
+                                         const DeviceList& devices)
+{
+  auto k = cacheKey(key, devices);
+  auto iter = _entries.find(k);
+  if (iter != _entries.end()) return iter->second;
+
+  Entry e;
+  Device::id_type maxId = 0;
+  for (auto& devicePtr : devices) {
+    e.devices.push_back(devicePtr->id());
+    maxId = std::max(maxId, devicePtr->id());
+  }
+  e.throughputs.assign(maxId + 1, 0.0);
+
+  // start with the significances learned in a previous run, if any
+  std::vector<double> stored(maxId + 1, 0.0);
+  std::string data;
+  if (globalProgramCache.load(k, &data)) {
+    std::istringstream s(data);
+    for (auto id : e.devices) {
+      if (!(s >> stored[id]) || stored[id] <= 0.0) {
+        stored.assign(maxId + 1, 0.0);
+        break;
+      }
+    }
+  }
+  if (!e.devices.empty() && stored[e.devices.front()] > 0.0) {
+    LOG_DEBUG_INFO("Use significances of block distribution from cache");
+  } else {
+    for (auto id : e.devices) stored[id] = 1.0;
+  }
+  e.weights = proportionalWeights(e.devices, stored);
+
+  return _entries.insert(std::make_pair(k, std::move(e))).first->second;
+}
+
+void LoadBalancer::update()
+{
+  auto finished = std::remove_if(_records.begin(), _records.end(),
+    [&](Record& r) {
+      cl_ulong start  = 0;
+      cl_ulong end    = 0;
+      try {
+        auto status = static_cast<cl_int>(
+                        r.event.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>());
+        if (status < 0) return true; // failed, nothing to learn from
+        if (status != CL_COMPLETE) return false;
+        start = r.event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+        end   = r.event.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+      } catch (cl::Error& err) {
+        LOG_WARNING("Could not measure kernel for load balancing (error ",
+                    err.err(), ")");
+        return true;
+      }
+      if (end > start) addThroughput(r.key, r.device, r.elements, end - start);
+      return true;
+    });
+  _records.erase(finished, _records.end());
+}
+
+void LoadBalancer::addThroughput(const std::string& cacheKey,
+                                 Device::id_type device,
+                                 size_t elements,
+                                 cl_ulong nanoseconds)
+{
+  auto iter = _entries.find(cacheKey);
+  if (iter == _entries.end()) return;
+
+  auto& throughput = iter->second.throughputs[device];
+  auto measured = static_cast<double>(elements)
+                  / static_cast<double>(nanoseconds);
+  throughput = (throughput <= 0.0)
+               ? measured
+               : (1.0 - smoothing) * throughput + smoothing * measured;
+}
+
+std::string LoadBalancer::cacheKey(const std::string& key,
+                                   const DeviceList& devices)
+{
+  std::stringstream s;
+  s << "balance\n" << key << "\n";
+  for (auto& devicePtr : devices) {
+    s << devicePtr->id() << " " << devicePtr->name() << " "
+      << devicePtr->driverVersion() << "\n";
+  }
+  return util::hash(s.str());
+}
+
+} // namespace detail
+
+} // namespace skelcl
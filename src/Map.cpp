@@ -45,6 +45,7 @@
 #include "SkelCL/Source.h"
 
 #include "SkelCL/detail/Program.h"
+#include "SkelCL/detail/ProgramRegistry.h"
 
 namespace skelcl {
   
@@ -56,7 +57,7 @@ Map<void(Index)>::Map(const Source& source, const std::string& funcName)
 {
 }
 
-detail::Program
+detail::Program::ptr_type
     Map<void(Index)>::createAndBuildProgram(const std::string& source,
                                             const std::string& funcName) const
 {
@@ -83,21 +84,24 @@ __kernel void SCL_MAP(const unsigned int SCL_ELEMENTS,
   }
 }
              )");
-  auto program = detail::Program(s, detail::util::hash(s));
-
-  // modify program
-  if (!program.loadBinary()) {
-    // append parameters from user function to kernel
-    program.transferParameters(funcName, 1, "SCL_MAP");
-    program.transferArguments(funcName, 1, "SCL_FUNC");
-    // rename user function
-    program.renameFunction(funcName, "SCL_FUNC");
-  }
-
-  // build program
-  program.build();
-
-  return program;
+  auto hash = detail::util::hash("//Map\n" + s + funcName);
+  return detail::globalProgramRegistry.lookupOrCreate(hash, [&] {
+    auto program = detail::Program(s, hash);
+
+    // modify program
+    if (!program.loadBinary() && !program.loadSource()) {
+      // append parameters from user function to kernel
+      program.transferParameters(funcName, 1, "SCL_MAP");
+      program.transferArguments(funcName, 1, "SCL_FUNC");
+      // rename user function
+      program.renameFunction(funcName, "SCL_FUNC");
+    }
+
+    // build program
+    program.build();
+
+    return program;
+  });
 }
 
 // ## Map<IndexPoint, void> ################################################
@@ -107,7 +111,7 @@ Map<void(IndexPoint)>::Map(const Source& source, const std::string& funcName)
 {
 }
 
-detail::Program Map<void(IndexPoint)>::createAndBuildProgram(
+detail::Program::ptr_type Map<void(IndexPoint)>::createAndBuildProgram(
     const std::string& source, const std::string& funcName) const
 {
   ASSERT_MESSAGE(!source.empty(),
@@ -141,21 +145,24 @@ __kernel void SCL_MAP(const unsigned int SCL_COL_COUNT,
   }
 }
 )");
-  auto program = detail::Program(s, detail::util::hash(s));
-  
-  // modify program
-  if (!program.loadBinary()) {
-    // append parameters from user function to kernel
-    program.transferParameters(funcName, 1, "SCL_MAP");
-    program.transferArguments(funcName, 1, "SCL_FUNC");
-    // rename user function
-    program.renameFunction(funcName, "SCL_FUNC");
-  }
-  
-  // build program
-  program.build();
-  
-  return program;
+  auto hash = detail::util::hash("//Map\n" + s + funcName);
+  return detail::globalProgramRegistry.lookupOrCreate(hash, [&] {
+    auto program = detail::Program(s, hash);
+
+    // modify program
+    if (!program.loadBinary() && !program.loadSource()) {
+      // append parameters from user function to kernel
+      program.transferParameters(funcName, 1, "SCL_MAP");
+      program.transferArguments(funcName, 1, "SCL_FUNC");
+      // rename user function
+      program.renameFunction(funcName, "SCL_FUNC");
+    }
+
+    // build program
+    program.build();
+
+    return program;
+  });
 }
   
 } // namespace skelcl
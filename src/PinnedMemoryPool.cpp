@@ -0,0 +1,267 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file PinnedMemoryPool.cpp
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <new>
+
+#define __CL_ENABLE_EXCEPTIONS
+#include <CL/cl.hpp>
+#undef  __CL_ENABLE_EXCEPTIONS
+
+#include <pvsutil/Logger.h>
+
+#include "SkelCL/detail/PinnedMemoryPool.h"
+
+#include "SkelCL/detail/Device.h"
+#include "SkelCL/detail/DeviceList.h"
+#include "SkelCL/detail/Util.h"
+
+namespace {
+
+// pinned chunks are allocated in multiples of this size
+const size_t granularity = 64 * 1024;
+
+// heap allocations of at least this size are aligned to it
+const size_t pageSize = 4096;
+
+size_t roundUp(size_t bytes)
+{
+  return ((bytes + granularity - 1) / granularity) * granularity;
+}
+
+// the pointer returned by operator new is stored right before the aligned
+// memory handed out
+void* heapAllocate(size_t bytes)
+{
+  if (bytes < pageSize) return ::operator new(bytes);
+
+  auto raw = static_cast<char*>(
+               ::operator new(bytes + pageSize + sizeof(void*)));
+  auto address = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+  auto aligned = reinterpret_cast<char*>(
+                   (address + pageSize - 1) & ~(pageSize - 1));
+  reinterpret_cast<void**>(aligned)[-1] = raw;
+  return aligned;
+}
+
+void heapDeallocate(void* pointer, size_t bytes)
+{
+  if (bytes < pageSize) {
+    ::operator delete(pointer);
+  } else {
+    ::operator delete(static_cast<void**>(pointer)[-1]);
+  }
+}
+
+} // namespace
+
+namespace skelcl {
+
+namespace detail {
+
+SKELCL_DLL PinnedMemoryPool globalPinnedMemoryPool;
+
+PinnedMemoryPool::Chunk::Chunk()
+  : buffer(), queue(), pointer(nullptr), size(0)
+{
+}
+
+PinnedMemoryPool::PinnedMemoryPool()
+  : _mutex(), _enabled(util::envVarValue("SKELCL_PINNED") == "YES"),
+    _minAllocation(granularity), _pinnedChunks(0),
+    _maxCachedBytes(256 * 1024 * 1024),
+    _cachedBytes(0), _queue(), _used(), _free()
+{
+}
+
+PinnedMemoryPool::~PinnedMemoryPool()
+{
+}
+
+void PinnedMemoryPool::setEnabled(bool enabled)
+{
+  _enabled = enabled;
+}
+
+bool PinnedMemoryPool::isEnabled() const
+{
+  return _enabled;
+}
+
+void PinnedMemoryPool::setMinAllocation(size_t bytes)
+{
+  _minAllocation = bytes;
+}
+
+size_t PinnedMemoryPool::minAllocation() const
+{
+  return _minAllocation;
+}
+
+void PinnedMemoryPool::setMaxCachedBytes(size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _maxCachedBytes = bytes;
+}
+
+size_t PinnedMemoryPool::maxCachedBytes() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _maxCachedBytes;
+}
+
+void* PinnedMemoryPool::allocate(size_t bytes)
+{
+  // the common case of pageable memory does not take the lock
+  if (!_enabled || bytes < _minAllocation) {
+    return ::heapAllocate(bytes);
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (globalDeviceList.empty()) {
+    return ::heapAllocate(bytes);
+  }
+
+  auto size = ::roundUp(bytes);
+  Chunk chunk;
+  // reuse a released chunk, if it does not waste more than half of its size
+  auto iter = _free.lower_bound(size);
+  if (iter != _free.end() && iter->first / 2 <= size) {
+    chunk = iter->second;
+    _cachedBytes -= chunk.size;
+    _free.erase(iter);
+  } else {
+    try {
+      if (_queue() == nullptr) {
+        auto& device = *globalDeviceList.front();
+        _queue = cl::CommandQueue(device.clContext(), device.clDevice());
+      }
+      chunk.buffer  = cl::Buffer(_queue.getInfo<CL_QUEUE_CONTEXT>(),
+                                 CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR,
+                                 size);
+      chunk.pointer = _queue.enqueueMapBuffer(chunk.buffer, CL_TRUE,
+                                              CL_MAP_READ | CL_MAP_WRITE,
+                                              0, size);
+      chunk.queue   = _queue;
+      chunk.size    = size;
+    } catch (cl::Error& err) {
+      LOG_WARNING("Allocating ", size, " bytes of pinned memory failed (",
+                  err, "), using pageable memory instead");
+      return ::heapAllocate(bytes);
+    }
+    LOG_DEBUG_INFO("Allocated ", size, " bytes of pinned memory at ",
+                   chunk.pointer);
+  }
+
+  _used[chunk.pointer] = chunk;
+  ++_pinnedChunks;
+  return chunk.pointer;
+}
+
+void PinnedMemoryPool::deallocate(void* pointer, size_t bytes)
+{
+  if (pointer == nullptr) return;
+
+  // the pointer can only be pinned if any pinned chunk is in use
+  if (_pinnedChunks == 0) {
+    ::heapDeallocate(pointer, bytes);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto iter = _used.find(pointer);
+  if (iter == _used.end()) {
+    ::heapDeallocate(pointer, bytes);
+    return;
+  }
+
+  auto chunk = iter->second;
+  _used.erase(iter);
+  --_pinnedChunks;
+  // keep the chunk for reuse, unless it belongs to devices no longer in use
+  if (   chunk.queue() == _queue()
+      && _cachedBytes + chunk.size <= _maxCachedBytes) {
+    _cachedBytes += chunk.size;
+    _free.insert(std::make_pair(chunk.size, chunk));
+  } else {
+    release(chunk);
+  }
+}
+
+bool PinnedMemoryPool::isPinned(const void* pointer) const
+{
+  if (_pinnedChunks == 0) return false;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _used.find(const_cast<void*>(pointer)) != _used.end();
+}
+
+size_t PinnedMemoryPool::cachedBytes() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _cachedBytes;
+}
+
+void PinnedMemoryPool::clear()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (auto& entry : _free) {
+    release(entry.second);
+  }
+  _free.clear();
+  _cachedBytes = 0;
+  _queue = cl::CommandQueue();
+}
+
+void PinnedMemoryPool::release(const Chunk& chunk) const
+{
+  try {
+    chunk.queue.enqueueUnmapMemObject(chunk.buffer, chunk.pointer);
+    chunk.queue.finish();
+  } catch (cl::Error& err) {
+    LOG_ERROR("Releasing pinned memory failed (", err, ")");
+  }
+}
+
+} // namespace detail
+
+} // namespace skelcl
@@ -0,0 +1,318 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file Profiler.cpp
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define __CL_ENABLE_EXCEPTIONS
+#include <CL/cl.hpp>
+#undef  __CL_ENABLE_EXCEPTIONS
+
+#include <pvsutil/Logger.h>
+
+#include "SkelCL/detail/Profiler.h"
+
+#include "SkelCL/detail/Util.h"
+
+namespace {
+
+typedef skelcl::detail::Profiler Profiler;
+
+std::string escape(const std::string& str)
+{
+  std::string escaped;
+  for (auto c : str) {
+    if (static_cast<unsigned char>(c) < 0x20) {
+      // control characters are not allowed unescaped in JSON strings
+      char code[7];
+      std::snprintf(code, sizeof(code), "\\u%04x",
+                    static_cast<unsigned int>(c));
+      escaped += code;
+      continue;
+    }
+    if (c == '"' || c == '\\') escaped += '\\';
+    escaped += c;
+  }
+  return escaped;
+}
+
+// derives the skeleton from the name of the kernel it is implemented with
+std::string skeletonOf(const std::string& kernelName)
+{
+  static const std::pair<const char*, const char*> skeletons[] = {
+    { "SCL_MAPOVERLAP",          "MapOverlap" },
+    { "SCL_MAP",                 "Map" },
+    { "SCL_ZIP",                 "Zip" },
+    { "SCL_REDUCE",              "Reduce" },
+    { "SCL_SCAN",                "Scan" },
+    { "SCL_UNIFORM_COMBINATION", "Scan" },
+    { "SCL_ALLPAIRS",            "AllPairs" }
+  };
+  for (auto& skeleton : skeletons) {
+    if (kernelName.compare(0, std::string(skeleton.first).size(),
+                           skeleton.first) == 0) {
+      return skeleton.second;
+    }
+  }
+  return "unknown";
+}
+
+const char* nameOf(Profiler::Command command)
+{
+  switch (command) {
+    case Profiler::KERNEL: return "kernel";
+    case Profiler::WRITE:  return "write";
+    case Profiler::READ:   return "read";
+    case Profiler::COPY:   return "copy";
+  }
+  return "unknown";
+}
+
+// kernels and copies are executed on the compute queue of a device, reads
+// and writes on the transfer queue
+int queueOf(Profiler::Command command)
+{
+  return (command == Profiler::KERNEL || command == Profiler::COPY) ? 0 : 1;
+}
+
+} // namespace
+
+namespace skelcl {
+
+namespace detail {
+
+SKELCL_DLL Profiler globalProfiler;
+
+Profiler::Profiler()
+  : _mutex(), _enabled(false), _fileName(), _devices(), _records()
+{
+  auto value = util::envVarValue("SKELCL_PROFILE");
+  if (!value.empty() && value != "NO") {
+    enable(value == "YES" ? "skelcl_trace.json" : value);
+  }
+}
+
+Profiler::~Profiler()
+{
+}
+
+void Profiler::enable(const std::string& fileName)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _enabled  = true;
+  _fileName = fileName;
+}
+
+void Profiler::disable()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _enabled = false;
+  _records.clear();
+}
+
+bool Profiler::isEnabled() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _enabled;
+}
+
+std::string Profiler::fileName() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _fileName;
+}
+
+void Profiler::addDevice(size_t deviceId, const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _devices[deviceId] = name;
+}
+
+void Profiler::record(Command command, size_t deviceId,
+                      const cl::Event& event, const std::string& name,
+                      size_t bytes, const std::string& range)
+{
+  Record record = { command, deviceId, event, name, bytes, range,
+                    clock_type::now() };
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!_enabled) return;
+  _records.push_back(std::move(record));
+}
+
+size_t Profiler::size() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _records.size();
+}
+
+void Profiler::writeTrace(std::ostream& stream) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  struct Times {
+    cl_ulong queued;
+    cl_ulong submit;
+    cl_ulong start;
+    cl_ulong end;
+  };
+  std::vector<Times> times(_records.size());
+  std::vector<bool>  valid(_records.size(), false);
+  for (size_t i = 0; i < _records.size(); ++i) {
+    auto& event = _records[i].event;
+    try {
+      event.wait();
+      times[i].queued = event.getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>();
+      times[i].submit = event.getProfilingInfo<CL_PROFILING_COMMAND_SUBMIT>();
+      times[i].start  = event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+      times[i].end    = event.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+      valid[i] = true;
+    } catch (cl::Error& err) {
+      LOG_ERROR("Profiling information unavailable: ", err);
+    }
+  }
+
+  // the device timers are not synchronized with each other, therefore, the
+  // timestamps of every device are aligned to the host clock using the first
+  // command recorded for it
+  auto origin = clock_type::time_point::max();
+  for (auto& record : _records) {
+    origin = std::min(origin, record.enqueued);
+  }
+  std::map<size_t, double> offsets; // in microseconds
+  for (size_t i = 0; i < _records.size(); ++i) {
+    auto& record = _records[i];
+    if (!valid[i] || offsets.count(record.deviceId) != 0) continue;
+    auto enqueued = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      record.enqueued - origin).count();
+    offsets[record.deviceId] = (  static_cast<double>(enqueued)
+                                - static_cast<double>(times[i].queued))
+                               / 1000.0;
+  }
+  auto micros = [&](size_t deviceId, cl_ulong ns) {
+    return static_cast<double>(ns) / 1000.0 + offsets[deviceId];
+  };
+
+  stream << std::fixed << std::setprecision(3);
+  stream << "{\"traceEvents\":[";
+  bool first = true;
+  auto separate = [&]() {
+    if (!first) stream << ",";
+    stream << "\n";
+    first = false;
+  };
+
+  for (auto& device : _devices) {
+    separate();
+    stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":"
+           << device.first << ",\"args\":{\"name\":\"Device "
+           << device.first << " (" << ::escape(device.second) << ")\"}}";
+    for (int queue = 0; queue < 2; ++queue) {
+      separate();
+      stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":"
+             << device.first << ",\"tid\":" << queue
+             << ",\"args\":{\"name\":\""
+             << (queue == 0 ? "compute queue" : "transfer queue") << "\"}}";
+    }
+  }
+
+  for (size_t i = 0; i < _records.size(); ++i) {
+    if (!valid[i]) continue;
+    auto& record = _records[i];
+    auto& t      = times[i];
+    bool isKernel = (record.command == KERNEL);
+
+    separate();
+    stream << "{\"name\":\""
+           << (isKernel ? ::escape(record.name) : ::nameOf(record.command))
+           << "\",\"cat\":\"" << ::nameOf(record.command)
+           << "\",\"ph\":\"X\",\"pid\":" << record.deviceId
+           << ",\"tid\":" << ::queueOf(record.command)
+           << ",\"ts\":" << micros(record.deviceId, t.start)
+           << ",\"dur\":" << static_cast<double>(t.end - t.start) / 1000.0
+           << ",\"args\":{";
+    if (isKernel) {
+      stream << "\"skeleton\":\"" << ::skeletonOf(record.name)
+             << "\",\"kernel\":\"" << ::escape(record.name)
+             << "\",\"range\":\"" << ::escape(record.range) << "\",";
+    } else {
+      stream << "\"bytes\":" << record.bytes << ",";
+    }
+    stream << "\"queued\":" << micros(record.deviceId, t.queued)
+           << ",\"submit\":" << micros(record.deviceId, t.submit)
+           << ",\"queuedToStart\":"
+           << static_cast<double>(t.start - t.queued) / 1000.0
+           << "}}";
+  }
+  stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+void Profiler::writeTrace()
+{
+  if (!isEnabled()) return;
+
+  auto name = fileName();
+  std::ofstream file(name.c_str());
+  if (!file) {
+    LOG_ERROR("Could not write profiling trace to `", name, "'");
+    return;
+  }
+  writeTrace(file);
+  LOG_INFO("Profiling trace with ", size(), " commands written to `",
+           name, "'");
+  clear();
+}
+
+void Profiler::clear()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _records.clear();
+}
+
+} // namespace detail
+
+} // namespace skelcl
@@ -38,11 +38,17 @@
 ///
 
 #include <algorithm>
-#include <fstream>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
 #include <iterator>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #define __CL_ENABLE_EXCEPTIONS
 #include <CL/cl.hpp>
@@ -52,28 +58,30 @@
 
 #include <pvsutil/Assert.h>
 #include <pvsutil/Logger.h>
+#include <pvsutil/Timer.h>
 
 #include "SkelCL/detail/Program.h"
 
 #include "SkelCL/detail/Device.h"
 #include "SkelCL/detail/DeviceList.h"
+#include "SkelCL/detail/KernelCache.h"
+#include "SkelCL/detail/ProgramCache.h"
 #include "SkelCL/detail/Util.h"
 
 namespace {
 
-std::string binaryFilename(const std::string& hash,
-                           const std::shared_ptr<skelcl::detail::Device>&
-                                devicePtr)
+size_t maxVariantsFromEnvironment()
 {
-  std::stringstream filename;
-  // escape spaces in device name
-  std::string devName = devicePtr->name();
-  std::replace( devName.begin(), devName.end(), ' ', '_');
-  filename << "." << hash
-           << "-" << devName
-           << "-" << devicePtr->id()
-           << ".skelcl";
-  return filename.str();
+  auto value = skelcl::detail::util::envVarValue("SKELCL_SPECIALIZE");
+  if (value.empty() || value == "NO") return 0;
+  if (value == "YES") return 8;
+  return static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 10));
+}
+
+std::atomic<size_t>& maxVariantsSetting()
+{
+  static std::atomic<size_t> maxVariants(maxVariantsFromEnvironment());
+  return maxVariants;
 }
 
 } // namespace
@@ -82,11 +90,39 @@ namespace skelcl {
 
 namespace detail {
 
+Program::BuildTimings::BuildTimings()
+  : rewrite(0), create(0), build(0), saveBinary(0), builtDevices(0),
+    binaryCacheHit(false), sourceCacheHit(false)
+{
+}
+
+Program::Timings::Timings()
+  : mutex(), values()
+{
+}
+
+void Program::Timings::add(BuildTimings::time_type BuildTimings::* phase,
+                           BuildTimings::time_type time)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  values.*phase += time;
+}
+
 Program::Program(const std::string& source, const std::string& hash)
   : _source(source),
     _hash(hash),
-    _clPrograms()
+    _buildOptions(),
+    _clPrograms(),
+    _sourceAvailable(false),
+    _buildMutex(new std::mutex),
+    _builds(),
+    _kernels(std::make_shared<KernelCache>()),
+    _variants(),
+    _timings(std::make_shared<Timings>())
 {
+  // the transformations are collected and applied together in as few passes
+  // as possible, once the program is created from source
+  _source.beginBatch();
   LOG_DEBUG_INFO("Program instance created with source:\n", source,
                  "\n");
 }
@@ -94,7 +130,14 @@ Program::Program(const std::string& source, const std::string& hash)
 Program::Program(Program&& rhs)
   : _source(std::move(rhs._source)),
     _hash(std::move(rhs._hash)),
-    _clPrograms(std::move(rhs._clPrograms))
+    _buildOptions(std::move(rhs._buildOptions)),
+    _clPrograms(std::move(rhs._clPrograms)),
+    _sourceAvailable(rhs._sourceAvailable),
+    _buildMutex(std::move(rhs._buildMutex)),
+    _builds(std::move(rhs._builds)),
+    _kernels(std::move(rhs._kernels)),
+    _variants(std::move(rhs._variants)),
+    _timings(std::move(rhs._timings))
 {
 }
 
@@ -102,7 +145,14 @@ Program& Program::operator=(Program&& rhs)
 {
   _source      = std::move(rhs._source);
   _hash        = std::move(rhs._hash);
+  _buildOptions = std::move(rhs._buildOptions);
   _clPrograms  = std::move(rhs._clPrograms);
+  _sourceAvailable = rhs._sourceAvailable;
+  _buildMutex  = std::move(rhs._buildMutex);
+  _builds      = std::move(rhs._builds);
+  _kernels     = std::move(rhs._kernels);
+  _variants    = std::move(rhs._variants);
+  _timings     = std::move(rhs._timings);
   return *this;
 }
 
@@ -140,134 +190,350 @@ bool Program::loadBinary()
   // if hash is empty no binary is loaded (maybe be more gentle and just return)
   ASSERT(!_hash.empty());
 
+  _clPrograms.assign(globalDeviceList.size(), cl::Program());
+  if (!globalProgramCache.isEnabled()) return false;
+
+  // binaries are loaded per device, the devices without binary are built from
+  // source once the program is used on them
+  pvsutil::Timer timer;
+  size_t loaded = 0;
   for (auto& devicePtr : globalDeviceList) {
-    std::ifstream binaryFile(binaryFilename(_hash, devicePtr),
-                               std::ios_base::in
-                             | std::ios_base::binary
-                             | std::ios_base::ate);
-    if (binaryFile.fail()) {
-      _clPrograms.clear();
-      return false;
-    }
+    if (loadBinary(*devicePtr)) ++loaded;
+  }
+  _timings->add(&BuildTimings::create, timer.stop());
+
+  if (loaded < globalDeviceList.size()) return false;
+  {
+    std::lock_guard<std::mutex> lock(_timings->mutex);
+    _timings->values.binaryCacheHit = true;
+  }
+  return true;
+}
+
+bool Program::loadBinary(const Device& device)
+{
+  auto key = ProgramCache::binaryKey(_hash, device, _buildOptions);
+  std::string binary;
+  if (!globalProgramCache.load(key, &binary)) return false;
+
+  cl::Program::Binaries binaries(1, std::make_pair(binary.data(),
+                                                   binary.size()));
+  std::vector<cl::Device> devices{ device.clDevice() };
+  std::vector<cl_int> binaryStatus;
+  try {
+    _clPrograms[device.id()] = cl::Program( device.clContext(),
+                                            devices, binaries,
+                                            &binaryStatus );
+  } catch (cl::Error& err) {
+    // the binary is not usable (anymore), e.g. because it is corrupt
+    LOG_WARNING("Discard cached binary for device ", device.id(),
+                " (", err, ")");
+    globalProgramCache.remove(key);
+    return false;
+  }
+
+  LOG_DEBUG_INFO("Load binary for device ", device.id(),
+                 " from cache entry ", key);
+  return true;
+}
 
-    // get the size of the file
-		std::ifstream::pos_type size = binaryFile.tellg();
-		// allocate memory
-    std::unique_ptr<char[]> binary(new char[size]);
-		// set position in file to the beginning
-		binaryFile.seekg(0, std::ios::beg);
-		// read the hole file
-		binaryFile.read(binary.get(), size);
-		// close it
-		binaryFile.close();
-		// push the binary on the vector
-    cl::Program::Binaries binaries(1, std::make_pair(binary.get(), size));
-    std::vector<cl::Device> devices{ devicePtr->clDevice() };
-    _clPrograms.push_back( cl::Program( devicePtr->clContext(),
-                                        devices, binaries ) );
-
-    LOG_DEBUG_INFO("Load binary for device ", devicePtr->id(),
-                   " from file ", binaryFilename(_hash, devicePtr));
+bool Program::loadSource()
+{
+  ASSERT(!_hash.empty());
+
+  std::string source;
+  if (!globalProgramCache.loadSource(_hash, &source)) return false;
+
+  _source = stooling::SourceCode(source);
+  {
+    std::lock_guard<std::mutex> lock(_timings->mutex);
+    _timings->values.sourceCacheHit = true;
   }
-  ASSERT(_clPrograms.size() == globalDeviceList.size());
+  LOG_DEBUG_INFO("Load transformed source from cache");
   return true;
 }
 
 void Program::build()
 {
-  bool createdProgramsFromSource = false;
-  if (_clPrograms.empty()) {
-    createProgramsFromSource();
-    createdProgramsFromSource = true;
+  if (_clPrograms.size() != globalDeviceList.size()) { // no binaries loaded
+    _clPrograms.assign(globalDeviceList.size(), cl::Program());
+  }
+  _sourceAvailable = std::any_of(_clPrograms.begin(), _clPrograms.end(),
+                                 [](const cl::Program& program) {
+                                   return program() == nullptr;
+                                 });
+  if (_sourceAvailable) {
+    pvsutil::Timer timer;
+    _source.endBatch();
+    _timings->add(&BuildTimings::rewrite, timer.stop());
   }
+  // the programs are built lazily (see kernel)
+  _builds.assign(_clPrograms.size(), std::shared_future<void>());
+}
 
-  try {
-    // build program for each device
-    // TODO: how to build the program only for a subset of devices?
-    for (auto& devicePtr : globalDeviceList) {
-      _clPrograms[devicePtr->id()].build(
-            std::vector<cl::Device>(1, devicePtr->clDevice()) );
-    }
+bool Program::isBuilt() const
+{
+  std::lock_guard<std::mutex> lock(*_buildMutex);
+  return !_builds.empty()
+      && std::all_of(_builds.begin(), _builds.end(),
+            [](const std::shared_future<void>& build) {
+              return build.valid()
+                  && build.wait_for(std::chrono::seconds(0))
+                        == std::future_status::ready;
+            });
+}
 
-    if (createdProgramsFromSource) {
-      saveBinary();
+void Program::wait() const
+{
+  startBuilds();
+  for (auto& devicePtr : globalDeviceList) {
+    std::shared_future<void> build;
+    {
+      std::lock_guard<std::mutex> lock(*_buildMutex);
+      build = _builds[devicePtr->id()];
     }
+    waitForBuild(*devicePtr, build);
+  }
+}
 
-  } catch (cl::Error& err) {
-    if (err.err() == CL_BUILD_PROGRAM_FAILURE) {
-      auto& devicePtr = globalDeviceList.front();
-      auto  buildLog =
-        _clPrograms[
-          devicePtr->id()].getBuildInfo<CL_PROGRAM_BUILD_LOG>(
-                                           devicePtr->clDevice() );
-      LOG_ERROR(err, "\nBuild log:\n", buildLog);
-      abort();
-    } else {
-      ABORT_WITH_ERROR(err);
-    }
+void Program::startBuilds() const
+{
+  for (auto& devicePtr : globalDeviceList) {
+    startBuild(*devicePtr);
   }
 }
 
-cl::Kernel Program::kernel(const Device& device,
-                           const std::string& name) const
+std::shared_future<void> Program::buildHandle() const
 {
-  return cl::Kernel(_clPrograms[device.id()], name.c_str());
+  std::vector<std::shared_future<void>> builds;
+  for (auto& devicePtr : globalDeviceList) {
+    builds.push_back(startBuild(*devicePtr));
+  }
+  return std::async(std::launch::async, [builds]() {
+                      for (auto& build : builds) build.wait();
+                    }).share();
 }
 
-void Program::createProgramsFromSource()
+CachedKernel Program::kernel(const Device& device,
+                             const std::string& name) const
 {
-  // insert programs into _clPrograms
-  std::transform( globalDeviceList.begin(), globalDeviceList.end(),
-                  std::back_inserter(_clPrograms),
-      [this](DeviceList::const_reference devicePtr) -> cl::Program {
-        std::stringstream ss;
-        ss << "#define skelcl_get_device_id() " << devicePtr->id() << "\n";
+  waitForBuild(device, startBuild(device));
+  return _kernels->checkout(_clPrograms[device.id()], device.id(), name);
+}
 
-        std::string s(ss.str());
-        s.append(_source.code());
+CachedKernel Program::kernel(const Device& device,
+                             const std::string& name,
+                             const Constants& constants) const
+{
+  auto program = constants.empty() ? nullptr : variant(constants);
+  if (program == nullptr) {
+    return kernel(device, name);
+  }
+  return program->kernel(device, name);
+}
 
-        LOG_DEBUG_INFO("Create cl::Program for device ", devicePtr->id(),
-                       " with source:\n", s, "\n");
+void Program::setMaxVariants(size_t maxVariants)
+{
+  maxVariantsSetting() = maxVariants;
+}
 
-        return cl::Program(devicePtr->clContext(),
-                           cl::Program::Sources(1, std::make_pair(s.c_str(),
-                                                                  s.length()))
-                          );
-      });
+size_t Program::maxVariants()
+{
+  return maxVariantsSetting();
+}
 
+Program::BuildTimings Program::timings() const
+{
+  std::lock_guard<std::mutex> lock(_timings->mutex);
+  return _timings->values;
 }
 
-void Program::saveBinary()
+const std::string& Program::hash() const
 {
-  if (_hash.empty()) return;
-  // don't save binary, expect the user has explicitly requested so
-  if (util::envVarValue("SKELCL_SAVE_BINARY") != "YES") return;
+  return _hash;
+}
 
-  for (auto& devicePtr : globalDeviceList) {
-    try {
-      auto size   = _clPrograms[
-                      devicePtr->id()].getInfo<CL_PROGRAM_BINARY_SIZES>();
-      ASSERT(size.size() == 1);
+const Program* Program::variant(const Constants& constants) const
+{
+  if (maxVariants() == 0) return nullptr;
+
+  // the build options identify a variant, as they are part of the cache key,
+  // binaries of variants are cached separately as well
+  std::stringstream options;
+  for (auto& constant : constants) {
+    options << " -D " << constant.first << "=" << constant.second;
+  }
+
+  std::lock_guard<std::mutex> lock(*_buildMutex);
+  auto iter = _variants.find(options.str());
+  if (iter != _variants.end()) return iter->second.get();
+
+  if (_variants.size() >= maxVariants()) {
+    LOG_DEBUG_INFO("Maximum number of variants reached, use generic program"
+                   " instead of variant with", options.str());
+    return nullptr;
+  }
 
-      std::unique_ptr<char[]> charPtr(new char[size.front()]);
+  // a variant is created from the transformed source, which is not
+  // available if this program was loaded as binary and the source has not
+  // been cached
+  std::string source;
+  if (_sourceAvailable) {
+    source = _source.code();
+  } else if (_hash.empty() || !globalProgramCache.loadSource(_hash, &source)) {
+    LOG_DEBUG_INFO("Source not available, use generic program instead of"
+                   " variant with", options.str());
+    _variants[options.str()] = nullptr;
+    return nullptr;
+  }
+
+  LOG_DEBUG_INFO("Create variant with", options.str());
+  auto program = std::make_shared<Program>(source, _hash);
+  program->_buildOptions = _buildOptions + options.str();
+  if (!_hash.empty()) {
+    program->loadBinary();
+  }
+  program->build();
 
-      std::vector<char *> binary{ charPtr.get() };
+  _variants[options.str()] = program;
+  return program.get();
+}
 
-      _clPrograms[devicePtr->id()].getInfo(CL_PROGRAM_BINARIES, &binary);
+std::shared_future<void> Program::startBuild(const Device& device) const
+{
+  ASSERT_MESSAGE(_builds.size() == _clPrograms.size(),
+                 "Program::build() has not been called");
+
+  std::lock_guard<std::mutex> lock(*_buildMutex);
+  auto& build = _builds[device.id()];
+  if (build.valid()) return build;
+
+  LOG_DEBUG_INFO("Build program for device ", device.id());
+  // only the devices without cached binary are built from source
+  bool fromSource = false;
+  if (_clPrograms[device.id()]() == nullptr) {
+    _clPrograms[device.id()] = createProgramFromSource(device);
+    fromSource = true;
+  }
+  // the background task only works on copies of the (reference counted)
+  // OpenCL objects, as this object might be moved while it is running
+  auto clProgram    = _clPrograms[device.id()];
+  auto clDevice     = device.clDevice();
+  auto hash         = _hash;
+  auto buildOptions = _buildOptions;
+  auto source       = fromSource ? _source.code() : std::string();
+  auto timings      = _timings;
+  // the device has to stay alive while building, even if skelcl::terminate()
+  // clears the device list in the meantime
+  auto devicePtr    = globalDeviceList[device.id()];
+  ASSERT(devicePtr.get() == &device);
+
+  build = std::async(std::launch::async,
+    [=]() {
+      pvsutil::Timer timer;
+      clProgram.build(std::vector<cl::Device>(1, clDevice),
+                      buildOptions.c_str());
+      {
+        std::lock_guard<std::mutex> lock(timings->mutex);
+        timings->values.build += timer.stop();
+        ++timings->values.builtDevices;
+      }
+
+      if (fromSource && !hash.empty()) {
+        timer.restart();
+        // the source built successfully, so it is worth to be cached as well
+        globalProgramCache.storeSource(hash, source);
+        saveBinary(hash, buildOptions, *devicePtr, clProgram);
+        timings->add(&BuildTimings::saveBinary, timer.stop());
+      }
+    }).share();
+  return build;
+}
 
-      std::ofstream outfile(binaryFilename(_hash, devicePtr),
-                              std::ios_base::out
-                            | std::ios_base::trunc
-                            | std::ios_base::binary);
-      outfile.write(binary.front(), static_cast<long>(size.front()));
-      LOG_DEBUG_INFO("Saved binary for device ", devicePtr->id(),
-                     " to file ", binaryFilename(_hash, devicePtr));
-    } catch (cl::Error err) {
+void Program::waitForBuild(const Device& device,
+                           const std::shared_future<void>& build) const
+{
+  try {
+    build.get();
+  } catch (cl::Error& err) {
+    if (err.err() == CL_BUILD_PROGRAM_FAILURE) {
+      auto buildLog =
+        _clPrograms[device.id()].getBuildInfo<CL_PROGRAM_BUILD_LOG>(
+                                                      device.clDevice() );
+      LOG_ERROR(err, "\nBuild log:\n", buildLog);
+      abort();
+    } else {
       ABORT_WITH_ERROR(err);
     }
   }
 }
 
+cl::Program Program::createProgramFromSource(const Device& device) const
+{
+  ASSERT_MESSAGE(_sourceAvailable,
+                 "No source available to build the program from");
+
+  pvsutil::Timer timer;
+  std::stringstream ss;
+  ss << "#define skelcl_get_device_id() " << device.id() << "\n";
+
+  std::string s(ss.str());
+  s.append(_source.code());
+
+  LOG_DEBUG_INFO("Create cl::Program for device ", device.id(),
+                 " with source:\n", s, "\n");
+
+  cl::Program program;
+  try {
+    program = cl::Program(device.clContext(),
+                          cl::Program::Sources(1, std::make_pair(s.c_str(),
+                                                                 s.length())));
+  } catch (cl::Error& err) {
+    ABORT_WITH_ERROR(err);
+  }
+  _timings->add(&BuildTimings::create, timer.stop());
+  return program;
+}
+
+void Program::saveBinary(const std::string& hash,
+                         const std::string& buildOptions,
+                         const Device& device,
+                         const cl::Program& clProgram)
+{
+  if (hash.empty()) return;
+  if (!globalProgramCache.isEnabled()) return;
+
+  try {
+    // a program created in a context shared by multiple devices lists all of
+    // them, but is only built for the given device
+    auto devices = clProgram.getInfo<CL_PROGRAM_DEVICES>();
+    auto iter    = std::find_if(devices.begin(), devices.end(),
+                                [&device](const cl::Device& d) {
+                                  return d() == device.clDevice()();
+                                });
+    ASSERT(iter != devices.end());
+    auto index  = static_cast<size_t>(iter - devices.begin());
+    auto size   = clProgram.getInfo<CL_PROGRAM_BINARY_SIZES>();
+    ASSERT(size.size() == devices.size());
+
+    std::unique_ptr<char[]> charPtr(new char[size[index]]);
+
+    // binaries of the other devices are skipped
+    std::vector<char *> binary(devices.size(), nullptr);
+    binary[index] = charPtr.get();
+
+    clProgram.getInfo(CL_PROGRAM_BINARIES, &binary);
+
+    auto key = ProgramCache::binaryKey(hash, device, buildOptions);
+    globalProgramCache.store(key, std::string(binary[index],
+                                              size[index]));
+    LOG_DEBUG_INFO("Saved binary for device ", device.id(),
+                   " to cache entry ", key);
+  } catch (cl::Error& err) {
+    ABORT_WITH_ERROR(err);
+  }
+}
+
 } // namespace detail
 
 } // namespace skelcl
@@ -0,0 +1,488 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file ProgramCache.cpp
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#define __CL_ENABLE_EXCEPTIONS
+#include <CL/cl.hpp>
+#undef  __CL_ENABLE_EXCEPTIONS
+
+#include <pvsutil/Assert.h>
+#include <pvsutil/Logger.h>
+
+#include "SkelCL/detail/ProgramCache.h"
+
+#include "SkelCL/detail/Device.h"
+#include "SkelCL/detail/Util.h"
+
+namespace {
+
+// bump this whenever the layout of the stored artifacts changes
+const char* cacheFormatVersion = "skelcl-cache-v1";
+
+const size_t defaultMaxSizeInMB = 256;
+
+bool makeDirectory(const std::string& path)
+{
+#ifdef _WIN32
+  int result = _mkdir(path.c_str());
+#else
+  int result = mkdir(path.c_str(), 0755);
+#endif
+  return (result == 0 || errno == EEXIST);
+}
+
+// create the given directory and all missing parent directories
+bool makeDirectories(const std::string& path)
+{
+  for (size_t pos = path.find('/', 1); pos != std::string::npos;
+       pos = path.find('/', pos + 1)) {
+    if (!makeDirectory(path.substr(0, pos))) return false;
+  }
+  return makeDirectory(path);
+}
+
+bool fileExists(const std::string& path)
+{
+  struct stat info;
+  return stat(path.c_str(), &info) == 0;
+}
+
+int processId()
+{
+#ifdef _WIN32
+  return _getpid();
+#else
+  return static_cast<int>(getpid());
+#endif
+}
+
+// write data into a temporary file next to path and move it into place, so
+// that readers never see a partially written file
+bool writeAtomically(const std::string& path, const std::string& data)
+{
+  std::stringstream tmpPath;
+  tmpPath << path << ".tmp." << processId();
+  {
+    std::ofstream file(tmpPath.str(),   std::ios_base::out
+                                      | std::ios_base::trunc
+                                      | std::ios_base::binary);
+    if (file.fail()) return false;
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (file.fail()) {
+      file.close();
+      std::remove(tmpPath.str().c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmpPath.str().c_str(), path.c_str()) != 0) {
+    std::remove(tmpPath.str().c_str());
+    return false;
+  }
+  return true;
+}
+
+bool readFile(const std::string& path, std::string* data)
+{
+  std::ifstream file(path, std::ios_base::in | std::ios_base::binary);
+  if (file.fail()) return false;
+  data->assign(std::istreambuf_iterator<char>(file),
+               std::istreambuf_iterator<char>());
+  return !file.bad();
+}
+
+} // namespace
+
+namespace skelcl {
+
+namespace detail {
+
+SKELCL_DLL ProgramCache globalProgramCache;
+
+ProgramCache::ProgramCache()
+  : _mutex(),
+    _initialized(false),
+    _enabled(true),
+    _root(),
+    _maxSize(::defaultMaxSizeInMB * 1024 * 1024),
+    _indexModified(false),
+    _useCount(0),
+    _index(),
+    _sources()
+{
+}
+
+ProgramCache::~ProgramCache()
+{
+  // the logger might already be destroyed, therefore, don't log from here
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_enabled && _indexModified) {
+    writeIndex();
+  }
+}
+
+bool ProgramCache::isEnabled()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  initialize();
+  return _enabled;
+}
+
+void ProgramCache::setEnabled(bool enabled)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  initialize();
+  _enabled = enabled && !_root.empty();
+}
+
+std::string ProgramCache::root()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  initialize();
+  return _root;
+}
+
+void ProgramCache::setRoot(const std::string& root)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  initialize();
+  if (_indexModified) writeIndex();
+  _root = root;
+  _index.clear();
+  _enabled = !_root.empty() && ::makeDirectories(_root);
+  if (_enabled) readIndex();
+}
+
+size_t ProgramCache::maxSize()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  initialize();
+  return _maxSize;
+}
+
+void ProgramCache::setMaxSize(size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  initialize();
+  _maxSize = bytes;
+  if (_enabled) evict();
+}
+
+std::string ProgramCache::binaryKey(const std::string& hash,
+                                    const Device& device,
+                                    const std::string& options)
+{
+  std::stringstream s;
+  s << ::cacheFormatVersion << "\n" << hash << "\n";
+  try {
+    cl::Platform platform(device.clDevice().getInfo<CL_DEVICE_PLATFORM>());
+    s << platform.getInfo<CL_PLATFORM_NAME>()     << "\n"
+      << platform.getInfo<CL_PLATFORM_VERSION>()  << "\n"
+      << device.name()                            << "\n"
+      << device.vendorName()                      << "\n"
+      << device.clDevice().getInfo<CL_DEVICE_VERSION>() << "\n"
+      << device.driverVersion()                   << "\n";
+  } catch (cl::Error& err) {
+    ABORT_WITH_ERROR(err);
+  }
+  // the device id is compiled into the program (see skelcl_get_device_id)
+  s << device.id() << "\n" << options;
+  return util::hash(s.str());
+}
+
+std::string ProgramCache::sourceKey(const std::string& hash)
+{
+  return util::hash(std::string(::cacheFormatVersion) + "\nsource\n" + hash);
+}
+
+bool ProgramCache::loadSource(const std::string& hash, std::string* source)
+{
+  ASSERT(source != nullptr);
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto iter = _sources.find(hash);
+    if (iter != _sources.end()) {
+      *source = iter->second;
+      return true;
+    }
+  }
+
+  if (!load(sourceKey(hash), source)) return false;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _sources[hash] = *source;
+  return true;
+}
+
+void ProgramCache::storeSource(const std::string& hash,
+                               const std::string& source)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto iter = _sources.find(hash);
+    if (iter != _sources.end() && iter->second == source) return;
+    _sources[hash] = source;
+  }
+
+  store(sourceKey(hash), source);
+}
+
+bool ProgramCache::load(const std::string& key, std::string* data)
+{
+  ASSERT(data != nullptr);
+  std::lock_guard<std::mutex> lock(_mutex);
+  initialize();
+  if (!_enabled) return false;
+
+  if (!::readFile(path(key), data)) {
+    LOG_DEBUG_INFO("Cache miss for key ", key);
+    return false;
+  }
+
+  // the artifact might have been added by a different process
+  Entry& entry  = _index[key];
+  entry.size    = data->size();
+  entry.lastUse = ++_useCount;
+  _indexModified = true;
+
+  LOG_DEBUG_INFO("Cache hit for key ", key, " (", data->size(), " bytes)");
+  return true;
+}
+
+void ProgramCache::store(const std::string& key, const std::string& data)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  initialize();
+  if (!_enabled) return;
+
+  if (!::writeAtomically(path(key), data)) {
+    LOG_WARNING("Could not write artifact ", key, " to the cache at ", _root);
+    return;
+  }
+
+  // merge with updates made by other processes in the meantime
+  readIndex();
+  Entry& entry  = _index[key];
+  entry.size    = data.size();
+  entry.lastUse = ++_useCount;
+
+  evict();
+  writeIndex();
+
+  LOG_DEBUG_INFO("Stored artifact ", key, " (", data.size(),
+                 " bytes) in the cache");
+}
+
+void ProgramCache::remove(const std::string& key)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  initialize();
+  if (!_enabled) return;
+
+  std::remove(path(key).c_str());
+  // write the index right away, a later merge would restore the key otherwise
+  readIndex();
+  _index.erase(key);
+  writeIndex();
+}
+
+void ProgramCache::clear()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  initialize();
+  _sources.clear();
+  if (!_enabled) return;
+
+  readIndex();
+  for (auto& entry : _index) {
+    std::remove(path(entry.first).c_str());
+  }
+  _index.clear();
+  writeIndex();
+}
+
+void ProgramCache::flush()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_enabled && _indexModified) {
+    writeIndex();
+  }
+}
+
+void ProgramCache::initialize()
+{
+  if (_initialized) return;
+  _initialized = true;
+
+  if (util::envVarValue("SKELCL_CACHE") == "NO") {
+    _enabled = false;
+    return;
+  }
+
+  auto sizeInMB = util::envVarValue("SKELCL_CACHE_SIZE_MB");
+  if (!sizeInMB.empty()) {
+    _maxSize = static_cast<size_t>(std::strtoull(sizeInMB.c_str(), nullptr, 10))
+               * 1024 * 1024;
+  }
+
+  _root = util::envVarValue("SKELCL_CACHE_DIR");
+  if (_root.empty()) {
+    auto xdgCacheHome = util::envVarValue("XDG_CACHE_HOME");
+    auto home         = util::envVarValue("HOME");
+    if (!xdgCacheHome.empty()) {
+      _root = xdgCacheHome + "/skelcl";
+    } else if (!home.empty()) {
+      _root = home + "/.cache/skelcl";
+    }
+  }
+
+  if (_root.empty() || !::makeDirectories(_root)) {
+    LOG_WARNING("Could not create cache directory `", _root,
+                "'. Caching of programs is disabled.");
+    _enabled = false;
+    return;
+  }
+
+  readIndex();
+  LOG_DEBUG_INFO("Using program cache at `", _root, "' (", _index.size(),
+                 " entries)");
+}
+
+std::string ProgramCache::path(const std::string& key) const
+{
+  return _root + "/" + key + ".skelcl";
+}
+
+std::string ProgramCache::indexPath() const
+{
+  return _root + "/index";
+}
+
+void ProgramCache::readIndex()
+{
+  std::ifstream file(indexPath());
+  if (file.fail()) return;
+
+  std::string key;
+  Entry entry;
+  while (file >> key >> entry.size >> entry.lastUse) {
+    // continue counting after the uses recorded by other processes
+    _useCount = std::max(_useCount, entry.lastUse);
+    auto iter = _index.find(key);
+    if (iter == _index.end()) {
+      _index.insert(std::make_pair(key, entry));
+    } else {
+      iter->second.lastUse = std::max(iter->second.lastUse, entry.lastUse);
+    }
+  }
+
+  // drop the entries removed or evicted by other processes
+  for (auto iter = _index.begin(); iter != _index.end(); ) {
+    if (::fileExists(path(iter->first))) {
+      ++iter;
+    } else {
+      iter = _index.erase(iter);
+      _indexModified = true;
+    }
+  }
+}
+
+void ProgramCache::writeIndex()
+{
+  std::stringstream s;
+  for (auto& entry : _index) {
+    s << entry.first        << " "
+      << entry.second.size  << " "
+      << entry.second.lastUse << "\n";
+  }
+  if (::writeAtomically(indexPath(), s.str())) {
+    _indexModified = false;
+  }
+}
+
+void ProgramCache::evict()
+{
+  size_t totalSize = 0;
+  for (auto& entry : _index) {
+    totalSize += entry.second.size;
+  }
+  if (totalSize <= _maxSize) return;
+
+  // order entries from the least to the most recently used one
+  std::vector<std::pair<unsigned long long, std::string>> lru;
+  for (auto& entry : _index) {
+    lru.push_back(std::make_pair(entry.second.lastUse, entry.first));
+  }
+  std::sort(lru.begin(), lru.end());
+
+  for (auto& candidate : lru) {
+    if (totalSize <= _maxSize) break;
+    auto iter = _index.find(candidate.second);
+    totalSize -= iter->second.size;
+    std::remove(path(iter->first).c_str());
+    _index.erase(iter);
+    LOG_DEBUG_INFO("Evicted artifact ", candidate.second, " from the cache");
+  }
+  _indexModified = true;
+}
+
+} // namespace detail
+
+} // namespace skelcl
+
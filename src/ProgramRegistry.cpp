@@ -0,0 +1,213 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file ProgramRegistry.cpp
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <pvsutil/Logger.h>
+
+#include "SkelCL/detail/ProgramRegistry.h"
+
+#include "SkelCL/detail/Program.h"
+
+namespace skelcl {
+
+namespace detail {
+
+SKELCL_DLL ProgramRegistry globalProgramRegistry;
+
+ProgramRegistry::ProgramRegistry()
+  : _mutex(), _programs()
+{
+}
+
+ProgramRegistry::~ProgramRegistry()
+{
+}
+
+Program::ptr_type
+  ProgramRegistry::lookupOrCreate(const std::string& key,
+                                  const std::function<Program()>& create)
+{
+  std::promise<Program::ptr_type> promise;
+  std::shared_future<Program::ptr_type> registered;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto iter = _programs.find(key);
+    if (iter != _programs.end()) {
+      registered = iter->second;
+    } else {
+      _programs.insert(std::make_pair(key, promise.get_future().share()));
+    }
+  }
+
+  if (registered.valid()) {
+    LOG_DEBUG_INFO("Reuse registered program ", key);
+    // blocks if the program is still being built by another thread
+    return registered.get();
+  }
+
+  // create and build the program without holding the lock, so that
+  // different programs can be built concurrently
+  try {
+    auto program = std::make_shared<Program>(create());
+    promise.set_value(program);
+    LOG_DEBUG_INFO("Registered program ", key);
+    return program;
+  } catch (...) {
+    promise.set_exception(std::current_exception());
+    std::lock_guard<std::mutex> lock(_mutex);
+    _programs.erase(key);
+    throw;
+  }
+}
+
+void ProgramRegistry::startAll()
+{
+  std::vector<std::shared_future<Program::ptr_type>> programs;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& entry : _programs) {
+      programs.push_back(entry.second);
+    }
+  }
+
+  for (auto& program : programs) {
+    program.get()->startBuilds();
+  }
+}
+
+void ProgramRegistry::waitForAll()
+{
+  std::vector<std::shared_future<Program::ptr_type>> programs;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& entry : _programs) {
+      programs.push_back(entry.second);
+    }
+  }
+
+  for (auto& program : programs) {
+    program.get()->wait();
+  }
+}
+
+std::map<std::string, Program::BuildTimings> ProgramRegistry::timings()
+{
+  std::map<std::string, std::shared_future<Program::ptr_type>> programs;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    programs = _programs;
+  }
+
+  std::map<std::string, Program::BuildTimings> timings;
+  for (auto& entry : programs) {
+    // skip programs which are still being created (or failed to be created)
+    if (entry.second.wait_for(std::chrono::seconds(0))
+          != std::future_status::ready) continue;
+    try {
+      timings[entry.first] = entry.second.get()->timings();
+    } catch (...) {
+    }
+  }
+  return timings;
+}
+
+void ProgramRegistry::logTimings()
+{
+  auto all = timings();
+  Program::BuildTimings total;
+  size_t binaryCacheHits = 0;
+  size_t sourceCacheHits = 0;
+
+  std::stringstream summary;
+  summary << "Build timings of " << all.size() << " programs (in ms):\n";
+  for (auto& entry : all) {
+    auto& t = entry.second;
+    summary << "  " << entry.first.substr(0, 8)
+            << ": rewrite "   << t.rewrite
+            << ", create "    << t.create
+            << ", build "     << t.build
+            << " (" << t.builtDevices << " devices)"
+            << ", save "      << t.saveBinary
+            << ", binary cache " << (t.binaryCacheHit ? "hit" : "miss")
+            << ", source cache " << (t.sourceCacheHit ? "hit" : "miss")
+            << "\n";
+    total.rewrite       += t.rewrite;
+    total.create        += t.create;
+    total.build         += t.build;
+    total.saveBinary    += t.saveBinary;
+    total.builtDevices  += t.builtDevices;
+    binaryCacheHits     += t.binaryCacheHit ? 1 : 0;
+    sourceCacheHits     += t.sourceCacheHit ? 1 : 0;
+  }
+  summary << "  total: rewrite " << total.rewrite
+          << ", create "  << total.create
+          << ", build "   << total.build
+          << " (" << total.builtDevices << " devices)"
+          << ", save "    << total.saveBinary
+          << ", binary cache hits " << binaryCacheHits
+          << ", source cache hits " << sourceCacheHits;
+  LOG_INFO(summary.str());
+}
+
+size_t ProgramRegistry::size()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _programs.size();
+}
+
+void ProgramRegistry::clear()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _programs.clear();
+}
+
+} // namespace detail
+
+} // namespace skelcl
+
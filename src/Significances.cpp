@@ -83,6 +83,18 @@ Significances::Significances(std::initializer_list<value_type> significances)
 #endif
 }
 
+Significances::Significances(const std::vector<value_type>& significances)
+  : _values(significances)
+{
+#ifndef NDEBUG // in debug build only (to prevent unused variable warning)
+  const value_type zero     = 0.0;
+  const value_type one      = 1.0;
+  const value_type epsilon  = static_cast<value_type>(1.0e-10);
+  ASSERT(   std::accumulate( _values.cbegin(), _values.cend(), zero )
+          - one < epsilon );
+#endif
+}
+
 bool Significances::operator==(const Significances& rhs) const
 {
   return _values == rhs._values;
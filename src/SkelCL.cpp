@@ -43,7 +43,13 @@
 
 #include "SkelCL/detail/DeviceList.h"
 #include "SkelCL/detail/DeviceProperties.h"
+#include "SkelCL/detail/LoadBalancer.h"
+#include "SkelCL/detail/PinnedMemoryPool.h"
 #include "SkelCL/detail/PlatformID.h"
+#include "SkelCL/detail/Profiler.h"
+#include "SkelCL/detail/ProgramCache.h"
+#include "SkelCL/detail/ProgramRegistry.h"
+#include "SkelCL/detail/Util.h"
 #include "SkelCL/detail/DeviceID.h"
 
 namespace skelcl {
@@ -78,8 +84,56 @@ detail::DeviceID device(size_t dID)
   return detail::DeviceID(dID);
 }
 
+void startBuilds()
+{
+  detail::globalProgramRegistry.startAll();
+}
+
+void waitForBuilds()
+{
+  detail::globalProgramRegistry.waitForAll();
+}
+
+void setFlushPolicy(const detail::Device::FlushPolicy& policy)
+{
+  detail::Device::setDefaultFlushPolicy(policy);
+  for (auto& devicePtr : detail::globalDeviceList) {
+    devicePtr->setFlushPolicy(policy);
+  }
+}
+
+void flush()
+{
+  for (auto& devicePtr : detail::globalDeviceList) {
+    devicePtr->flush();
+  }
+}
+
+void usePinnedMemory(bool enable)
+{
+  detail::globalPinnedMemoryPool.setEnabled(enable);
+}
+
+void useZeroCopy(bool enable)
+{
+  detail::Device::setDefaultZeroCopy(enable);
+}
+
+void useAdaptiveBlocks(bool enable)
+{
+  detail::globalLoadBalancer.setEnabled(enable);
+}
+
 void terminate()
 {
+  if (detail::util::envVarValue("SKELCL_BUILD_TIMINGS") == "YES") {
+    detail::globalProgramRegistry.logTimings();
+  }
+  detail::globalProfiler.writeTrace();
+  detail::globalProgramRegistry.clear();
+  detail::globalLoadBalancer.save();
+  detail::globalProgramCache.flush();
+  detail::globalPinnedMemoryPool.clear();
   detail::globalDeviceList.clear();
   LOG_INFO("SkelCL terminating. Freeing all resources.");
 }
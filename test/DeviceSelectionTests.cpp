@@ -125,5 +125,16 @@ TEST_F(DeviceSelectionTest, SelectFirstDeviceOfFirstPlatform)
   }
 }
 
+TEST_F(DeviceSelectionTest, PartitionCPUs) {
+  if (cpuCount > 0) {
+    skelcl::init(allDevices().deviceType(device_type::CPU)
+                             .partitionEqually(1));
+    EXPECT_GE(skelcl::detail::globalDeviceList.size(), cpuCount);
+    for (auto& device : skelcl::detail::globalDeviceList) {
+      EXPECT_TRUE( device->isType(device_type::CPU) );
+    }
+  }
+}
+
 /// \endcond
 
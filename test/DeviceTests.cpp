@@ -35,7 +35,16 @@
 /// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
 ///
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <SkelCL/detail/Device.h>
+#include <SkelCL/detail/DeviceBuffer.h>
+#include <SkelCL/detail/PinnedMemoryPool.h>
 
 #include "Test.h"
 /// \cond
@@ -57,6 +66,18 @@ protected:
   ~DeviceTest() {
     // tear down
   }
+
+  // returns a kernel incrementing every element of its int buffer argument
+  cl::Kernel incKernel(const skelcl::detail::Device& device) {
+    std::string source("__kernel void inc(__global int* a) {"
+                       "  a[get_global_id(0)] += 1; }");
+    cl::Program program(device.clContext(),
+                        cl::Program::Sources(1,
+                          std::make_pair(source.c_str(), source.size())));
+    program.build(std::vector<cl::Device>(1, device.clDevice()));
+    return cl::Kernel(program, "inc");
+  }
+
   cl::Platform  _platform;
   cl::Device    _device;
 };
@@ -78,5 +99,209 @@ TEST_F(DeviceTest, CreateDevice) {
   // TODO: Test command queue
 }
 
+TEST_F(DeviceTest, TransfersAndKernelsAreOrdered) {
+  auto device = std::make_shared<skelcl::detail::Device>(_device, _platform, 0);
+
+  cl::Kernel kernel = incKernel(*device);
+
+  const size_t size = 1024;
+  skelcl::detail::DeviceBuffer buffer(device, size, sizeof(int));
+  std::vector<int> input(size, 41);
+  std::vector<int> output(size, 0);
+
+  // write, kernel and read are enqueued on different command queues and are
+  // only ordered by the events tracked for the buffer
+  kernel.setArg(0, buffer.clBuffer());
+  std::array<cl::Buffer, 1> buffers = {{ buffer.clBuffer() }};
+  device->enqueueWrite(buffer, input.begin());
+  device->enqueue(kernel, cl::NDRange(size), cl::NDRange(1), cl::NullRange,
+                  buffers);
+  device->enqueueRead(buffer, output.begin()).wait();
+
+  for (auto value : output) {
+    EXPECT_EQ(42, value);
+  }
+}
+
+TEST_F(DeviceTest, CallbacksAreInvokedAfterKernelsFinished) {
+  auto device = std::make_shared<skelcl::detail::Device>(_device, _platform, 0);
+
+  cl::Kernel kernel = incKernel(*device);
+
+  const size_t size = 1024;
+  const int launches = 100;
+  std::atomic<int> finished(0);
+  {
+    // the buffer is released before the kernels have finished
+    skelcl::detail::DeviceBuffer buffer(device, size, sizeof(int));
+    kernel.setArg(0, buffer.clBuffer());
+    std::array<cl::Buffer, 1> buffers = {{ buffer.clBuffer() }};
+    for (int i = 0; i < launches; ++i) {
+      device->enqueue(kernel, cl::NDRange(size), cl::NDRange(1),
+                      cl::NullRange, buffers, [&finished] () { ++finished; });
+    }
+  }
+  device->wait();
+
+  EXPECT_EQ(launches, finished.load());
+}
+
+TEST_F(DeviceTest, BatchedSubmission) {
+  auto device = std::make_shared<skelcl::detail::Device>(_device, _platform, 0);
+  device->setFlushPolicy(skelcl::detail::Device::FlushPolicy::onWait());
+  EXPECT_EQ(0u, device->flushPolicy().maxCommands);
+
+  const size_t size = 1024;
+  skelcl::detail::DeviceBuffer buffer(device, size, sizeof(int));
+  skelcl::detail::DeviceBuffer copy(device, size, sizeof(int));
+  std::vector<int> input(size, 42);
+  std::vector<int> output(size, 0);
+
+  // nothing is submitted before the copy, which depends on the write, and
+  // the read, which is waited for
+  device->enqueueWrite(buffer, input.begin());
+  device->enqueueCopy(buffer, copy);
+  device->enqueueRead(copy, output.begin()).wait();
+
+  EXPECT_EQ(input, output);
+}
+
+TEST_F(DeviceTest, OutOfOrderExecution) {
+  skelcl::detail::Device::setDefaultOutOfOrderExecution(true);
+  auto device = std::make_shared<skelcl::detail::Device>(_device, _platform, 0);
+  skelcl::detail::Device::setDefaultOutOfOrderExecution(false);
+
+  cl::Kernel first  = incKernel(*device);
+  cl::Kernel second = incKernel(*device);
+
+  const size_t size = 1024;
+  skelcl::detail::DeviceBuffer a(device, size, sizeof(int));
+  skelcl::detail::DeviceBuffer b(device, size, sizeof(int));
+  std::vector<int> input(size, 40);
+  std::vector<int> outputA(size, 0);
+  std::vector<int> outputB(size, 0);
+
+  // the commands on a and b are independent of each other, the commands on
+  // the same buffer are ordered by the tracked writer and reader events
+  first.setArg(0, a.clBuffer());
+  second.setArg(0, b.clBuffer());
+  std::array<cl::Buffer, 1> buffersA = {{ a.clBuffer() }};
+  std::array<cl::Buffer, 1> buffersB = {{ b.clBuffer() }};
+  device->enqueueWrite(a, input.begin());
+  device->enqueueWrite(b, input.begin());
+  device->enqueue(first, cl::NDRange(size), cl::NDRange(1), cl::NullRange,
+                  buffersA);
+  device->enqueue(second, cl::NDRange(size), cl::NDRange(1), cl::NullRange,
+                  buffersB);
+  device->enqueueRead(b, outputB.begin());
+  device->enqueue(first, cl::NDRange(size), cl::NDRange(1), cl::NullRange,
+                  buffersA);
+  device->enqueueRead(a, outputA.begin());
+  device->wait();
+
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_EQ(42, outputA[i]);
+    EXPECT_EQ(41, outputB[i]);
+  }
+}
+
+TEST_F(DeviceTest, ZeroCopyBuffer) {
+  auto zeroCopy = skelcl::detail::Device::defaultZeroCopy();
+  skelcl::detail::Device::setDefaultZeroCopy(true);
+  auto device = std::make_shared<skelcl::detail::Device>(_device, _platform, 0);
+  skelcl::detail::Device::setDefaultZeroCopy(zeroCopy);
+  EXPECT_EQ(device->isType(skelcl::detail::Device::CPU), device->zeroCopy());
+
+  cl::Kernel kernel = incKernel(*device);
+
+  // heap allocations of at least a page are page aligned
+  const size_t size = 1024;
+  auto host = static_cast<int*>(
+      skelcl::detail::globalPinnedMemoryPool.allocate(size * sizeof(int)));
+  std::fill(host, host + size, 41);
+
+  {
+    skelcl::detail::DeviceBuffer buffer(device, size, sizeof(int), host);
+    if (device->zeroCopy()) {
+      EXPECT_EQ(static_cast<void*>(host), buffer.hostPointer());
+    } else {
+      EXPECT_TRUE(buffer.hostPointer() == nullptr);
+    }
+
+    // for a zero copy buffer the write unmaps and the read maps the buffer
+    kernel.setArg(0, buffer.clBuffer());
+    std::array<cl::Buffer, 1> buffers = {{ buffer.clBuffer() }};
+    device->enqueueWrite(buffer, host);
+    device->enqueue(kernel, cl::NDRange(size), cl::NDRange(1), cl::NullRange,
+                    buffers);
+    device->enqueueRead(buffer, host).wait();
+
+    for (size_t i = 0; i < size; ++i) {
+      EXPECT_EQ(42, host[i]);
+    }
+
+    device->enqueueWrite(buffer, host).wait();
+  }
+  skelcl::detail::globalPinnedMemoryPool.deallocate(host, size * sizeof(int));
+}
+
+TEST_F(DeviceTest, BufferPoolReusesBuffers) {
+  if (!skelcl::detail::Device::defaultBufferPooling()) return;
+  auto device = std::make_shared<skelcl::detail::Device>(_device, _platform, 0);
+
+  const size_t size = 1000;
+  std::vector<int> input(size, 42);
+  std::vector<int> output(size, 0);
+
+  cl_mem released = nullptr;
+  {
+    skelcl::detail::DeviceBuffer buffer(device, size, sizeof(int));
+    device->enqueueWrite(buffer, input.begin());
+    released = buffer.clBuffer()();
+  }
+  EXPECT_EQ(skelcl::detail::BufferPool::sizeClass(size * sizeof(int)),
+            device->pooledBytes());
+
+  // a buffer of the same size class reuses the released one, its commands
+  // are ordered after the commands still using it
+  skelcl::detail::DeviceBuffer buffer(device, size - 10, sizeof(int));
+  EXPECT_EQ(released, buffer.clBuffer()());
+  EXPECT_EQ(0u, device->pooledBytes());
+  device->enqueueWrite(buffer, input.begin());
+  device->enqueueRead(buffer, output.begin()).wait();
+  for (size_t i = 0; i < size - 10; ++i) {
+    EXPECT_EQ(42, output[i]);
+  }
+
+  // buffers with other flags are not reused
+  skelcl::detail::DeviceBuffer readOnly(device, size, sizeof(int),
+                                        CL_MEM_READ_ONLY);
+  EXPECT_NE(released, readOnly.clBuffer()());
+
+  device->clearBufferPool();
+  EXPECT_EQ(0u, device->pooledBytes());
+}
+
+TEST_F(DeviceTest, BufferPoolSizeClasses) {
+  using skelcl::detail::BufferPool;
+  EXPECT_EQ(256u, BufferPool::sizeClass(1));
+  EXPECT_EQ(256u, BufferPool::sizeClass(256));
+  EXPECT_EQ(320u, BufferPool::sizeClass(257));
+  EXPECT_EQ(1024u, BufferPool::sizeClass(1000));
+  EXPECT_EQ(1280u, BufferPool::sizeClass(1025));
+  for (size_t bytes = 1; bytes < 1 << 20; bytes += 997) {
+    auto size = BufferPool::sizeClass(bytes);
+    EXPECT_GE(size, bytes);
+    EXPECT_LE(size, bytes + bytes / 4 + 256);
+  }
+
+  // the exact size is used, if the size class exceeds the maximal allocation
+  BufferPool pool(0);
+  pool.setMaxAllocation(3000);
+  EXPECT_EQ(1280u, pool.allocationSize(1025));
+  EXPECT_EQ(3000u, pool.allocationSize(3000));
+  EXPECT_EQ(2900u, pool.allocationSize(2900));
+}
+
 /// \endcond
 
@@ -35,10 +35,13 @@
 /// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
 ///
 
+#include <algorithm>
+
 #include <SkelCL/SkelCL.h>
 #include <SkelCL/Distributions.h>
 #include <SkelCL/IndexVector.h>
 #include <SkelCL/IndexMatrix.h>
+#include <SkelCL/Map.h>
 #include <SkelCL/Matrix.h>
 #include <SkelCL/Vector.h>
 
@@ -377,5 +380,121 @@ TEST_F(DistributionTest, CopyDistribution6)
   }
 }
 
+TEST_F(DistributionTest, CopyDistributionCombineOnDevices)
+{
+  skelcl::terminate();
+  skelcl::init(skelcl::allDevices());
+
+  skelcl::Vector<int> vi(100);
+  for (int i = 0; i < 100; ++i) {
+    vi[i] = i;
+  }
+  skelcl::distribution::setCopy(vi, "int add(int a, int b) { return a+b; }",
+                                "add");
+  auto copy = dynamic_cast<const skelcl::detail::CopyDistribution<
+                  skelcl::Vector<int>>*>(&vi.distribution());
+  ASSERT_TRUE(copy != nullptr);
+  EXPECT_TRUE(copy->combinesOnDevices());
+
+  vi.createDeviceBuffers();
+  vi.copyDataToDevices();
+  vi.dataOnDeviceModified();
+
+  // every device contributes its copy to the sum
+  vi.copyDataToHost();
+  int devices = static_cast<int>(skelcl::detail::globalDeviceList.size());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(i * devices, vi[i]);
+  }
+
+  // the copies on the devices are unchanged by the combination
+  vi.dataOnDeviceModified();
+  vi.copyDataToHost();
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(i * devices, vi[i]);
+  }
+}
+
+TEST_F(DistributionTest, RedistributeOnDevices)
+{
+  skelcl::Vector<int> vi(64);
+  for (int i = 0; i < 64; ++i) {
+    vi[i] = i;
+  }
+  skelcl::distribution::setBlock(vi);
+  vi.createDeviceBuffers();
+  vi.copyDataToDevices();
+  vi.dataOnDeviceModified();
+  // outdated host data must not be uploaded again
+  std::fill(vi.hostBuffer().begin(), vi.hostBuffer().end(), 0);
+
+  skelcl::distribution::setCopy(vi);
+  EXPECT_FALSE(vi.hostIsUpToDate());
+  skelcl::distribution::setSingle(vi);
+  EXPECT_FALSE(vi.hostIsUpToDate());
+
+  vi.copyDataToHost();
+  for (int i = 0; i < 64; ++i) {
+    EXPECT_EQ(i, vi[i]);
+  }
+}
+
+TEST_F(DistributionTest, RedistributeMatrixToOverlapOnDevices)
+{
+  skelcl::Matrix<int> mi({8, 4});
+  for (int i = 0; i < 32; ++i) {
+    mi.hostBuffer()[i] = i;
+  }
+  skelcl::distribution::setBlock(mi);
+  mi.createDeviceBuffers();
+  mi.copyDataToDevices();
+  mi.dataOnDeviceModified();
+  std::fill(mi.hostBuffer().begin(), mi.hostBuffer().end(), 0);
+
+  // the padding rows are copies of the first and the last row
+  skelcl::distribution::setOL(mi);
+  auto& devicePtr = skelcl::detail::globalDeviceList.front();
+  auto& buffer = mi.deviceBuffer(*devicePtr);
+  ASSERT_EQ(40, buffer.size());
+  std::vector<int> data(buffer.size());
+  devicePtr->enqueueRead(buffer, data.begin()).wait();
+  for (int i = 0; i < 40; ++i) {
+    int row = std::min(std::max(i / 4 - 1, 0), 7);
+    EXPECT_EQ(row * 4 + i % 4, data[i]);
+  }
+
+  skelcl::distribution::setBlock(mi);
+  mi.copyDataToHost();
+  for (int i = 0; i < 32; ++i) {
+    EXPECT_EQ(i, mi.hostBuffer()[i]);
+  }
+}
+
+TEST_F(DistributionTest, AdaptiveBlockDistribution)
+{
+  skelcl::Map<int(int)> inc("int func(int i) { return i + 1; }");
+
+  skelcl::Vector<int> vi(64);
+  for (int i = 0; i < 64; ++i) {
+    vi[i] = i;
+  }
+  skelcl::distribution::setAdaptiveBlock(vi);
+
+  // the significances may change between the calls
+  for (int n = 0; n < 3; ++n) {
+    vi = inc(vi);
+
+    auto block = dynamic_cast<const skelcl::detail::BlockDistribution<
+                    skelcl::Vector<int>>*>(&vi.distribution());
+    ASSERT_TRUE(block != nullptr);
+    EXPECT_TRUE(block->isAdaptive());
+  }
+
+  vi.copyDataToHost();
+  for (int i = 0; i < 64; ++i) {
+    EXPECT_EQ(i + 3, vi[i]);
+  }
+}
+
 /// \endcond
 
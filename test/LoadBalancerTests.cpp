@@ -0,0 +1,146 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+  
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#include <string>
+
+#include <pvsutil/Logger.h>
+
+#include <SkelCL/SkelCL.h>
+#include <SkelCL/detail/DeviceList.h>
+#include <SkelCL/detail/LoadBalancer.h>
+#include <SkelCL/detail/ProgramCache.h>
+#include <SkelCL/detail/Significances.h>
+
+#include "Test.h"
+/// \cond
+/// Don't show this test in doxygen
+
+class LoadBalancerTest : public ::testing::Test {
+protected:
+  LoadBalancerTest() : _root(skelcl::detail::globalProgramCache.root()) {
+    pvsutil::defaultLogger.setLoggingLevel(pvsutil::Logger::Severity::Debug);
+    skelcl::detail::globalProgramCache.setRoot("LoadBalancerTests.cache");
+    skelcl::detail::globalProgramCache.clear();
+    skelcl::detail::globalLoadBalancer.clear();
+    skelcl::useAdaptiveBlocks();
+    skelcl::init(skelcl::nDevices(2));
+  }
+
+  ~LoadBalancerTest() {
+    skelcl::terminate();
+    skelcl::useAdaptiveBlocks(false);
+    skelcl::detail::globalLoadBalancer.clear();
+    skelcl::detail::globalProgramCache.clear();
+    skelcl::detail::globalProgramCache.setRoot(_root);
+  }
+
+  // lets device 0 process three times as many elements per time as device 1
+  void measure(const std::string& key) {
+    auto& devices = skelcl::detail::globalDeviceList;
+    skelcl::detail::globalLoadBalancer.recordThroughput(key, devices,
+                                                        *devices[0], 3000,
+                                                        1000);
+    skelcl::detail::globalLoadBalancer.recordThroughput(key, devices,
+                                                        *devices[1], 1000,
+                                                        1000);
+  }
+
+  std::string _root;
+};
+
+TEST_F(LoadBalancerTest, EvenWithoutMeasurements) {
+  auto& devices = skelcl::detail::globalDeviceList;
+  auto s = skelcl::detail::globalLoadBalancer.significances("key", devices);
+
+  for (auto& devicePtr : devices) {
+    EXPECT_FLOAT_EQ(1.0f / devices.size(),
+                    s.getSignificance(devicePtr->id()));
+  }
+}
+
+TEST_F(LoadBalancerTest, ProportionalToThroughput) {
+  auto& devices = skelcl::detail::globalDeviceList;
+  if (devices.size() < 2) return; // needs two devices
+
+  measure("key");
+  auto s = skelcl::detail::globalLoadBalancer.significances("key", devices);
+
+  EXPECT_NEAR(0.75f, s.getSignificance(0), 1e-5f);
+  EXPECT_NEAR(0.25f, s.getSignificance(1), 1e-5f);
+}
+
+TEST_F(LoadBalancerTest, IgnoresSmallChanges) {
+  auto& devices = skelcl::detail::globalDeviceList;
+  if (devices.size() < 2) return; // needs two devices
+
+  auto& balancer = skelcl::detail::globalLoadBalancer;
+  measure("key");
+  balancer.significances("key", devices);
+
+  // the average throughput of device 0 becomes 3.15, i.e. a share of 0.759
+  balancer.recordThroughput("key", devices, *devices[0], 3300, 1000);
+  auto s = balancer.significances("key", devices);
+  EXPECT_NEAR(0.75f, s.getSignificance(0), 1e-5f);
+
+  // the average throughput of device 0 becomes 4.075, i.e. a share of 0.803
+  balancer.recordThroughput("key", devices, *devices[0], 5000, 1000);
+  s = balancer.significances("key", devices);
+  EXPECT_NEAR(4.075f / 5.075f, s.getSignificance(0), 1e-5f);
+  EXPECT_NEAR(1.0f / 5.075f, s.getSignificance(1), 1e-5f);
+}
+
+TEST_F(LoadBalancerTest, StoresSignificances) {
+  auto& devices = skelcl::detail::globalDeviceList;
+  if (devices.size() < 2) return; // needs two devices
+
+  auto& balancer = skelcl::detail::globalLoadBalancer;
+  measure("key");
+  balancer.significances("key", devices);
+  balancer.save();
+
+  // the learned significances are restored from the program cache
+  balancer.clear();
+  auto s = balancer.significances("key", devices);
+  EXPECT_NEAR(0.75f, s.getSignificance(0), 1e-5f);
+  EXPECT_NEAR(0.25f, s.getSignificance(1), 1e-5f);
+
+  // but not for another skeleton
+  s = balancer.significances("other", devices);
+  EXPECT_NEAR(0.5f, s.getSignificance(0), 1e-5f);
+}
+
+/// \endcond
@@ -45,6 +45,7 @@
 #include <SkelCL/Matrix.h>
 #include <SkelCL/Vector.h>
 #include <SkelCL/Map.h>
+#include <SkelCL/detail/Device.h>
 
 #include "Test.h"
 /// \cond
@@ -414,5 +415,31 @@ TEST_F(MapTest, MapDouble4) {
   }
 }
 
+TEST_F(MapTest, ZeroCopyInputDestroyedWhileRunning) {
+  auto zeroCopy = skelcl::detail::Device::defaultZeroCopy();
+  skelcl::terminate();
+  skelcl::detail::Device::setDefaultZeroCopy(true);
+  skelcl::init(skelcl::nDevices(1));
+
+  skelcl::Map<float(float)> m{ "float func(float f){ return -f; }" };
+  const size_t size = 1 << 20;
+  skelcl::Vector<float> output;
+  {
+    // the kernel may still read the host memory of the input, when the input
+    // is destroyed
+    skelcl::Vector<float> input(size, 2.5f);
+    output = m(input);
+  }
+  // reuse the memory freed by the input
+  skelcl::Vector<float> other(size, 1.0f);
+  EXPECT_EQ(1.0f, other[0]);
+
+  for (size_t i = 0; i < output.size(); ++i) {
+    EXPECT_EQ(-2.5f, output[i]);
+  }
+
+  skelcl::detail::Device::setDefaultZeroCopy(zeroCopy);
+}
+
 /// \endcond
 
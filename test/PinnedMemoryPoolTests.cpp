@@ -0,0 +1,93 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file PinnedMemoryPoolTests.cpp
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#include <pvsutil/Logger.h>
+
+#include <SkelCL/SkelCL.h>
+#include <SkelCL/Vector.h>
+#include <SkelCL/Map.h>
+#include <SkelCL/detail/PinnedMemoryPool.h>
+
+#include "Test.h"
+/// \cond
+/// Don't show this test in doxygen
+
+class PinnedMemoryPoolTest : public ::testing::Test {
+protected:
+  PinnedMemoryPoolTest() {
+    skelcl::init(skelcl::nDevices(1));
+    skelcl::detail::globalPinnedMemoryPool.setEnabled(true);
+  }
+
+  ~PinnedMemoryPoolTest() {
+    skelcl::detail::globalPinnedMemoryPool.setEnabled(false);
+    skelcl::terminate();
+  }
+};
+
+TEST_F(PinnedMemoryPoolTest, SmallVectorsArePageable) {
+  skelcl::Vector<float> input(16, 1.0f);
+  EXPECT_FALSE(skelcl::detail::globalPinnedMemoryPool.isPinned(&input.front()));
+}
+
+TEST_F(PinnedMemoryPoolTest, LargeVectorsArePinned) {
+  const size_t size = 1024 * 1024;
+  skelcl::Map<float(float)> m("float func(float f) { return -f; }");
+  {
+    skelcl::Vector<float> input(size, 1.0f);
+    EXPECT_TRUE(skelcl::detail::globalPinnedMemoryPool.isPinned(
+                  &input.front()));
+
+    skelcl::Vector<float> output = m(input);
+    EXPECT_EQ(-1.0f, output.front());
+    EXPECT_EQ(-1.0f, output.back());
+    EXPECT_TRUE(skelcl::detail::globalPinnedMemoryPool.isPinned(
+                  &output.front()));
+  }
+
+  // the chunks are kept for reuse
+  auto cached = skelcl::detail::globalPinnedMemoryPool.cachedBytes();
+  EXPECT_LE(2 * size * sizeof(float), cached);
+
+  skelcl::Vector<float> other(size, 2.0f);
+  EXPECT_TRUE(skelcl::detail::globalPinnedMemoryPool.isPinned(&other.front()));
+  EXPECT_GT(cached, skelcl::detail::globalPinnedMemoryPool.cachedBytes());
+}
+
+/// \endcond
@@ -0,0 +1,117 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+ 
+///
+/// \file ProfilerTests.cpp
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#include <pvsutil/Logger.h>
+
+#include <SkelCL/SkelCL.h>
+#include <SkelCL/Vector.h>
+#include <SkelCL/Map.h>
+#include <SkelCL/detail/Profiler.h>
+
+#include "Test.h"
+/// \cond
+/// Don't show this test in doxygen
+
+class ProfilerTest : public ::testing::Test {
+protected:
+  ProfilerTest() {
+    // the command queues have to be created with profiling enabled
+    skelcl::detail::globalProfiler.enable("ProfilerTests.json");
+    skelcl::init(skelcl::nDevices(1));
+  }
+
+  ~ProfilerTest() {
+    skelcl::terminate();
+    skelcl::detail::globalProfiler.disable();
+    std::remove("ProfilerTests.json");
+  }
+};
+
+TEST_F(ProfilerTest, RecordsSkeletonExecution) {
+  skelcl::Map<float(float)> m("float func(float f) { return -f; }");
+  skelcl::Vector<float> input(1024, 1.0f);
+
+  skelcl::Vector<float> output = m(input);
+  EXPECT_EQ(-1.0f, output[0]); // reads the result back to the host
+
+  // write of the input, the kernel, and the read of the output
+  EXPECT_LE(3u, skelcl::detail::globalProfiler.size());
+
+  std::stringstream trace;
+  skelcl::detail::globalProfiler.writeTrace(trace);
+  EXPECT_NE(std::string::npos, trace.str().find("\"traceEvents\""));
+  EXPECT_NE(std::string::npos, trace.str().find("\"skeleton\":\"Map\""));
+  EXPECT_NE(std::string::npos, trace.str().find("\"cat\":\"write\""));
+  EXPECT_NE(std::string::npos, trace.str().find("\"cat\":\"read\""));
+  EXPECT_NE(std::string::npos, trace.str().find("\"bytes\":4096"));
+}
+
+TEST_F(ProfilerTest, EscapesNames) {
+  skelcl::detail::globalProfiler.addDevice(99, "a \"b\"\\c\td\n");
+
+  std::stringstream trace;
+  skelcl::detail::globalProfiler.writeTrace(trace);
+  EXPECT_NE(std::string::npos,
+            trace.str().find("(a \\\"b\\\"\\\\c\\u0009d\\u000a)"));
+}
+
+TEST_F(ProfilerTest, WritesTraceFile) {
+  {
+    skelcl::Vector<float> input(16, 1.0f);
+    input.copyDataToDevices();
+  }
+  skelcl::terminate();
+
+  std::ifstream file("ProfilerTests.json");
+  ASSERT_TRUE(file.good());
+  std::string content((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+  EXPECT_NE(std::string::npos, content.find("\"process_name\""));
+  EXPECT_EQ(0u, skelcl::detail::globalProfiler.size());
+
+  skelcl::init(skelcl::nDevices(1)); // for the tear down
+}
+
+/// \endcond
@@ -0,0 +1,153 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+  
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#include <string>
+
+#include <pvsutil/Logger.h>
+
+#include <SkelCL/detail/ProgramCache.h>
+
+#include "Test.h"
+/// \cond
+/// Don't show this test in doxygen
+
+class ProgramCacheTest : public ::testing::Test {
+protected:
+  ProgramCacheTest() : _cache() {
+    pvsutil::defaultLogger.setLoggingLevel(pvsutil::Logger::Severity::Debug);
+    _cache.setRoot("ProgramCacheTests.cache");
+    _cache.clear();
+  }
+
+  ~ProgramCacheTest() {
+    _cache.clear();
+  }
+
+  skelcl::detail::ProgramCache _cache;
+};
+
+TEST_F(ProgramCacheTest, StoreAndLoad) {
+  ASSERT_TRUE(_cache.isEnabled());
+
+  std::string binary("\x7f" "ELF\0binary", 11);
+  _cache.store("key", binary);
+
+  std::string loaded;
+  EXPECT_TRUE(_cache.load("key", &loaded));
+  EXPECT_EQ(binary, loaded);
+}
+
+TEST_F(ProgramCacheTest, Miss) {
+  std::string loaded;
+  EXPECT_FALSE(_cache.load("unknown", &loaded));
+}
+
+TEST_F(ProgramCacheTest, Remove) {
+  _cache.store("key", "binary");
+  _cache.remove("key");
+
+  std::string loaded;
+  EXPECT_FALSE(_cache.load("key", &loaded));
+}
+
+TEST_F(ProgramCacheTest, RemovedEntriesAreNotRestored) {
+  _cache.setMaxSize(16);
+
+  _cache.store("b", "01234567");
+  _cache.store("a", "01234567");
+  _cache.remove("a");
+  // "a" must not count towards the size of the cache
+  _cache.store("c", "01234567");
+
+  std::string loaded;
+  EXPECT_TRUE(_cache.load("b", &loaded));
+  EXPECT_TRUE(_cache.load("c", &loaded));
+  EXPECT_FALSE(_cache.load("a", &loaded));
+}
+
+TEST_F(ProgramCacheTest, EntriesRemovedByOthersAreDropped) {
+  _cache.setMaxSize(16);
+
+  _cache.store("b", "01234567");
+  _cache.store("a", "01234567");
+  {
+    // e.g. another process
+    skelcl::detail::ProgramCache other;
+    other.setRoot("ProgramCacheTests.cache");
+    other.remove("a");
+  }
+  _cache.store("c", "01234567");
+
+  std::string loaded;
+  EXPECT_TRUE(_cache.load("b", &loaded));
+  EXPECT_TRUE(_cache.load("c", &loaded));
+}
+
+TEST_F(ProgramCacheTest, EvictLeastRecentlyUsed) {
+  _cache.setMaxSize(16);
+
+  _cache.store("a", "0123");
+  _cache.store("b", "0123");
+  std::string loaded;
+  EXPECT_TRUE(_cache.load("a", &loaded));
+
+  // "b" is the least recently used entry, although its key sorts after "a"
+  _cache.store("c", "0123456789");
+
+  EXPECT_TRUE(_cache.load("a", &loaded));
+  EXPECT_FALSE(_cache.load("b", &loaded));
+  EXPECT_TRUE(_cache.load("c", &loaded));
+}
+
+TEST_F(ProgramCacheTest, StoreAndLoadSource) {
+  _cache.storeSource("hash", "__kernel void SCL_MAP() {}");
+
+  std::string loaded;
+  EXPECT_TRUE(_cache.loadSource("hash", &loaded));
+  EXPECT_EQ("__kernel void SCL_MAP() {}", loaded);
+  EXPECT_FALSE(_cache.loadSource("unknown", &loaded));
+
+  // the source is persisted as well
+  skelcl::detail::ProgramCache other;
+  other.setRoot("ProgramCacheTests.cache");
+  loaded.clear();
+  EXPECT_TRUE(other.loadSource("hash", &loaded));
+  EXPECT_EQ("__kernel void SCL_MAP() {}", loaded);
+}
+
+/// \endcond
+
@@ -43,7 +43,10 @@
 
 #include <pvsutil/Logger.h>
 
+#include <SkelCL/SkelCL.h>
+#include <SkelCL/detail/DeviceList.h>
 #include <SkelCL/detail/Program.h>
+#include <SkelCL/detail/ProgramRegistry.h>
 #include <SkelCL/detail/Util.h>
 
 #include "Test.h"
@@ -85,6 +88,115 @@ __kernel void SCL_MAP(
   program.renameFunction("func", "SCL_FUNC");
   program.adjustTypes<int, char>();
   program.build();
+  program.wait();
+  EXPECT_TRUE(program.isBuilt());
+}
+
+TEST_F(ProgramTest, KernelsAreReused) {
+  skelcl::init(skelcl::nDevices(1));
+  {
+    skelcl::detail::Program program(
+        "__kernel void SCL_MAP(__global float* a) { a[0] = 1.0f; }");
+    program.build();
+
+    auto& device = *skelcl::detail::globalDeviceList.front();
+    cl_kernel first;
+    {
+      auto kernel = program.kernel(device, "SCL_MAP");
+      first = kernel();
+    }
+    {
+      // the kernel is checked in again and, therefore, reused ...
+      auto kernel = program.kernel(device, "SCL_MAP");
+      EXPECT_EQ(first, kernel());
+      // ... but never handed out twice at the same time
+      auto other  = program.kernel(device, "SCL_MAP");
+      EXPECT_NE(kernel(), other());
+    }
+  }
+  skelcl::terminate();
+}
+
+TEST_F(ProgramTest, TimingsAreRecorded) {
+  skelcl::init(skelcl::nDevices(1));
+  {
+    skelcl::detail::Program program(
+        "__kernel void SCL_MAP(__global float* a) { a[0] = 1.0f; }");
+    program.build();
+    EXPECT_EQ(0u, program.timings().builtDevices);
+
+    program.wait();
+    auto timings = program.timings();
+    EXPECT_EQ(1u, timings.builtDevices);
+    EXPECT_FALSE(timings.binaryCacheHit);
+    EXPECT_FALSE(timings.sourceCacheHit);
+  }
+  skelcl::terminate();
+}
+
+TEST_F(ProgramTest, BuildsStartInBackground) {
+  skelcl::init(skelcl::nDevices(1));
+  {
+    skelcl::detail::Program program(
+        "__kernel void SCL_MAP(__global float* a) { a[0] = 3.0f; }");
+    program.build();
+    program.startBuilds();
+
+    program.wait();
+    EXPECT_TRUE(program.isBuilt());
+    EXPECT_EQ(1u, program.timings().builtDevices);
+  }
+  skelcl::terminate();
+}
+
+TEST_F(ProgramTest, BinariesAreLoadedPerDevice) {
+  skelcl::init(skelcl::nDevices(1));
+  {
+    std::string source(
+        "__kernel void SCL_MAP(__global float* a) { a[0] = 2.0f; }");
+    std::string hash(skelcl::detail::util::hash(source));
+
+    // building from source stores the binary of the device it is built for
+    skelcl::detail::Program built(source, hash);
+    built.build();
+    built.wait();
+  }
+  {
+    std::string source(
+        "__kernel void SCL_MAP(__global float* a) { a[0] = 2.0f; }");
+    std::string hash(skelcl::detail::util::hash(source));
+
+    skelcl::detail::Program loaded(source, hash);
+    EXPECT_TRUE(loaded.loadBinary());
+    loaded.build();
+    loaded.wait();
+    EXPECT_TRUE(loaded.timings().binaryCacheHit);
+    EXPECT_TRUE(loaded.isBuilt());
+  }
+  skelcl::terminate();
+}
+
+TEST_F(ProgramTest, RegistrySharesPrograms) {
+  skelcl::detail::ProgramRegistry registry;
+  int created = 0;
+  auto create = [&] {
+    ++created;
+    return skelcl::detail::Program("float func(float f) { return f; }",
+                                   "hash");
+  };
+
+  auto first  = registry.lookupOrCreate("key", create);
+  auto second = registry.lookupOrCreate("key", create);
+  EXPECT_EQ(1, created);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(1u, registry.size());
+
+  auto third  = registry.lookupOrCreate("other", create);
+  EXPECT_EQ(2, created);
+  EXPECT_NE(first, third);
+
+  registry.clear();
+  EXPECT_EQ(0u, registry.size());
 }
 
 /// \endcond
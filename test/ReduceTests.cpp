@@ -45,6 +45,7 @@
 #include <SkelCL/Reduce.h>
 
 #include <SkelCL/detail/Device.h>
+#include <SkelCL/detail/Program.h>
 
 #include <iostream>
 
@@ -105,6 +106,24 @@ TEST_F(ReduceTest, AdditionalArg)
   EXPECT_EQ(4950, output[0]);
 }
 
+TEST_F(ReduceTest, RepeatedReduce)
+{
+  skelcl::Reduce<int(int)> r("int func(int x, int y){ return x+y; }");
+
+  // the intermediate buffer of the first call is reused by the later ones
+  for (int n = 1; n <= 3; ++n) {
+    skelcl::Vector<int> input(1000);
+    for (unsigned int i = 0; i < input.size(); ++i) {
+      input[i] = n;
+    }
+
+    skelcl::Vector<int> output = r(input);
+
+    EXPECT_LE(1, output.size());
+    EXPECT_EQ(1000 * n, output[0]);
+  }
+}
+
 TEST_F(ReduceTest, SimpleReduce2)
 {
   skelcl::Reduce<int(int)> r("int func(int x, int y){ return x+y; }");
@@ -120,6 +139,30 @@ TEST_F(ReduceTest, SimpleReduce2)
   EXPECT_EQ(1258491, output[0]);
 }
 
+TEST_F(ReduceTest, SpecializedReduce)
+{
+  auto maxVariants = skelcl::detail::Program::maxVariants();
+  skelcl::detail::Program::setMaxVariants(2);
+
+  skelcl::Reduce<int(int)> r("int func(int x, int y){ return x+y; }");
+
+  // both kernels are specialized for the first size, afterwards the maximum
+  // number of variants is reached and the generic kernels are used
+  for (unsigned int size : {100u, 1587u, 100u, 20000u}) {
+    skelcl::Vector<int> input(size);
+    for (unsigned int i = 0; i < input.size(); ++i) {
+      input[i] = i;
+    }
+
+    skelcl::Vector<int> output = r(input);
+
+    EXPECT_LE(1, output.size());
+    EXPECT_EQ(static_cast<int>(size * (size - 1) / 2), output[0]);
+  }
+
+  skelcl::detail::Program::setMaxVariants(maxVariants);
+}
+
 TEST_F(ReduceTest, LongReduce)
 {
   skelcl::Reduce<int(int)> r("int func(int x, int y){ return x+y; }");
@@ -87,6 +87,26 @@ TEST_F(ScanTest, SimpleScan) {
   }
 }
 
+TEST_F(ScanTest, RepeatedScan) {
+  skelcl::Scan<int(int)> s{ "int func(int x, int y){ return x+y; }" };
+
+  // the intermediate buffers are reused for inputs of the same size and
+  // recreated otherwise
+  for (size_t size : { 4096, 4096, 100, 4096 }) {
+    skelcl::Vector<int> input(size);
+    for (size_t i = 0; i < input.size(); ++i) {
+      input[i] = 1;
+    }
+
+    skelcl::Vector<int> output = s(input);
+
+    EXPECT_EQ(size, output.size());
+    for (size_t i = 0; i < output.size(); ++i) {
+      EXPECT_EQ(i, output[i]);
+    }
+  }
+}
+
 TEST_F(ScanTest, SmallScan) {
   skelcl::Scan<int(int)> s{ "int func(int x, int y){ return x+y; }" };
 
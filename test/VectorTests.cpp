@@ -125,6 +125,54 @@ TEST_F(VectorTest, CopyWithDataOnDevice) {
   }
 }
 
+TEST_F(VectorTest, HostViewWithDataOnDevice) {
+  skelcl::Vector<int> vi(8);
+  for (unsigned i = 0; i < 8; ++i) {
+    vi[i] = i;
+  }
+  vi.setDistribution(skelcl::detail::SingleDistribution< skelcl::Vector<int> >());
+  vi.createDeviceBuffers();
+  vi.copyDataToDevices();
+  vi.dataOnDeviceModified(); // fake modification on the device
+
+  {
+    auto view = vi.hostView(skelcl::HostAccess::READ_WRITE, 2, 3);
+    EXPECT_EQ(3, view.size());
+    for (unsigned i = 0; i < view.size(); ++i) {
+      EXPECT_EQ(i + 2, view[i]);
+      view[i] = 42;
+    }
+    // only the viewed range has been accessed
+    EXPECT_FALSE(vi.hostIsUpToDate());
+  }
+
+  EXPECT_FALSE(vi.hostIsUpToDate());
+  EXPECT_TRUE(vi.devicesAreUpToDate());
+  for (unsigned i = 0; i < 8; ++i) {
+    EXPECT_EQ((i >= 2 && i < 5) ? 42 : static_cast<int>(i), vi[i]);
+  }
+}
+
+TEST_F(VectorTest, HostViewWithDataOnHost) {
+  skelcl::Vector<int> vi(8);
+  for (unsigned i = 0; i < 8; ++i) {
+    vi[i] = i;
+  }
+  vi.setDistribution(skelcl::detail::SingleDistribution< skelcl::Vector<int> >());
+  vi.createDeviceBuffers();
+  vi.copyDataToDevices();
+
+  {
+    auto view = vi.hostView(skelcl::HostAccess::READ_WRITE);
+    EXPECT_EQ(8, view.size());
+    view[7] = 42;
+  }
+
+  EXPECT_TRUE(vi.hostIsUpToDate());
+  EXPECT_FALSE(vi.devicesAreUpToDate());
+  EXPECT_EQ(42, vi[7]);
+}
+
 TEST_F(VectorTest, CreateVector) {
   skelcl::Vector<int> vi(10);
 
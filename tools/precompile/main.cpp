@@ -0,0 +1,496 @@
+/*****************************************************************************
+ * Copyright (c) 2011-2012 The SkelCL Team as listed in CREDITS.txt          *
+ * http://skelcl.uni-muenster.de                                             *
+ *                                                                           *
+ * This file is part of SkelCL.                                              *
+ * SkelCL is available under multiple licenses.                              *
+ * The different licenses are subject to terms and condition as provided     *
+ * in the files specifying the license. See "LICENSE.txt" for details        *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * SkelCL is free software: you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version. See "LICENSE-gpl.txt" for details.    *
+ *                                                                           *
+ * SkelCL is distributed in the hope that it will be useful,                 *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the              *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * For non-commercial academic use see the license specified in the file     *
+ * "LICENSE-academic.txt".                                                   *
+ *                                                                           *
+ *****************************************************************************
+ *                                                                           *
+ * If you are interested in other licensing models, including a commercial-  *
+ * license, please contact the author at michel.steuwer@uni-muenster.de      *
+ *                                                                           *
+ *****************************************************************************/
+
+///
+/// \file main.cpp
+///
+/// \brief Offline precompilation of skeleton programs.
+///
+/// skelcl-precompile reads a manifest describing skeletons, creates every
+/// skeleton with the same constructor an application uses and builds its
+/// program for all selected devices. The transformed sources and the
+/// binaries are stored in a program cache directory, which can be shipped
+/// with the application and used by pointing SKELCL_CACHE_DIR to it. The
+/// application then loads the binaries instead of compiling the skeletons.
+///
+/// The manifest contains one skeleton per line. Empty lines and lines
+/// starting with # are ignored:
+///
+///   <kind> <source file> <function name> <types...> [<option>=<value>...]
+///
+/// kind            Map, Zip, Reduce, Scan, MapOverlap or AllPairs
+/// source file     File containing exactly the source code passed to the
+///                 skeleton. Relative paths are relative to the manifest.
+/// function name   Name of the user-defined function
+/// types           The element types in the order of the template
+///                 parameters: Map <in> <out>, Zip <left> <right> <out>,
+///                 Reduce <T>, Scan <T>, MapOverlap <in> <out>,
+///                 AllPairs <left> <right> <out>.
+///                 Supported are float, double, int and unsigned_int, as
+///                 well as void as output of Map and Zip, and Index and
+///                 IndexPoint as input of Map.
+/// options         identity=<id>      Reduce, Scan and AllPairs
+///                 range=<n>          MapOverlap (default: 1)
+///                 padding=<mode>     MapOverlap: NEAREST or NEUTRAL
+///                 neutral=<value>    MapOverlap (default: 0)
+///                 zip=<file>         AllPairs built from a Reduce (given by
+///                                    source file and function name) and
+///                                    the Zip in this file
+///                 zipFunction=<name> name of the zip function
+///
+/// The types of additional arguments do not need to be listed, as they are
+/// taken from the signature of the user-defined function.
+///
+/// \author Michel Steuwer <michel.steuwer@uni-muenster.de>
+///
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <pvsutil/CLArgParser.h>
+#include <pvsutil/Logger.h>
+
+#include <SkelCL/SkelCL.h>
+#include <SkelCL/IndexVector.h>
+#include <SkelCL/IndexMatrix.h>
+#include <SkelCL/AllPairs.h>
+#include <SkelCL/Map.h>
+#include <SkelCL/MapOverlap.h>
+#include <SkelCL/Reduce.h>
+#include <SkelCL/Scan.h>
+#include <SkelCL/Zip.h>
+#include <SkelCL/detail/ProgramCache.h>
+
+using namespace skelcl;
+
+namespace {
+
+struct Entry {
+  Entry()
+    : location(), kind(), source(), funcName(), types(), options()
+  {
+  }
+
+  std::string                         location;
+  std::string                         kind;
+  std::string                         source;
+  std::string                         funcName;
+  std::vector<std::string>            types;
+  std::map<std::string, std::string>  options;
+
+  std::string option(const std::string& name,
+                     const std::string& defaultValue) const
+  {
+    auto iter = options.find(name);
+    return (iter == options.end()) ? defaultValue : iter->second;
+  }
+};
+
+template <typename T>
+struct Type {
+  typedef T type;
+};
+
+std::string readFile(const std::string& fileName)
+{
+  std::ifstream file(fileName, std::ios_base::in | std::ios_base::binary);
+  if (file.fail()) {
+    LOG_ERROR("Could not read file `", fileName, "'");
+    exit(EXIT_FAILURE);
+  }
+  return std::string( (std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>() );
+}
+
+void fail(const Entry& entry, const std::string& message)
+{
+  LOG_ERROR(entry.location, ": ", message);
+  exit(EXIT_FAILURE);
+}
+
+// calls f with a Type<T> object for the element type named name
+template <typename F>
+void withElementType(const Entry& entry, const std::string& name, F f)
+{
+  if      (name == "float")         f(Type<float>());
+  else if (name == "double")        f(Type<double>());
+  else if (name == "int")           f(Type<int>());
+  else if (name == "unsigned_int")  f(Type<unsigned int>());
+  else fail(entry, "Unsupported element type `" + name + "'");
+}
+
+// as withElementType, but additionally accepts void
+template <typename F>
+void withOutputType(const Entry& entry, const std::string& name, F f)
+{
+  if (name == "void") f(Type<void>());
+  else withElementType(entry, name, f);
+}
+
+// ## Map ######################################################################
+template <typename Tin>
+struct CreateMap {
+  const Entry& entry;
+
+  template <typename Tout>
+  void operator()(Type<Tout>) const
+  {
+    Map<Tout(Tin)> map(entry.source, entry.funcName);
+  }
+};
+
+struct CreateMapInput {
+  const Entry& entry;
+
+  template <typename Tin>
+  void operator()(Type<Tin>) const
+  {
+    withOutputType(entry, entry.types[1], CreateMap<Tin>{entry});
+  }
+};
+
+struct CreateIndexMap {
+  const Entry& entry;
+
+  template <typename Tout>
+  void operator()(Type<Tout>) const
+  {
+    if (entry.types[0] == "Index") {
+      Map<Tout(Index)> map(entry.source, entry.funcName);
+    } else {
+      Map<Tout(IndexPoint)> map(entry.source, entry.funcName);
+    }
+  }
+};
+
+void createMap(const Entry& entry)
+{
+  if (entry.types.size() != 2) fail(entry, "Map requires two types");
+  if (entry.types[0] == "Index" || entry.types[0] == "IndexPoint") {
+    withOutputType(entry, entry.types[1], CreateIndexMap{entry});
+  } else {
+    withElementType(entry, entry.types[0], CreateMapInput{entry});
+  }
+}
+
+// ## Zip ######################################################################
+template <typename Tleft, typename Tright>
+struct CreateZip {
+  const Entry& entry;
+
+  template <typename Tout>
+  void operator()(Type<Tout>) const
+  {
+    Zip<Tout(Tleft, Tright)> zip(entry.source, entry.funcName);
+  }
+};
+
+template <typename Tleft>
+struct CreateZipRight {
+  const Entry& entry;
+
+  template <typename Tright>
+  void operator()(Type<Tright>) const
+  {
+    withOutputType(entry, entry.types[2], CreateZip<Tleft, Tright>{entry});
+  }
+};
+
+struct CreateZipLeft {
+  const Entry& entry;
+
+  template <typename Tleft>
+  void operator()(Type<Tleft>) const
+  {
+    withElementType(entry, entry.types[1], CreateZipRight<Tleft>{entry});
+  }
+};
+
+void createZip(const Entry& entry)
+{
+  if (entry.types.size() != 3) fail(entry, "Zip requires three types");
+  withElementType(entry, entry.types[0], CreateZipLeft{entry});
+}
+
+// ## Reduce and Scan ##########################################################
+struct CreateReduce {
+  const Entry& entry;
+
+  template <typename T>
+  void operator()(Type<T>) const
+  {
+    Reduce<T(T)> reduce(entry.source, entry.option("identity", "0"),
+                        entry.funcName);
+  }
+};
+
+struct CreateScan {
+  const Entry& entry;
+
+  template <typename T>
+  void operator()(Type<T>) const
+  {
+    Scan<T(T)> scan(entry.source, entry.option("identity", "0"),
+                    entry.funcName);
+  }
+};
+
+// ## MapOverlap ###############################################################
+template <typename Tin>
+struct CreateMapOverlap {
+  const Entry& entry;
+
+  template <typename Tout>
+  void operator()(Type<Tout>) const
+  {
+    auto padding = entry.option("padding", "NEAREST");
+    if (padding != "NEAREST" && padding != "NEUTRAL") {
+      fail(entry, "Unknown padding mode `" + padding + "'");
+    }
+
+    std::stringstream neutral(entry.option("neutral", "0"));
+    Tin neutralElement = Tin();
+    neutral >> neutralElement;
+
+    MapOverlap<Tout(Tin)> mapOverlap(
+        entry.source,
+        static_cast<unsigned int>(std::stoul(entry.option("range", "1"))),
+        (padding == "NEUTRAL") ? detail::Padding::NEUTRAL
+                               : detail::Padding::NEAREST,
+        neutralElement,
+        entry.funcName);
+  }
+};
+
+struct CreateMapOverlapInput {
+  const Entry& entry;
+
+  template <typename Tin>
+  void operator()(Type<Tin>) const
+  {
+    withElementType(entry, entry.types[1], CreateMapOverlap<Tin>{entry});
+  }
+};
+
+// ## AllPairs #################################################################
+template <typename Tleft, typename Tright>
+struct CreateAllPairs {
+  const Entry& entry;
+
+  template <typename Tout>
+  void operator()(Type<Tout>) const
+  {
+    auto zipFile = entry.option("zip", "");
+    if (zipFile.empty()) {
+      AllPairs<Tout(Tleft, Tright)> allpairs(entry.source, entry.funcName);
+    } else {
+      Reduce<Tout(Tout)> reduce(entry.source, entry.option("identity", "0"),
+                                entry.funcName);
+      Zip<Tout(Tleft, Tright)> zip(readFile(zipFile),
+                                   entry.option("zipFunction", "func"));
+      AllPairs<Tout(Tleft, Tright)> allpairs(reduce, zip);
+    }
+  }
+};
+
+template <typename Tleft>
+struct CreateAllPairsRight {
+  const Entry& entry;
+
+  template <typename Tright>
+  void operator()(Type<Tright>) const
+  {
+    withElementType(entry, entry.types[2],
+                    CreateAllPairs<Tleft, Tright>{entry});
+  }
+};
+
+struct CreateAllPairsLeft {
+  const Entry& entry;
+
+  template <typename Tleft>
+  void operator()(Type<Tleft>) const
+  {
+    withElementType(entry, entry.types[1], CreateAllPairsRight<Tleft>{entry});
+  }
+};
+
+// #############################################################################
+
+void create(const Entry& entry)
+{
+  LOG_INFO("Precompile ", entry.kind, " `", entry.funcName, "' (",
+           entry.location, ")");
+  if (entry.kind == "Map") {
+    createMap(entry);
+  } else if (entry.kind == "Zip") {
+    createZip(entry);
+  } else if (entry.kind == "Reduce" || entry.kind == "Scan") {
+    if (entry.types.size() != 1) fail(entry, entry.kind + " requires one type");
+    if (entry.kind == "Reduce") {
+      withElementType(entry, entry.types[0], CreateReduce{entry});
+    } else {
+      withElementType(entry, entry.types[0], CreateScan{entry});
+    }
+  } else if (entry.kind == "MapOverlap") {
+    if (entry.types.size() != 2) fail(entry, "MapOverlap requires two types");
+    withElementType(entry, entry.types[0], CreateMapOverlapInput{entry});
+  } else if (entry.kind == "AllPairs") {
+    if (entry.types.size() != 3) fail(entry, "AllPairs requires three types");
+    withElementType(entry, entry.types[0], CreateAllPairsLeft{entry});
+  } else {
+    fail(entry, "Unknown skeleton `" + entry.kind + "'");
+  }
+}
+
+std::string directoryOf(const std::string& fileName)
+{
+  auto pos = fileName.rfind('/');
+  return (pos == std::string::npos) ? std::string()
+                                    : fileName.substr(0, pos + 1);
+}
+
+std::vector<Entry> readManifest(const std::string& fileName)
+{
+  std::ifstream file(fileName);
+  if (file.fail()) {
+    LOG_ERROR("Could not read manifest `", fileName, "'");
+    exit(EXIT_FAILURE);
+  }
+  auto directory = directoryOf(fileName);
+
+  std::vector<Entry> entries;
+  std::string line;
+  for (unsigned int lineNumber = 1; std::getline(file, line); ++lineNumber) {
+    std::stringstream words(line);
+    Entry entry;
+    entry.location = fileName + ":" + std::to_string(lineNumber);
+
+    std::string sourceFile;
+    if (!(words >> entry.kind) || entry.kind[0] == '#') continue;
+    if (!(words >> sourceFile >> entry.funcName)) {
+      fail(entry, "Expected <kind> <source file> <function name> <types...>");
+    }
+
+    std::string word;
+    while (words >> word) {
+      auto pos = word.find('=');
+      if (pos == std::string::npos) {
+        entry.types.push_back(word);
+      } else {
+        entry.options[word.substr(0, pos)] = word.substr(pos + 1);
+      }
+    }
+
+    auto relativeTo = [&](const std::string& path) {
+      return (path.empty() || path[0] == '/') ? path : directory + path;
+    };
+    entry.source = readFile(relativeTo(sourceFile));
+    if (entry.options.count("zip")) {
+      entry.options["zip"] = relativeTo(entry.options["zip"]);
+    }
+    entries.push_back(entry);
+  }
+  return entries;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  using namespace pvsutil::cmdline;
+  pvsutil::CLArgParser cmd(Description("Precompiles skeleton programs into a "
+                                       "program cache directory."));
+
+  auto manifest = Arg<std::string>(Flags(Short('m'), Long("manifest")),
+                                   Description("Manifest listing the "
+                                               "skeletons to precompile."),
+                                   Default(std::string("skeletons.manifest")));
+
+  auto output = Arg<std::string>(Flags(Short('o'), Long("output")),
+                                 Description("Cache directory to store the "
+                                             "programs in."),
+                                 Default(std::string("skelcl-cache")));
+
+  auto deviceCount = Arg<int>(Flags(Long("device_count")),
+                              Description("Number of devices used by SkelCL. "
+                                          "Has to match the application."),
+                              Default(1));
+
+  auto deviceType = Arg<device_type>(Flags(Long("device_type")),
+                                     Description("Device type: ANY, CPU, "
+                                                 "GPU, ACCELERATOR"),
+                                     Default(device_type::ANY));
+
+  auto enableLogging = Arg<bool>(Flags(Short('l'), Long("logging"),
+                                       Long("verbose_logging")),
+                                 Description("Enable verbose logging."),
+                                 Default(false));
+
+  cmd.add(&manifest, &output, &deviceCount, &deviceType, &enableLogging);
+  cmd.parse(argc, argv);
+
+  if (enableLogging) {
+    pvsutil::defaultLogger.setLoggingLevel(
+        pvsutil::Logger::Severity::DebugInfo);
+  }
+
+  auto entries = readManifest(manifest);
+
+  // the bundle has to contain every program, therefore, nothing is evicted
+  auto& cache = detail::globalProgramCache;
+  cache.setRoot(output);
+  if (!cache.isEnabled()) {
+    LOG_ERROR("Could not use `", std::string(output), "' as cache directory");
+    return EXIT_FAILURE;
+  }
+  cache.setMaxSize(std::numeric_limits<size_t>::max());
+
+  skelcl::init(skelcl::nDevices(deviceCount).deviceType(deviceType));
+
+  for (auto& entry : entries) {
+    create(entry);
+  }
+  skelcl::waitForBuilds();
+
+  LOG_INFO("Precompiled ", entries.size(), " skeletons into `",
+           std::string(output), "'");
+  skelcl::terminate();
+  return EXIT_SUCCESS;
+}